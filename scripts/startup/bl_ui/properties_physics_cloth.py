@@ -64,6 +64,41 @@ class PHYSICS_PT_cloth(PhysicButtonsPanel, Panel):
         col.prop(cloth, "time_scale", text="Speed Multiplier")
 
 
+class PHYSICS_PT_cloth_adaptive_steps(PhysicButtonsPanel, Panel):
+    bl_label = "Adaptive Steps"
+    bl_parent_id = "PHYSICS_PT_cloth"
+    bl_options = {'DEFAULT_CLOSED'}
+    COMPAT_ENGINES = {
+        'BLENDER_RENDER',
+        'BLENDER_EEVEE',
+        'BLENDER_EEVEE_NEXT',
+        'BLENDER_WORKBENCH',
+    }
+
+    def draw_header(self, context):
+        cloth = context.cloth.settings
+
+        self.layout.active = cloth_panel_enabled(context.cloth)
+        self.layout.prop(cloth, "use_adaptive_steps", text="")
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+
+        cloth = context.cloth.settings
+        md = context.cloth
+
+        layout.active = cloth.use_adaptive_steps and cloth_panel_enabled(md)
+
+        flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=True)
+
+        col = flow.column(align=True)
+        col.prop(cloth, "adaptive_steps_min", text="Steps Min")
+        col.prop(cloth, "adaptive_steps_max", text="Max")
+        col = flow.column()
+        col.prop(cloth, "adaptive_cfl")
+
+
 class PHYSICS_PT_cloth_physical_properties(PhysicButtonsPanel, Panel):
     bl_label = "Physical Properties"
     bl_parent_id = "PHYSICS_PT_cloth"
@@ -517,6 +552,7 @@ class PHYSICS_PT_cloth_field_weights(PhysicButtonsPanel, Panel):
 classes = (
     CLOTH_PT_presets,
     PHYSICS_PT_cloth,
+    PHYSICS_PT_cloth_adaptive_steps,
     PHYSICS_PT_cloth_physical_properties,
     PHYSICS_PT_cloth_stiffness,
     PHYSICS_PT_cloth_damping,
@@ -190,10 +190,13 @@ def point_cache_ui(self, cache, enabled, cachetype):
             subcol = col.column()
             subcol.active = cache.use_disk_cache
             subcol.prop(cache, "use_library_path", text="Use Library Path")
+            subcol.prop(cache, "use_disk_container")
 
             col = flow.column()
             col.active = cache.use_disk_cache
             col.prop(cache, "compression", text="Compression")
+            if cache.compression == 'ZSTD':
+                col.prop(cache, "compression_tolerance", text="Tolerance")
 
             if cache.id_data.library and not cache.use_disk_cache:
                 can_bake = False
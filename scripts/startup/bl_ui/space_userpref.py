@@ -2560,6 +2560,8 @@ class USERPREF_PT_experimental_prototypes(ExperimentalPanel, Panel):
                 ({"property": "use_grease_pencil_version3"}, ("blender/blender/projects/6", "Grease Pencil 3.0")),
                 ({"property": "enable_overlay_next"}, ("blender/blender/issues/102179", "#102179")),
                 ({"property": "use_extension_repos"}, ("/blender/blender/issues/106254", "#106254")),
+                ({"property": "use_blend_delta_save"}, None),
+                ({"property": "use_deferred_hidden_modifiers"}, None),
             ),
         )
 
@@ -7,13 +7,17 @@
  * \ingroup bke
  */
 
+#include "BLI_array.hh"
 #include "BLI_math_vector_types.hh"
 #include "BLI_ordered_edge.hh"
 #include "BLI_set.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
 
 #include <float.h>
 
 struct BVHTree;
+struct ClothSpring;
 struct ClothVertex;
 struct ClothModifierData;
 struct CollisionModifierData;
@@ -55,6 +59,24 @@ struct ClothSolverResult {
   int max_iterations, min_iterations;
   float avg_iterations;
   float max_error, min_error, avg_error;
+
+  /* Cloth and collider pairs of the object collision broad phase, summed over substeps. */
+  int collision_pairs, collision_pairs_culled;
+};
+
+/**
+ * Packed copy of the spring data read by the force loop, one array per field and sorted by the
+ * first vertex of each spring, so that the solver walks memory in order instead of following
+ * #Cloth.springs. The linked list stays the authoritative spring data; the layout is built when
+ * the solver is created and the per frame values are refreshed at the start of each solve.
+ */
+struct ClothSpringArrays {
+  blender::Array<ClothSpring *> springs; /* Source spring, for the data of bending and hair. */
+  blender::Array<blender::int2> verts;   /* `ij` and `kl` of the spring. */
+  blender::Array<int> types;
+  blender::Array<float> restlen;
+  blender::Array<float> lin_stiffness;
+  blender::Array<bool> active; /* Not deactivated by #CLOTH_SPRING_FLAG_DEACTIVATE. */
 };
 
 /**
@@ -85,6 +107,16 @@ struct Cloth {
   float average_acceleration[3]; /* Moving average of overall acceleration. */
   const blender::int2 *edges;    /* Used for hair collisions. */
   blender::Set<blender::OrderedEdge> sew_edge_graph; /* Sewing edges. */
+
+  /* Adaptive time stepping, sizes are relative to the simulated time of a solve. */
+  float adaptive_dt;                    /* Size of the next step, zero when unknown. */
+  blender::Vector<float> adaptive_steps; /* Sizes of the steps of the last solved frame. */
+
+  ClothSpringArrays spring_arrays; /* Solver layout of #springs. */
+
+  /* Co-simulation with the other objects of a group, see #cloth_group_step. */
+  int group_frame;         /* Frame the group stepped this cloth to. */
+  bool is_group_collider; /* Collision modifier holds the positions of the current step. */
 };
 
 /**
@@ -213,8 +245,33 @@ struct ColliderContacts {
 };
 
 /* needed for implicit.c */
-int cloth_bvh_collision(
-    Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt);
+/**
+ * \param move_colliders: Move the colliders to the current step, false when
+ * #cloth_group_colliders_move already did.
+ */
+int cloth_bvh_collision(Depsgraph *depsgraph,
+                        Object *ob,
+                        ClothModifierData *clmd,
+                        float step,
+                        float dt,
+                        bool move_colliders);
+
+/**
+ * Set the collision modifier of a cloth stepped by #cloth_group_step to the motion of the cloth
+ * over the current step, so the other objects of the group collide with it.
+ */
+void cloth_group_collider_update(Object *ob, ClothModifierData *clmd);
+/** Restore regular collider behavior after the last step of the group. */
+void cloth_group_collider_update_end(Object *ob, ClothModifierData *clmd);
+/**
+ * Move the colliders of the cloth \a objects which are not stepped along with them to the
+ * current step, once for all objects of the group. Relative \a step and \a dt as in
+ * #cloth_bvh_collision.
+ */
+void cloth_group_colliders_move(Depsgraph *depsgraph,
+                                blender::Span<Object *> objects,
+                                float step,
+                                float dt);
 
 /* -------------------------------------------------------------------- */
 /* cloth.cc */
@@ -233,6 +290,18 @@ void clothModifier_do(ClothModifierData *clmd,
 
 int cloth_uses_vgroup(ClothModifierData *clmd);
 
+/**
+ * Whether the cloth of the object can be stepped by #cloth_group_step: the cloth modifier has to
+ * be first in the stack, so the object's mesh is its input, and the object has to be a collider.
+ */
+bool cloth_group_object_supported(Object *ob);
+/**
+ * Step the cloth of objects which collide with each other together, in lock-step: every step
+ * advances all objects, then collisions are resolved against the other objects at the same step.
+ * The cloth modifiers use the result instead of simulating the frame on their own.
+ */
+void cloth_group_step(Depsgraph *depsgraph, Scene *scene, blender::Span<Object *> objects);
+
 /* Needed for collision.cc */
 void bvhtree_update_from_cloth(ClothModifierData *clmd, bool moving, bool self);
 
@@ -112,6 +112,12 @@ void collision_move_object(struct CollisionModifierData *collmd,
                            float prevstep,
                            bool moving_bvh);
 
+/**
+ * Tag the positions of the collider as changed, so cached collider states are not reused. Every
+ * update gets a new stamp, so a freed and re-allocated modifier never matches a stale state.
+ */
+void BKE_collision_update_tag(struct CollisionModifierData *collmd);
+
 void collision_get_collider_velocity(float vel_old[3],
                                      float vel_new[3],
                                      struct CollisionModifierData *collmd,
@@ -162,6 +168,44 @@ struct ListBase *BKE_collider_cache_create(struct Depsgraph *depsgraph,
                                            struct Collection *collection);
 void BKE_collider_cache_free(struct ListBase **colliders);
 
+/* Persistent collider state, kept by the dependency graph next to the collision relations. */
+
+struct ColliderStateCache;
+
+/**
+ * Create the state of the colliders, owned by the dependency graph and kept until its relations
+ * are rebuilt. There is one state per collider object, shared by all collision collections: the
+ * collider positions and BVH exist once per object as well.
+ */
+struct ColliderStateCache *BKE_collider_state_cache_create(void);
+/** Add a state for each collider in the \a relations that has none yet. */
+void BKE_collider_state_cache_add(struct ColliderStateCache *cache, struct ListBase *relations);
+void BKE_collider_state_cache_free(struct ColliderStateCache *cache);
+
+/**
+ * Same as #collision_move_object, but the interpolation and BVH refit are skipped when the
+ * collider already is at the given step of the current frame. That is the case when several
+ * simulations collide with the same objects, or when the collider has not moved since the last
+ * step. Safe to call from multiple threads, as long as they move the collider to the same step.
+ */
+void BKE_collider_move(struct Depsgraph *depsgraph,
+                       struct Object *ob,
+                       struct CollisionModifierData *collmd,
+                       float step,
+                       float prevstep,
+                       bool moving_bvh);
+
+/**
+ * Bounding box containing the collider BVH at any step of the current frame, for broad-phase
+ * culling. It is cached until the collider positions change.
+ * Returns false when the collider has no cached state.
+ */
+bool BKE_collider_bounds_get(struct Depsgraph *depsgraph,
+                             struct Object *ob,
+                             const struct CollisionModifierData *collmd,
+                             float r_min[3],
+                             float r_max[3]);
+
 /////////////////////////////////////////////////
 
 /////////////////////////////////////////////////
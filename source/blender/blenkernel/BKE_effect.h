@@ -9,6 +9,11 @@
 
 #include "BLI_utildefines.h"
 
+#ifdef __cplusplus
+#  include "BLI_math_vector_types.hh"
+#  include "BLI_span.hh"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -278,3 +283,27 @@ void BKE_sim_debug_data_clear_category(const char *category);
 #ifdef __cplusplus
 }
 #endif
+
+#ifdef __cplusplus
+namespace blender::bke {
+
+/**
+ * Batch version of #BKE_effectors_apply for points set up like #pd_point_from_loc, using the
+ * position in the span as point index. Forces are added to \a r_forces and \a r_wind_forces,
+ * when the latter is empty all forces go into \a r_forces.
+ *
+ * Each effector is evaluated over a chunk of points at once, with dedicated loops for the common
+ * force, wind, vortex and harmonic fields, and chunks are evaluated in parallel.
+ * The result is the same as calling #BKE_effectors_apply for each point.
+ */
+void effectors_apply_batch(ListBase *effectors,
+                           ListBase *colliders,
+                           EffectorWeights *weights,
+                           const Scene *scene,
+                           Span<float3> positions,
+                           Span<float3> velocities,
+                           MutableSpan<float3> r_forces,
+                           MutableSpan<float3> r_wind_forces);
+
+}  // namespace blender::bke
+#endif
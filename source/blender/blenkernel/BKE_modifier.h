@@ -445,6 +445,11 @@ bool BKE_modifier_couldbe_cage(struct Scene *scene, struct ModifierData *md);
 bool BKE_modifier_is_correctable_deformed(struct ModifierData *md);
 bool BKE_modifier_is_same_topology(ModifierData *md);
 bool BKE_modifier_is_non_geometrical(ModifierData *md);
+/**
+ * Whether the modifier carries simulation state from one frame to the next (cloth, soft-body,
+ * point caches, ...), so it has to be evaluated every frame for the result to be correct.
+ */
+bool BKE_modifier_is_simulation(ModifierData *md);
 /**
  * Check whether is enabled.
  *
@@ -545,6 +550,10 @@ struct CDMaskLink *BKE_modifier_calc_data_masks(const struct Scene *scene,
 struct ModifierData *BKE_modifier_get_last_preview(const struct Scene *scene,
                                                    struct ModifierData *md,
                                                    int required_mode);
+/** Last enabled modifier in the stack starting at \a md for which #BKE_modifier_is_simulation. */
+struct ModifierData *BKE_modifier_get_last_simulation(const struct Scene *scene,
+                                                      struct ModifierData *md,
+                                                      int required_mode);
 
 typedef struct VirtualModifierData {
   ArmatureModifierData amd;
@@ -484,6 +484,13 @@ void BKE_object_eval_eval_base_flags(struct Depsgraph *depsgraph,
 void BKE_object_handle_data_update(struct Depsgraph *depsgraph,
                                    struct Scene *scene,
                                    struct Object *ob);
+/**
+ * Whether the evaluated object can skip the modifiers following its simulation modifiers, because
+ * it is hidden and its final geometry is not used by anything else. The skipped modifiers are
+ * evaluated once this is no longer the case (see #Object_Runtime.is_geometry_deferred).
+ */
+bool BKE_object_eval_can_defer_modifiers(const struct Depsgraph *depsgraph,
+                                         const struct Object *ob);
 /**
  * \warning "scene" here may not be the scene object actually resides in.
  * When dealing with background-sets, "scene" is actually the active scene.
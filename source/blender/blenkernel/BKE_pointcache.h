@@ -32,6 +32,8 @@ extern "C" {
 
 /* Add the blend-file name after `blendcache_`. */
 #define PTCACHE_EXT ".bphys"
+/* Single file cache of all frames, see #PTCACHE_DISK_CONTAINER. */
+#define PTCACHE_CONTAINER_EXT ".bphc"
 #define PTCACHE_PATH "blendcache_"
 
 /* File open options, for BKE_ptcache_file_open */
@@ -91,6 +93,8 @@ typedef struct PTCacheData {
 
 typedef struct PTCacheFile {
   FILE *fp;
+  /** Frame record in a single file cache, used instead of `fp`. */
+  struct PTCacheContainerRecord *container;
 
   int frame, old_format;
   unsigned int totpoint, type;
@@ -380,6 +384,11 @@ void BKE_ptcache_mem_to_disk(struct PTCacheID *pid);
  * Convert disk cache to memory cache and vice versa. Clears the cache that was converted.
  */
 void BKE_ptcache_toggle_disk_cache(struct PTCacheID *pid);
+/**
+ * Move the frames of a disk cache between separate frame files and a single file container,
+ * after #PTCACHE_DISK_CONTAINER was toggled.
+ */
+void BKE_ptcache_toggle_disk_container(struct PTCacheID *pid);
 /**
  * Rename all disk cache files with a new name. Doesn't touch the actual content of the files.
  */
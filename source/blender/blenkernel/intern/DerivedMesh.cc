@@ -603,6 +603,31 @@ static void set_rest_position(Mesh &mesh)
   }
 }
 
+/**
+ * First modifier which is skipped for the hidden object, null when the whole stack is evaluated.
+ * Only the modifiers up to the last simulation modifier are needed to step the simulations.
+ */
+static ModifierData *mesh_modifiers_first_deferred(const Depsgraph *depsgraph,
+                                                   const Scene *scene,
+                                                   const Object *ob,
+                                                   ModifierData *md,
+                                                   const int required_mode)
+{
+  if (!BKE_object_eval_can_defer_modifiers(depsgraph, ob)) {
+    return nullptr;
+  }
+  ModifierData *md_simulation = BKE_modifier_get_last_simulation(scene, md, required_mode);
+  if (md_simulation == nullptr) {
+    return nullptr;
+  }
+  for (md = md_simulation->next; md; md = md->next) {
+    if (BKE_modifier_is_enabled(scene, md, required_mode)) {
+      return md_simulation->next;
+    }
+  }
+  return nullptr;
+}
+
 static void mesh_calc_modifiers(Depsgraph *depsgraph,
                                 const Scene *scene,
                                 Object *ob,
@@ -670,6 +695,14 @@ static void mesh_calc_modifiers(Depsgraph *depsgraph,
     previewmd = BKE_modifier_get_last_preview(scene, md, required_mode);
   }
 
+  /* Modifiers after the simulations of hidden objects are evaluated once the object is visible,
+   * only evaluation for the dependency graph (which uses caches) can defer them. */
+  ModifierData *md_deferred = nullptr;
+  if (use_cache) {
+    md_deferred = mesh_modifiers_first_deferred(depsgraph, scene, ob, md, required_mode);
+    ob->runtime.is_geometry_deferred = md_deferred != nullptr;
+  }
+
   /* Compute accumulated datamasks needed by each modifier. It helps to do
    * this fine grained so that for example vertex groups are preserved up to
    * an armature modifier, but not through a following subsurf modifier where
@@ -694,7 +727,7 @@ static void mesh_calc_modifiers(Depsgraph *depsgraph,
 
   /* Apply all leading deform modifiers. */
   if (use_deform) {
-    for (; md; md = md->next, md_datamask = md_datamask->next) {
+    for (; md && md != md_deferred; md = md->next, md_datamask = md_datamask->next) {
       const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
 
       if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
@@ -738,7 +771,7 @@ static void mesh_calc_modifiers(Depsgraph *depsgraph,
 
   /* Apply all remaining constructive and deforming modifiers. */
   bool have_non_onlydeform_modifiers_applied = false;
-  for (; md; md = md->next, md_datamask = md_datamask->next) {
+  for (; md && md != md_deferred; md = md->next, md_datamask = md_datamask->next) {
     const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
 
     if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
@@ -1498,6 +1531,7 @@ static void editbmesh_build_data(Depsgraph *depsgraph,
   BKE_object_boundbox_calc_from_mesh(obedit, me_final);
 
   obedit->runtime.last_data_mask = *dataMask;
+  obedit->runtime.is_geometry_deferred = false;
 }
 
 static void object_get_datamask(const Depsgraph *depsgraph,
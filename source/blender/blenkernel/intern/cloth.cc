@@ -29,10 +29,12 @@
 #include "BKE_cloth.hh"
 #include "BKE_effect.h"
 #include "BKE_global.h"
+#include "BKE_key.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.hh"
 #include "BKE_mesh_runtime.hh"
 #include "BKE_modifier.h"
+#include "BKE_object.hh"
 #include "BKE_pointcache.h"
 
 #include "SIM_mass_spring.h"
@@ -242,22 +244,27 @@ static bool do_init_cloth(Object *ob, ClothModifierData *clmd, Mesh *result, int
     }
 
     clmd->clothObject->last_frame = MINFRAME - 1;
+    clmd->clothObject->group_frame = MINFRAME - 1;
     clmd->sim_parms->dt = 1.0f / clmd->sim_parms->stepsPerFrame;
   }
 
   return true;
 }
 
-static int do_step_cloth(
-    Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, Mesh *result, int framenr)
+/**
+ * Update the cloth from the input mesh of the frame to step to.
+ * \return the effectors of the step, to be freed by the caller.
+ */
+static ListBase *cloth_step_prepare(Depsgraph *depsgraph,
+                                    Object *ob,
+                                    ClothModifierData *clmd,
+                                    Mesh *result)
 {
   using namespace blender;
-  /* simulate 1 frame forward */
   ClothVertex *verts = nullptr;
   Cloth *cloth;
   ListBase *effectors = nullptr;
   uint i = 0;
-  int ret = 0;
   bool vert_mass_changed = false;
 
   cloth = clmd->clothObject;
@@ -299,10 +306,19 @@ static int do_step_cloth(
 
   cloth_update_springs(clmd);
 
+  return effectors;
+}
+
+static int do_step_cloth(
+    Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, Mesh *result, int framenr)
+{
+  /* simulate 1 frame forward */
+  ListBase *effectors = cloth_step_prepare(depsgraph, ob, clmd, result);
+
   // TIMEIT_START(cloth_step)
 
   /* call the solver. */
-  ret = SIM_cloth_solve(depsgraph, ob, framenr, clmd, effectors);
+  int ret = SIM_cloth_solve(depsgraph, ob, framenr, clmd, effectors);
 
   // TIMEIT_END(cloth_step)
 
@@ -374,6 +390,14 @@ void clothModifier_do(ClothModifierData *clmd,
    * Therefore some fields in simulation data need to be updated accordingly */
   clmd->clothObject->edges = mesh->edges().data();
 
+  if (clmd->clothObject->group_frame == framenr) {
+    /* Already stepped along with the objects it collides with, see #cloth_group_step. */
+    clmd->clothObject->group_frame = MINFRAME - 1;
+    cloth_to_object(ob, clmd, vertexCos);
+    clmd->clothObject->last_frame = framenr;
+    return;
+  }
+
   /* try to read from cache */
   bool can_simulate = (framenr == clmd->clothObject->last_frame + 1) &&
                       !(cache->flag & PTCACHE_BAKED);
@@ -430,6 +454,122 @@ void clothModifier_do(ClothModifierData *clmd,
   clmd->clothObject->last_frame = framenr;
 }
 
+bool cloth_group_object_supported(Object *ob)
+{
+  if (ob->type != OB_MESH || BKE_key_from_object(ob) != nullptr) {
+    return false;
+  }
+  /* The group step uses the object's mesh as input of the simulation. */
+  const ModifierData *md = static_cast<const ModifierData *>(ob->modifiers.first);
+  if (md == nullptr || md->type != eModifierType_Cloth) {
+    return false;
+  }
+  const ClothModifierData *clmd = reinterpret_cast<const ClothModifierData *>(md);
+  return (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_ENABLED) &&
+         BKE_modifiers_findby_type(ob, eModifierType_Collision) != nullptr;
+}
+
+/**
+ * Prepare the cloth of a group to be stepped to \a framenr, following #clothModifier_do.
+ * All objects of a group step through the same time span \a group_timescale, it is set by the
+ * first object. Objects simulating another time span are left out and simulate on their own.
+ * \return false when the modifier does not simulate this frame, e.g. because it is cached.
+ */
+static bool cloth_group_step_begin(Depsgraph *depsgraph,
+                                   Scene *scene,
+                                   Object *ob,
+                                   ClothModifierData *clmd,
+                                   float &group_timescale,
+                                   ListBase **r_effectors)
+{
+  const int required_mode = DEG_get_mode(depsgraph) == DAG_EVAL_RENDER ? eModifierMode_Render :
+                                                                         eModifierMode_Realtime;
+  if (!BKE_modifier_is_enabled(scene, &clmd->modifier, required_mode)) {
+    return false;
+  }
+
+  Cloth *cloth = clmd->clothObject;
+  PointCache *cache = clmd->point_cache;
+  Mesh *mesh = BKE_object_get_pre_modified_mesh(ob);
+  if (cloth == nullptr || clmd->sim_parms->reset || mesh == nullptr ||
+      mesh->totvert != cloth->mvert_num || (cache->flag & PTCACHE_BAKED))
+  {
+    return false;
+  }
+
+  PTCacheID pid;
+  int startframe, endframe;
+  float timescale;
+  int framenr = DEG_get_ctime(depsgraph);
+  BKE_ptcache_id_from_cloth(&pid, ob, clmd);
+  BKE_ptcache_id_time(&pid, scene, framenr, &startframe, &endframe, &timescale);
+  framenr = min_ii(framenr, endframe);
+
+  if (framenr <= startframe || framenr != cloth->last_frame + 1 ||
+      BKE_ptcache_id_exist(&pid, framenr))
+  {
+    return false;
+  }
+
+  const float solve_timescale = timescale * clmd->sim_parms->time_scale *
+                                (framenr - cache->simframe);
+  if (group_timescale != 0.0f && solve_timescale != group_timescale) {
+    return false;
+  }
+  group_timescale = solve_timescale;
+
+  cloth->edges = mesh->edges().data();
+
+  /* if on second frame, write cache for first frame */
+  if (cache->simframe == startframe && (cache->flag & PTCACHE_OUTDATED || cache->last_exact == 0))
+  {
+    BKE_ptcache_write(&pid, startframe);
+  }
+
+  clmd->sim_parms->timescale = solve_timescale;
+
+  BKE_ptcache_validate(cache, framenr);
+
+  *r_effectors = cloth_step_prepare(depsgraph, ob, clmd, mesh);
+  cloth->group_frame = framenr;
+  return true;
+}
+
+void cloth_group_step(Depsgraph *depsgraph, Scene *scene, blender::Span<Object *> objects)
+{
+  blender::Vector<ClothGroupItem> items;
+  float group_timescale = 0.0f;
+  for (Object *ob : objects) {
+    ClothModifierData *clmd = reinterpret_cast<ClothModifierData *>(
+        BKE_modifiers_findby_type(ob, eModifierType_Cloth));
+    ListBase *effectors = nullptr;
+    if (clmd != nullptr &&
+        cloth_group_step_begin(depsgraph, scene, ob, clmd, group_timescale, &effectors))
+    {
+      items.append({ob, clmd, effectors, 0});
+    }
+  }
+
+  if (items.is_empty()) {
+    return;
+  }
+
+  SIM_cloth_solve_group(depsgraph, DEG_get_ctime(depsgraph), items.data(), items.size());
+
+  for (ClothGroupItem &item : items) {
+    BKE_effectors_free(item.effectors);
+
+    PTCacheID pid;
+    BKE_ptcache_id_from_cloth(&pid, item.ob, item.clmd);
+    if (item.result) {
+      BKE_ptcache_write(&pid, item.clmd->clothObject->group_frame);
+    }
+    else {
+      BKE_ptcache_invalidate(item.clmd->point_cache);
+    }
+  }
+}
+
 void cloth_free_modifier(ClothModifierData *clmd)
 {
   Cloth *cloth = nullptr;
@@ -0,0 +1,211 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_vector.hh"
+
+#include "BKE_cloth.hh"
+#include "BKE_collection.h"
+#include "BKE_effect.h"
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+#include "BKE_mesh.hh"
+#include "BKE_modifier.h"
+#include "BKE_object.hh"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_build.hh"
+#include "DEG_depsgraph_query.hh"
+
+#include "DNA_cloth_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "CLG_log.h"
+
+namespace blender::bke::tests {
+
+static constexpr int FRAMES_NUM = 12;
+
+class ClothGroupTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  Depsgraph *depsgraph = nullptr;
+
+ public:
+  static void SetUpTestCase()
+  {
+    CLG_init();
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+    DEG_register_node_types();
+  }
+
+  static void TearDownTestCase()
+  {
+    DEG_free_node_types();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+    CLG_exit();
+  }
+
+  /** Square grid of `size * size` vertices in the XY plane, tilted by \a tilt around X. */
+  Object *add_grid(const char *name, const int size, const float3 location, const float tilt)
+  {
+    const int faces_num = (size - 1) * (size - 1);
+    Mesh *grid = BKE_mesh_new_nomain(size * size, 0, faces_num, faces_num * 4);
+
+    MutableSpan<float3> positions = grid->vert_positions_for_write();
+    for (const int y : IndexRange(size)) {
+      for (const int x : IndexRange(size)) {
+        const float fy = float(y) / (size - 1) * 2.0f - 1.0f;
+        positions[y * size + x] = float3(
+            float(x) / (size - 1) * 2.0f - 1.0f, fy * cosf(tilt), fy * sinf(tilt));
+      }
+    }
+
+    MutableSpan<int> face_offsets = grid->face_offsets_for_write();
+    MutableSpan<int> corner_verts = grid->corner_verts_for_write();
+    int face = 0;
+    for (const int y : IndexRange(size - 1)) {
+      for (const int x : IndexRange(size - 1)) {
+        face_offsets[face] = face * 4;
+        corner_verts[face * 4 + 0] = y * size + x;
+        corner_verts[face * 4 + 1] = y * size + x + 1;
+        corner_verts[face * 4 + 2] = (y + 1) * size + x + 1;
+        corner_verts[face * 4 + 3] = (y + 1) * size + x;
+        face++;
+      }
+    }
+    BKE_mesh_calc_edges(grid, false, false);
+
+    Object *ob = BKE_object_add_only_object(bmain, OB_MESH, name);
+    ob->data = BKE_mesh_add(bmain, name);
+    BKE_mesh_nomain_to_mesh(grid, static_cast<Mesh *>(ob->data), ob);
+    copy_v3_v3(ob->loc, location);
+    BKE_collection_object_add(bmain, scene->master_collection, ob);
+    return ob;
+  }
+
+  ModifierData *add_modifier(Object *ob, const ModifierType type)
+  {
+    ModifierData *md = BKE_modifier_new(type);
+    BLI_addtail(&ob->modifiers, md);
+    BKE_modifier_unique_name(&ob->modifiers, md);
+    if (type == eModifierType_Collision) {
+      ob->pd = BKE_partdeflect_new(PFIELD_NULL);
+      ob->pd->deflect = 1;
+    }
+    return md;
+  }
+
+  /**
+   * Simulate two cloths falling onto each other and onto a collider, which are stepped as a
+   * group. Every simulation uses a new scene, so nothing is read from the point cache.
+   * \return The final positions of the cloth vertices.
+   */
+  Vector<float3> simulate(const float time_scale_top)
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    scene->r.sfra = 1;
+    scene->r.efra = FRAMES_NUM;
+
+    Vector<Object *> cloths;
+    for (const int i : IndexRange(2)) {
+      Object *ob = add_grid("Cloth", 16, float3(0.0f, 0.0f, 0.5f + 0.3f * i), 0.2f * i);
+      ClothModifierData *clmd = reinterpret_cast<ClothModifierData *>(
+          add_modifier(ob, eModifierType_Cloth));
+      /* The finest steps of the group are used for all of its objects. */
+      clmd->sim_parms->stepsPerFrame = 3 + 2 * i;
+      if (i == 1) {
+        clmd->sim_parms->time_scale = time_scale_top;
+      }
+      add_modifier(ob, eModifierType_Collision);
+      cloths.append(ob);
+    }
+    Object *ob_ground = add_grid("Ground", 4, float3(0.0f), 0.0f);
+    copy_v3_fl(ob_ground->scale, 3.0f);
+    add_modifier(ob_ground, eModifierType_Collision);
+
+    ViewLayer *view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+    depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph);
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+
+    for (const int frame : IndexRange(1, FRAMES_NUM)) {
+      BKE_scene_frame_set(scene, float(frame));
+      BKE_scene_graph_update_for_newframe(depsgraph);
+    }
+
+    Vector<float3> positions;
+    for (Object *ob : cloths) {
+      Object *ob_eval = DEG_get_evaluated_object(depsgraph, ob);
+      const ClothModifierData *clmd = reinterpret_cast<const ClothModifierData *>(
+          BKE_modifiers_findby_type(ob_eval, eModifierType_Cloth));
+      const Cloth *cloth = clmd->clothObject;
+      for (const int i : IndexRange(cloth->mvert_num)) {
+        positions.append(float3(cloth->verts[i].x));
+      }
+    }
+
+    DEG_graph_free(depsgraph);
+    BKE_main_free(bmain);
+    return positions;
+  }
+
+  /** Simulate with the objects of the group solved one after another, without threads. */
+  Vector<float3> simulate_sequential(const float time_scale_top)
+  {
+    BLI_system_num_threads_override_set(1);
+    BLI_task_scheduler_init();
+    Vector<float3> positions = simulate(time_scale_top);
+    BLI_task_scheduler_exit();
+    BLI_system_num_threads_override_set(0);
+    return positions;
+  }
+
+  void test_group_matches_sequential(const float time_scale_top)
+  {
+    const Vector<float3> positions_sequential = simulate_sequential(time_scale_top);
+    const Vector<float3> positions = simulate(time_scale_top);
+
+    ASSERT_EQ(positions.size(), positions_sequential.size());
+    for (const int64_t i : positions.index_range()) {
+      EXPECT_V3_NEAR(positions[i], positions_sequential[i], 1e-6f);
+    }
+    /* The cloths fell, but not through the ground. */
+    for (const float3 &position : positions) {
+      EXPECT_LT(position.z, 0.5f + 0.3f + 0.2f);
+      EXPECT_GT(position.z, -0.1f);
+    }
+  }
+};
+
+TEST_F(ClothGroupTest, group_matches_sequential)
+{
+  test_group_matches_sequential(1.0f);
+}
+
+TEST_F(ClothGroupTest, group_time_scale_mismatch)
+{
+  /* The top cloth simulates another time span, it is stepped on its own. */
+  test_group_matches_sequential(0.5f);
+}
+
+}  // namespace blender::bke::tests
@@ -6,6 +6,10 @@
  * \ingroup bke
  */
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_cloth_types.h"
@@ -18,9 +22,12 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_linklist.h"
+#include "BLI_map.hh"
+#include "BLI_vector_set.hh"
 #include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -168,6 +175,60 @@ void bvhtree_update_from_mvert(BVHTree *bvhtree,
   BLI_bvhtree_update_tree(bvhtree);
 }
 
+void cloth_group_collider_update(Object *ob, ClothModifierData *clmd)
+{
+  Cloth *cloth = clmd->clothObject;
+  CollisionModifierData *collmd = (CollisionModifierData *)BKE_modifiers_findby_type(
+      ob, eModifierType_Collision);
+
+  /* The collision modifier has to use the cloth result as is. */
+  cloth->is_group_collider = collmd != nullptr && collmd->bvhtree != nullptr &&
+                             collmd->current_x != nullptr &&
+                             collmd->mvert_num == cloth->mvert_num;
+  if (!cloth->is_group_collider) {
+    return;
+  }
+
+  const ClothVertex *verts = cloth->verts;
+  for (uint i = 0; i < collmd->mvert_num; i++) {
+    copy_v3_v3(collmd->current_x[i], verts[i].txold);
+    copy_v3_v3(collmd->current_xnew[i], verts[i].tx);
+    sub_v3_v3v3(collmd->current_v[i], collmd->current_xnew[i], collmd->current_x[i]);
+  }
+
+  bvhtree_update_from_mvert(collmd->bvhtree,
+                            collmd->current_xnew,
+                            collmd->current_x,
+                            collmd->tri,
+                            collmd->tri_num,
+                            false);
+}
+
+void cloth_group_collider_update_end(Object *ob, ClothModifierData *clmd)
+{
+  Cloth *cloth = clmd->clothObject;
+  if (!cloth->is_group_collider) {
+    return;
+  }
+  cloth->is_group_collider = false;
+
+  /* The inter-frame state no longer matches the frame positions. */
+  CollisionModifierData *collmd = (CollisionModifierData *)BKE_modifiers_findby_type(
+      ob, eModifierType_Collision);
+  BKE_collision_update_tag(collmd);
+}
+
+void BKE_collision_update_tag(CollisionModifierData *collmd)
+{
+  static std::atomic<uint> update_stamp = 0;
+  uint stamp = ++update_stamp;
+  if (stamp == 0) {
+    /* Zero is used for colliders which were never updated. */
+    stamp = ++update_stamp;
+  }
+  collmd->update_count = int(stamp);
+}
+
 /* ***************************
  * Collision modifier code end
  * *************************** */
@@ -1374,7 +1435,7 @@ ListBase *BKE_collider_cache_create(Depsgraph *depsgraph, Object *self, Collecti
       col->ob = ob;
       col->collmd = cmd;
       /* make sure collider is properly set up */
-      collision_move_object(cmd, 1.0, 0.0, true);
+      BKE_collider_move(depsgraph, ob, cmd, 1.0, 0.0, true);
       BLI_addtail(cache, col);
     }
   }
@@ -1391,6 +1452,137 @@ void BKE_collider_cache_free(ListBase **colliders)
   }
 }
 
+/** State of a collider as of its last #collision_move_object. */
+struct ColliderState {
+  std::mutex mutex;
+
+  /* Inputs of the last move, the move is skipped when they did not change. The update stamp
+   * identifies the positions, see #BKE_collision_update_tag. */
+  int update_count = 0;
+  float step = 0.0f;
+  float prevstep = 0.0f;
+  bool moving_bvh = false;
+  bool is_valid = false;
+
+  /* Bounding box of the collider over the whole frame, including the BVH epsilon. */
+  int bounds_update_count = 0;
+  bool bounds_valid = false;
+  float bounds_min[3];
+  float bounds_max[3];
+};
+
+struct ColliderStateCache {
+  /** States of the collider objects, by session UUID of the original object. */
+  blender::Map<uint, std::unique_ptr<ColliderState>> states;
+};
+
+ColliderStateCache *BKE_collider_state_cache_create()
+{
+  return MEM_new<ColliderStateCache>(__func__);
+}
+
+void BKE_collider_state_cache_add(ColliderStateCache *cache, ListBase *relations)
+{
+  LISTBASE_FOREACH (CollisionRelation *, relation, relations) {
+    /* The same object can be in the relations of several collections, or more than once in the
+     * same relations, see #add_collision_object. */
+    cache->states.lookup_or_add_cb(relation->ob->id.session_uuid,
+                                   []() { return std::make_unique<ColliderState>(); });
+  }
+}
+
+void BKE_collider_state_cache_free(ColliderStateCache *cache)
+{
+  MEM_delete(cache);
+}
+
+static ColliderState *collider_state_find(Depsgraph *depsgraph, Object *ob)
+{
+  ColliderStateCache *cache = DEG_get_collider_state_cache(depsgraph);
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  const std::unique_ptr<ColliderState> *state = cache->states.lookup_ptr(
+      DEG_get_original_object(ob)->id.session_uuid);
+  return state ? state->get() : nullptr;
+}
+
+void BKE_collider_move(Depsgraph *depsgraph,
+                       Object *ob,
+                       CollisionModifierData *collmd,
+                       const float step,
+                       const float prevstep,
+                       const bool moving_bvh)
+{
+  ColliderState *state = collider_state_find(depsgraph, ob);
+  if (state == nullptr) {
+    collision_move_object(collmd, step, prevstep, moving_bvh);
+    return;
+  }
+
+  std::lock_guard lock(state->mutex);
+
+  const bool is_same_input = state->is_valid && collmd->update_count != 0 &&
+                             state->update_count == collmd->update_count;
+  /* A static collider ends up in the same state for any step. */
+  if (is_same_input &&
+      (collmd->is_static || (state->step == step && state->prevstep == prevstep &&
+                             state->moving_bvh == moving_bvh)))
+  {
+    return;
+  }
+
+  collision_move_object(collmd, step, prevstep, moving_bvh);
+
+  state->update_count = collmd->update_count;
+  state->step = step;
+  state->prevstep = prevstep;
+  state->moving_bvh = moving_bvh;
+  state->is_valid = true;
+}
+
+bool BKE_collider_bounds_get(Depsgraph *depsgraph,
+                             Object *ob,
+                             const CollisionModifierData *collmd,
+                             float r_min[3],
+                             float r_max[3])
+{
+  if (collmd->bvhtree == nullptr || collmd->x == nullptr || collmd->xnew == nullptr) {
+    return false;
+  }
+
+  ColliderState *state = collider_state_find(depsgraph, ob);
+  if (state == nullptr) {
+    return false;
+  }
+
+  std::lock_guard lock(state->mutex);
+
+  if (!state->bounds_valid || collmd->update_count == 0 ||
+      state->bounds_update_count != collmd->update_count)
+  {
+    /* Inter-frame positions are interpolated between the frame start and end positions. */
+    INIT_MINMAX(state->bounds_min, state->bounds_max);
+    for (uint i = 0; i < collmd->mvert_num; i++) {
+      minmax_v3v3_v3(state->bounds_min, state->bounds_max, collmd->x[i]);
+      minmax_v3v3_v3(state->bounds_min, state->bounds_max, collmd->xnew[i]);
+    }
+
+    /* Pad for the BVH epsilon and for rounding in the interpolation. */
+    const float pad = BLI_bvhtree_get_epsilon(collmd->bvhtree) +
+                      1e-5f * max_ff(len_v3(state->bounds_min), len_v3(state->bounds_max));
+    add_v3_fl(state->bounds_min, -pad);
+    add_v3_fl(state->bounds_max, pad);
+
+    state->bounds_update_count = collmd->update_count;
+    state->bounds_valid = true;
+  }
+
+  copy_v3_v3(r_min, state->bounds_min);
+  copy_v3_v3(r_max, state->bounds_max);
+  return true;
+}
+
 static bool cloth_bvh_objcollisions_nearcheck(ClothModifierData *clmd,
                                               CollisionModifierData *collmd,
                                               CollPair **collisions,
@@ -1560,8 +1752,59 @@ static bool cloth_bvh_self_overlap_cb(void *userdata, int index_a, int index_b,
   return false;
 }
 
-int cloth_bvh_collision(
-    Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt)
+/* Collider stepped along with the cloth by #cloth_group_step, already at the current step. */
+static bool cloth_bvh_collider_is_group_member(Object *collob)
+{
+  const ClothModifierData *clmd = (const ClothModifierData *)BKE_modifiers_findby_type(
+      collob, eModifierType_Cloth);
+  return clmd != nullptr && clmd->clothObject != nullptr && clmd->clothObject->is_group_collider;
+}
+
+void cloth_group_colliders_move(Depsgraph *depsgraph,
+                                const blender::Span<Object *> objects,
+                                const float step,
+                                const float dt)
+{
+  blender::VectorSet<Object *> colliders;
+  for (Object *ob : objects) {
+    ClothModifierData *clmd = (ClothModifierData *)BKE_modifiers_findby_type(
+        ob, eModifierType_Cloth);
+    if (!(clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_ENABLED) ||
+        (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_COLLOBJ))
+    {
+      continue;
+    }
+    uint numcollobj = 0;
+    Object **collobjs = BKE_collision_objects_create(
+        depsgraph, ob, clmd->coll_parms->group, &numcollobj, eModifierType_Collision);
+    for (uint i = 0; i < numcollobj; i++) {
+      if (!cloth_bvh_collider_is_group_member(collobjs[i])) {
+        colliders.add(collobjs[i]);
+      }
+    }
+    BKE_collision_objects_free(collobjs);
+  }
+
+  /* Every collider is moved by one task, the colliders don't share data. */
+  blender::threading::parallel_for(
+      colliders.index_range(), 1, [&](const blender::IndexRange range) {
+        for (const int64_t i : range) {
+          Object *collob = colliders[i];
+          CollisionModifierData *collmd = (CollisionModifierData *)BKE_modifiers_findby_type(
+              collob, eModifierType_Collision);
+          if (collmd->bvhtree) {
+            BKE_collider_move(depsgraph, collob, collmd, step + dt, step, false);
+          }
+        }
+      });
+}
+
+int cloth_bvh_collision(Depsgraph *depsgraph,
+                        Object *ob,
+                        ClothModifierData *clmd,
+                        float step,
+                        float dt,
+                        const bool move_colliders)
 {
   Cloth *cloth = clmd->clothObject;
   BVHTree *cloth_bvh = cloth->bvhtree;
@@ -1601,6 +1844,11 @@ int cloth_bvh_collision(
       coll_counts_obj = MEM_cnew_array<uint>(numcollobj, "CollCounts");
       overlap_obj = MEM_cnew_array<BVHTreeOverlap *>(numcollobj, "BVHOverlap");
 
+      /* Broad phase: skip colliders whose bounds over the frame can't reach the cloth. */
+      float cloth_min[3], cloth_max[3];
+      BLI_bvhtree_get_bounding_box(cloth_bvh, cloth_min, cloth_max);
+      ClothSolverResult *sres = clmd->solver_result;
+
       for (i = 0; i < numcollobj; i++) {
         Object *collob = collobjs[i];
         CollisionModifierData *collmd = (CollisionModifierData *)BKE_modifiers_findby_type(
@@ -1610,8 +1858,26 @@ int cloth_bvh_collision(
           continue;
         }
 
-        /* Move object to position (step) in time. */
-        collision_move_object(collmd, step + dt, step, false);
+        if (sres) {
+          sres->collision_pairs++;
+        }
+
+        if (!cloth_bvh_collider_is_group_member(collob)) {
+          float coll_min[3], coll_max[3];
+          if (BKE_collider_bounds_get(depsgraph, collob, collmd, coll_min, coll_max) &&
+              !isect_aabb_aabb_v3(cloth_min, cloth_max, coll_min, coll_max))
+          {
+            if (sres) {
+              sres->collision_pairs_culled++;
+            }
+            continue;
+          }
+
+          /* Move object to position (step) in time. */
+          if (move_colliders) {
+            BKE_collider_move(depsgraph, collob, collmd, step + dt, step, false);
+          }
+        }
 
         overlap_obj[i] = BLI_bvhtree_overlap(cloth_bvh,
                                              collmd->bvhtree,
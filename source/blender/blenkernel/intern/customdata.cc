@@ -34,6 +34,7 @@
 #include "BLI_string_ref.hh"
 #include "BLI_string_utf8.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #ifndef NDEBUG
@@ -2208,6 +2209,55 @@ static void free_layer_data(const eCustomDataType type, const void *data, const
   MEM_freeN(const_cast<void *>(data));
 }
 
+/** Layer data allocated by #customdata_merge_internal, the data is copied afterwards. */
+struct LayerCopy {
+  eCustomDataType type;
+  const void *src;
+  void *dst;
+};
+
+static void *layer_copy_allocate(const eCustomDataType type, const void *data, const int totelem)
+{
+  const LayerTypeInfo &type_info = *layerType_getInfo(type);
+  if (type_info.copy) {
+    return MEM_malloc_arrayN(size_t(totelem), type_info.size, __func__);
+  }
+  /* Same size as #MEM_dupallocN in #copy_layer_data. */
+  return MEM_mallocN(MEM_allocN_len(data), __func__);
+}
+
+/**
+ * Fill the data allocated by #layer_copy_allocate. Layers that can't be shared are copied in
+ * parallel, since for big geometry copying them one after another is a noticeable part of
+ * copy-on-write updates.
+ */
+static void layer_copies_fill(const Span<LayerCopy> copies, const int totelem)
+{
+  const auto fill = [&](const LayerCopy &copy) {
+    const LayerTypeInfo &type_info = *layerType_getInfo(copy.type);
+    if (type_info.copy) {
+      type_info.copy(copy.src, copy.dst, totelem);
+    }
+    else {
+      memcpy(copy.dst, copy.src, MEM_allocN_len(copy.src));
+    }
+  };
+
+  /* Not worth the threading overhead for small geometry. */
+  const int parallel_threshold = 4096;
+  if (copies.size() == 1 || totelem < parallel_threshold) {
+    for (const LayerCopy &copy : copies) {
+      fill(copy);
+    }
+    return;
+  }
+  blender::threading::parallel_for(copies.index_range(), 1, [&](const IndexRange range) {
+    for (const LayerCopy &copy : copies.slice(range)) {
+      fill(copy);
+    }
+  });
+}
+
 static bool customdata_merge_internal(const CustomData *source,
                                       CustomData *dest,
                                       const eCustomDataMask mask,
@@ -2223,6 +2273,7 @@ static bool customdata_merge_internal(const CustomData *source,
   int last_mask = 0;
   int current_type_layer_count = 0;
   int max_current_type_layer_count = -1;
+  Vector<LayerCopy> layer_copies;
 
   for (int i = 0; i < source->totlayer; i++) {
     const CustomDataLayer &src_layer = source->layers[i];
@@ -2268,8 +2319,15 @@ static bool customdata_merge_internal(const CustomData *source,
     if (!alloctype.has_value()) {
       if (src_layer.data != nullptr) {
         if (src_layer.sharing_info == nullptr) {
-          /* Can't share the layer, duplicate it instead. */
-          layer_data_to_assign = copy_layer_data(type, src_layer.data, totelem);
+          /* Can't share the layer, duplicate it instead. The data is copied after all layers are
+           * added, so that the copies can be done in parallel. */
+          if (totelem > 0) {
+            layer_data_to_assign = layer_copy_allocate(type, src_layer.data, totelem);
+            layer_copies.append({type, src_layer.data, layer_data_to_assign});
+          }
+          else {
+            layer_data_to_assign = copy_layer_data(type, src_layer.data, totelem);
+          }
         }
         else {
           /* Share the layer. */
@@ -2301,6 +2359,10 @@ static bool customdata_merge_internal(const CustomData *source,
     }
   }
 
+  if (!layer_copies.is_empty()) {
+    layer_copies_fill(layer_copies, totelem);
+  }
+
   CustomData_update_typemap(dest);
   return changed;
 }
@@ -6,6 +6,7 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstddef>
 
@@ -25,14 +26,18 @@
 #include "DNA_scene_types.h"
 #include "DNA_texture_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_kdopbvh.h"
 #include "BLI_math_matrix.h"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
 #include "BLI_noise.h"
 #include "BLI_rand.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "PIL_time.h"
 
@@ -136,6 +141,37 @@ void BKE_partdeflect_free(PartDeflect *pd)
 
 /******************** EFFECTOR RELATIONS ***********************/
 
+/* Below this number of effectors with a finite influence radius,
+ * walking the whole list is cheaper than querying the spatial index. */
+#define EFFECTOR_INDEX_MIN_BOUNDED 8
+
+/* Spatial lookup of the effectors that can influence a point, built by #BKE_effectors_create.
+ * Effectors with a finite influence radius are stored in a BVH tree, all others are visited for
+ * every point. Effectors are always applied in list order, so the result is identical to walking
+ * the whole list. */
+struct EffectorIndex {
+  /* All effectors, in list order. */
+  blender::Array<EffectorCache *> effectors;
+  /* List positions of the effectors that are not in the tree, ascending. */
+  blender::Vector<int> unbounded;
+  /* Influence bounds of the other effectors, leaf index is the list position. */
+  BVHTree *tree = nullptr;
+
+  ~EffectorIndex()
+  {
+    if (tree) {
+      BLI_bvhtree_free(tree);
+    }
+  }
+};
+
+/* The effector list created by #BKE_effectors_create.
+ * The list comes first, so this can be used everywhere as a ListBase of #EffectorCache. */
+struct EffectorList {
+  ListBase effectors;
+  EffectorIndex *index;
+};
+
 static void precalculate_effector(Depsgraph *depsgraph, EffectorCache *eff)
 {
   float ctime = DEG_get_ctime(depsgraph);
@@ -197,7 +233,7 @@ static void add_effector_evaluation(ListBase **effectors,
                                     PartDeflect *pd)
 {
   if (*effectors == nullptr) {
-    *effectors = static_cast<ListBase *>(MEM_callocN(sizeof(ListBase), "effector effectors"));
+    *effectors = static_cast<ListBase *>(MEM_callocN(sizeof(EffectorList), "effector effectors"));
   }
 
   EffectorCache *eff = static_cast<EffectorCache *>(
@@ -320,6 +356,72 @@ static bool is_effector_relevant(PartDeflect *pd, EffectorWeights *weights, bool
          is_effector_nonzero_strength(pd);
 }
 
+/**
+ * Radius around the object center outside of which the effector has no influence at all,
+ * or a negative value when the influence is not bounded.
+ *
+ * Only point shaped object effectors with a spherical falloff and a maximum distance qualify:
+ * #effector_falloff is exactly zero beyond #PartDeflect.maxdist for them, and effectors with
+ * zero falloff are skipped by #BKE_effectors_apply without any side effects.
+ */
+static float effector_influence_radius(const EffectorCache *eff)
+{
+  const PartDeflect *pd = eff->pd;
+
+  if (eff->psys || pd->shape != PFIELD_SHAPE_POINT || pd->falloff != PFIELD_FALL_SPHERE) {
+    return -1.0f;
+  }
+  if (!(pd->flag & PFIELD_USEMAX) || !(pd->maxdist >= 0.0f) || !std::isfinite(pd->maxdist)) {
+    return -1.0f;
+  }
+  /* Pad the bounds, so rounding of the distance can never put a point that is in range
+   * outside of the box. */
+  return pd->maxdist * (1.0f + 1e-5f) + 1e-6f;
+}
+
+static void build_effector_index(EffectorList *list)
+{
+  const int effectors_num = BLI_listbase_count(&list->effectors);
+
+  blender::Array<float> radii(effectors_num);
+  int bounded_num = 0;
+  int i = 0;
+  LISTBASE_FOREACH_INDEX (EffectorCache *, eff, &list->effectors, i) {
+    radii[i] = effector_influence_radius(eff);
+    if (radii[i] >= 0.0f) {
+      bounded_num++;
+    }
+  }
+
+  if (bounded_num < EFFECTOR_INDEX_MIN_BOUNDED) {
+    return;
+  }
+
+  EffectorIndex *index = MEM_new<EffectorIndex>(__func__);
+  index->effectors.reinitialize(effectors_num);
+  index->tree = BLI_bvhtree_new(bounded_num, 0.0f, 4, 6);
+
+  LISTBASE_FOREACH_INDEX (EffectorCache *, eff, &list->effectors, i) {
+    index->effectors[i] = eff;
+
+    if (radii[i] < 0.0f) {
+      index->unbounded.append(i);
+      continue;
+    }
+
+    const float *center = eff->ob->object_to_world[3];
+    float co[2][3];
+    for (int axis = 0; axis < 3; axis++) {
+      co[0][axis] = center[axis] - radii[i];
+      co[1][axis] = center[axis] + radii[i];
+    }
+    BLI_bvhtree_insert(index->tree, i, co[0], 2);
+  }
+
+  BLI_bvhtree_balance(index->tree);
+  list->index = index;
+}
+
 ListBase *BKE_effectors_create(Depsgraph *depsgraph,
                                Object *ob_src,
                                ParticleSystem *psys_src,
@@ -372,12 +474,18 @@ ListBase *BKE_effectors_create(Depsgraph *depsgraph,
     }
   }
 
+  if (effectors) {
+    build_effector_index(reinterpret_cast<EffectorList *>(effectors));
+  }
+
   return effectors;
 }
 
 void BKE_effectors_free(ListBase *lb)
 {
   if (lb) {
+    MEM_delete(reinterpret_cast<EffectorList *>(lb)->index);
+
     LISTBASE_FOREACH (EffectorCache *, eff, lb) {
       if (eff->guide_data) {
         MEM_freeN(eff->guide_data);
@@ -1116,6 +1224,60 @@ static void do_physical_effector(EffectorCache *eff,
   }
 }
 
+/* Add the influence of a single effector on the point. */
+static void effector_apply(EffectorCache *eff,
+                           ListBase *colliders,
+                           EffectorWeights *weights,
+                           EffectedPoint *point,
+                           float *force,
+                           float *wind_force,
+                           float *impulse)
+{
+  EffectorData efd;
+  int p = 0, tot = 1, step = 1;
+
+  /* object effectors were fully checked to be OK to evaluate! */
+
+  get_effector_tot(eff, &efd, point, &tot, &p, &step);
+
+  for (; p < tot; p += step) {
+    if (get_effector_data(eff, &efd, point, 0)) {
+      efd.falloff = effector_falloff(eff, &efd, point, weights);
+
+      if (efd.falloff > 0.0f) {
+        efd.falloff *= eff_calc_visibility(colliders, eff, &efd, point);
+      }
+      if (efd.falloff > 0.0f) {
+        float out_force[3] = {0, 0, 0};
+
+        if (eff->pd->forcefield == PFIELD_TEXTURE) {
+          do_texture_effector(eff, &efd, point, out_force);
+        }
+        else {
+          do_physical_effector(eff, &efd, point, out_force);
+
+          /* for softbody backward compatibility */
+          if (point->flag & PE_WIND_AS_SPEED && impulse) {
+            sub_v3_v3v3(impulse, impulse, out_force);
+          }
+        }
+
+        if (wind_force) {
+          madd_v3_v3fl(force, out_force, 1.0f - eff->pd->f_wind_factor);
+          madd_v3_v3fl(wind_force, out_force, eff->pd->f_wind_factor);
+        }
+        else {
+          add_v3_v3(force, out_force);
+        }
+      }
+    }
+    else if (eff->flag & PE_VELOCITY_TO_IMPULSE && impulse) {
+      /* special case for harmonic effector */
+      add_v3_v3v3(impulse, impulse, efd.vel);
+    }
+  }
+}
+
 void BKE_effectors_apply(ListBase *effectors,
                          ListBase *colliders,
                          EffectorWeights *weights,
@@ -1153,58 +1315,301 @@ void BKE_effectors_apply(ListBase *effectors,
    *   (particles are guided along a curve bezier or old nurbs)
    *   (is independent of other effectors)
    */
-  EffectorData efd;
-  int p = 0, tot = 1, step = 1;
-
   /* Cycle through collected objects, get total of (1/(gravity_strength * dist^gravity_power)) */
   /* Check for min distance here? (yes would be cool to add that, ton) */
 
-  if (effectors) {
+  if (effectors == nullptr) {
+    return;
+  }
+
+  const EffectorIndex *index = reinterpret_cast<EffectorList *>(effectors)->index;
+
+  if (index == nullptr) {
     LISTBASE_FOREACH (EffectorCache *, eff, effectors) {
-      /* object effectors were fully checked to be OK to evaluate! */
+      effector_apply(eff, colliders, weights, point, force, wind_force, impulse);
+    }
+    return;
+  }
 
-      get_effector_tot(eff, &efd, point, &tot, &p, &step);
+  /* Only visit the bounded effectors whose influence box contains the point. */
+  blender::Vector<int, 16> hits;
+  blender::BLI_bvhtree_range_query_cpp(
+      *index->tree,
+      point->loc,
+      FLT_EPSILON,
+      [&](const int i, const blender::float3 & /*co*/, float /*dist_sq*/) { hits.append(i); });
+  std::sort(hits.begin(), hits.end());
+
+  /* Merge with the unbounded effectors to keep the order of the list. */
+  const blender::Span<int> unbounded = index->unbounded;
+  int u = 0, h = 0;
+  while (u < unbounded.size() || h < hits.size()) {
+    int i;
+    if (h == hits.size() || (u < unbounded.size() && unbounded[u] < hits[h])) {
+      i = unbounded[u++];
+    }
+    else {
+      i = hits[h++];
+    }
+    effector_apply(index->effectors[i], colliders, weights, point, force, wind_force, impulse);
+  }
+}
 
-      for (; p < tot; p += step) {
-        if (get_effector_data(eff, &efd, point, 0)) {
-          efd.falloff = effector_falloff(eff, &efd, point, weights);
+/* Effectors evaluated by the dedicated loops of #blender::bke::effectors_apply_batch.
+ * These are object effectors whose #get_effector_data only depends on the object transform,
+ * without noise (which advances the random generator per point) or visibility checks. */
+static bool effector_batch_supported(const EffectorCache *eff)
+{
+  const PartDeflect *pd = eff->pd;
+  return eff->psys == nullptr && !(eff->flag & PE_USE_NORMAL_DATA) &&
+         ELEM(pd->shape, PFIELD_SHAPE_POINT, PFIELD_SHAPE_PLANE, PFIELD_SHAPE_LINE) &&
+         ELEM(pd->forcefield, PFIELD_FORCE, PFIELD_WIND, PFIELD_VORTEX, PFIELD_HARMONIC) &&
+         !(pd->f_noise > 0.0f) && !(pd->flag & PFIELD_VISIBILITY);
+}
 
-          if (efd.falloff > 0.0f) {
-            efd.falloff *= eff_calc_visibility(colliders, eff, &efd, point);
+/* Same as #get_effector_data, #effector_falloff and #do_physical_effector for a supported
+ * effector, with everything that does not depend on the point hoisted out of the loop. */
+static void effector_batch_apply_range(EffectorCache *eff,
+                                       EffectorWeights *weights,
+                                       const float vel_to_sec,
+                                       const blender::Span<blender::float3> positions,
+                                       const blender::Span<blender::float3> velocities,
+                                       const blender::IndexRange range,
+                                       blender::MutableSpan<blender::float3> r_forces,
+                                       blender::MutableSpan<blender::float3> r_wind_forces)
+{
+  using namespace blender;
+  const PartDeflect *pd = eff->pd;
+  const Object *ob = eff->ob;
+  const float *center = ob->object_to_world[3];
+  const bool use_plane = ELEM(pd->shape, PFIELD_SHAPE_PLANE, PFIELD_SHAPE_LINE);
+  const bool loc_on_axis = pd->forcefield == PFIELD_VORTEX || pd->shape == PFIELD_SHAPE_LINE;
+  const bool use_rest_length = pd->forcefield == PFIELD_HARMONIC && pd->f_size;
+  const bool use_flow = pd->forcefield != PFIELD_HARMONIC && pd->f_flow != 0.0f;
+  const bool use_gravitation = pd->flag & PFIELD_GRAVITATION;
+  const bool do_location = pd->flag & PFIELD_DO_LOCATION;
+  const bool use_wind = !r_wind_forces.is_empty();
+  const float strength = pd->f_strength;
+  const float harmonic_damp = -pd->f_damp * 2.0f * sqrtf(fabsf(strength)) * vel_to_sec;
+
+  EffectorData efd;
+  normalize_v3_v3(efd.nor, ob->object_to_world[2]);
+  copy_v3_v3(efd.nor2, efd.nor);
+  zero_v3(efd.vel);
+  efd.size = 0.0f;
+
+  /* Distance part of the effector data, see #get_effector_data. */
+  auto point_data = [&](const float loc[3]) {
+    if (use_plane) {
+      float temp[3], translate[3];
+      sub_v3_v3v3(temp, loc, center);
+      project_v3_v3v3(translate, temp, efd.nor);
+      if (loc_on_axis) {
+        add_v3_v3v3(efd.loc, center, translate);
+      }
+      else {
+        sub_v3_v3v3(efd.loc, loc, translate);
+      }
+    }
+    else {
+      copy_v3_v3(efd.loc, center);
+    }
+    sub_v3_v3v3(efd.vec_to_point, loc, efd.loc);
+    efd.distance = len_v3(efd.vec_to_point);
+    if (use_rest_length) {
+      mul_v3_fl(efd.vec_to_point, (efd.distance - pd->f_size) / efd.distance);
+    }
+    sub_v3_v3v3(efd.vec_to_point2, loc, center);
+    efd.falloff = effector_falloff(eff, &efd, nullptr, weights);
+    return efd.falloff > 0.0f;
+  };
+
+  /* Add the force of the field, see #do_physical_effector and #BKE_effectors_apply. */
+  auto add_force = [&](const int64_t i, const float force[3]) {
+    float out_force[3] = {0, 0, 0};
+    if (do_location) {
+      madd_v3_v3fl(out_force, force, 1.0f / vel_to_sec);
+      if (use_flow) {
+        madd_v3_v3fl(out_force, velocities[i], -pd->f_flow * efd.falloff);
+      }
+    }
+    if (use_wind) {
+      madd_v3_v3fl(r_forces[i], out_force, 1.0f - pd->f_wind_factor);
+      madd_v3_v3fl(r_wind_forces[i], out_force, pd->f_wind_factor);
+    }
+    else {
+      add_v3_v3(r_forces[i], out_force);
+    }
+  };
+
+  switch (pd->forcefield) {
+    case PFIELD_FORCE:
+      for (const int64_t i : range) {
+        if (point_data(positions[i])) {
+          float force[3], point_strength = strength;
+          normalize_v3_v3(force, efd.vec_to_point);
+          if (use_gravitation) {
+            point_strength = (efd.distance < FLT_EPSILON) ?
+                                 0.0f :
+                                 point_strength * powf(efd.distance, -2.0f);
           }
-          if (efd.falloff > 0.0f) {
-            float out_force[3] = {0, 0, 0};
-
-            if (eff->pd->forcefield == PFIELD_TEXTURE) {
-              do_texture_effector(eff, &efd, point, out_force);
-            }
-            else {
-              do_physical_effector(eff, &efd, point, out_force);
-
-              /* for softbody backward compatibility */
-              if (point->flag & PE_WIND_AS_SPEED && impulse) {
-                sub_v3_v3v3(impulse, impulse, out_force);
-              }
-            }
-
-            if (wind_force) {
-              madd_v3_v3fl(force, out_force, 1.0f - eff->pd->f_wind_factor);
-              madd_v3_v3fl(wind_force, out_force, eff->pd->f_wind_factor);
-            }
-            else {
-              add_v3_v3(force, out_force);
-            }
+          mul_v3_fl(force, point_strength * efd.falloff);
+          add_force(i, force);
+        }
+      }
+      break;
+    case PFIELD_WIND:
+      for (const int64_t i : range) {
+        if (point_data(positions[i])) {
+          float force[3];
+          mul_v3_v3fl(force, efd.nor, strength * efd.falloff);
+          add_force(i, force);
+        }
+      }
+      break;
+    case PFIELD_VORTEX:
+      for (const int64_t i : range) {
+        if (point_data(positions[i])) {
+          float force[3], temp[3];
+          if (pd->shape == PFIELD_SHAPE_POINT) {
+            cross_v3_v3v3(force, efd.nor, efd.vec_to_point);
+            normalize_v3(force);
+            mul_v3_fl(force, strength * efd.distance * efd.falloff);
+          }
+          else {
+            cross_v3_v3v3(temp, efd.nor2, efd.vec_to_point2);
+            mul_v3_fl(temp, strength * efd.falloff);
+            cross_v3_v3v3(force, efd.nor2, temp);
+            mul_v3_fl(force, strength * efd.falloff);
+            madd_v3_v3fl(temp, velocities[i], -vel_to_sec);
+            add_v3_v3(force, temp);
           }
+          add_force(i, force);
         }
-        else if (eff->flag & PE_VELOCITY_TO_IMPULSE && impulse) {
-          /* special case for harmonic effector */
-          add_v3_v3v3(impulse, impulse, efd.vel);
+      }
+      break;
+    case PFIELD_HARMONIC:
+      for (const int64_t i : range) {
+        if (point_data(positions[i])) {
+          float force[3], temp[3];
+          mul_v3_v3fl(force, efd.vec_to_point, -strength * efd.falloff);
+          mul_v3_v3fl(temp, velocities[i], harmonic_damp);
+          add_v3_v3(force, temp);
+          add_force(i, force);
         }
       }
+      break;
+    default:
+      BLI_assert_unreachable();
+      break;
+  }
+}
+
+namespace blender::bke {
+
+/* Number of points evaluated together in one task. */
+#define EFFECTOR_BATCH_CHUNK_SIZE 256
+
+void effectors_apply_batch(ListBase *effectors,
+                           ListBase *colliders,
+                           EffectorWeights *weights,
+                           const Scene *scene,
+                           const Span<float3> positions,
+                           const Span<float3> velocities,
+                           MutableSpan<float3> r_forces,
+                           MutableSpan<float3> r_wind_forces)
+{
+  BLI_assert(positions.size() == velocities.size() && positions.size() == r_forces.size());
+  BLI_assert(r_wind_forces.is_empty() || r_wind_forces.size() == positions.size());
+
+  if (effectors == nullptr || BLI_listbase_is_empty(effectors)) {
+    return;
+  }
+
+  const EffectorIndex *index = reinterpret_cast<EffectorList *>(effectors)->index;
+  const float vel_to_sec = float(scene->r.frs_sec);
+
+  /* Noise advances the random generator of the field for every point, the order of which must
+   * not depend on threading. */
+  bool use_threading = true;
+  LISTBASE_FOREACH (EffectorCache *, eff, effectors) {
+    if (eff->pd->f_noise > 0.0f) {
+      use_threading = false;
+    }
+  }
+
+  auto apply_effector = [&](EffectorCache *eff, const IndexRange range) {
+    if (effector_batch_supported(eff)) {
+      effector_batch_apply_range(
+          eff, weights, vel_to_sec, positions, velocities, range, r_forces, r_wind_forces);
+      return;
+    }
+    for (const int64_t i : range) {
+      float loc[3], vel[3];
+      EffectedPoint point;
+      copy_v3_v3(loc, positions[i]);
+      copy_v3_v3(vel, velocities[i]);
+      pd_point_from_loc(const_cast<Scene *>(scene), loc, vel, int(i), &point);
+      float *wind_force_ptr = r_wind_forces.is_empty() ? nullptr : &r_wind_forces[i].x;
+      effector_apply(eff, colliders, weights, &point, r_forces[i], wind_force_ptr, nullptr);
+    }
+  };
+
+  auto apply_chunk = [&](const IndexRange range) {
+    if (index == nullptr) {
+      LISTBASE_FOREACH (EffectorCache *, eff, effectors) {
+        apply_effector(eff, range);
+      }
+      return;
+    }
+
+    /* Only the bounded effectors whose influence can reach the chunk are evaluated, in list
+     * order with the unbounded ones. Points outside of the range of an effector get a zero
+     * falloff, just like in #BKE_effectors_apply. */
+    float min[3], max[3], chunk_center[3];
+    INIT_MINMAX(min, max);
+    for (const int64_t i : range) {
+      minmax_v3v3_v3(min, max, positions[i]);
+    }
+    mid_v3_v3v3(chunk_center, min, max);
+    const float chunk_radius = len_v3v3(min, max) * 0.5f * (1.0f + 1e-5f) + FLT_EPSILON;
+
+    Vector<int, 16> hits;
+    BLI_bvhtree_range_query_cpp(
+        *index->tree,
+        chunk_center,
+        chunk_radius,
+        [&](const int i, const float3 & /*co*/, float /*dist_sq*/) { hits.append(i); });
+    std::sort(hits.begin(), hits.end());
+
+    const Span<int> unbounded = index->unbounded;
+    int u = 0, h = 0;
+    while (u < unbounded.size() || h < hits.size()) {
+      int i;
+      if (h == hits.size() || (u < unbounded.size() && unbounded[u] < hits[h])) {
+        i = unbounded[u++];
+      }
+      else {
+        i = hits[h++];
+      }
+      apply_effector(index->effectors[i], range);
+    }
+  };
+
+  const IndexRange points = positions.index_range();
+  if (use_threading) {
+    threading::parallel_for(points, EFFECTOR_BATCH_CHUNK_SIZE, apply_chunk);
+  }
+  else {
+    for (int64_t start = 0; start < points.size(); start += EFFECTOR_BATCH_CHUNK_SIZE) {
+      const int64_t size = std::min<int64_t>(EFFECTOR_BATCH_CHUNK_SIZE, points.size() - start);
+      apply_chunk(points.slice(start, size));
     }
   }
 }
 
+}  // namespace blender::bke
+
 /* ======== Simulation Debugging ======== */
 
 SimDebugData *_sim_debug_data = nullptr;
@@ -434,6 +434,19 @@ bool BKE_modifier_is_non_geometrical(ModifierData *md)
   return (mti->type == eModifierTypeType_NonGeometrical);
 }
 
+bool BKE_modifier_is_simulation(ModifierData *md)
+{
+  /* Modifiers which step their state from the previous frame, or write a point cache. */
+  return ELEM(md->type,
+              eModifierType_Cloth,
+              eModifierType_Softbody,
+              eModifierType_Collision,
+              eModifierType_Surface,
+              eModifierType_DynamicPaint,
+              eModifierType_Fluid,
+              eModifierType_ParticleSystem);
+}
+
 void BKE_modifier_set_error(const Object *ob, ModifierData *md, const char *_format, ...)
 {
   char buffer[512];
@@ -696,6 +709,20 @@ ModifierData *BKE_modifier_get_last_preview(const Scene *scene,
   return tmp_md;
 }
 
+ModifierData *BKE_modifier_get_last_simulation(const Scene *scene,
+                                               ModifierData *md,
+                                               int required_mode)
+{
+  ModifierData *tmp_md = nullptr;
+
+  for (; md; md = md->next) {
+    if (BKE_modifier_is_enabled(scene, md, required_mode) && BKE_modifier_is_simulation(md)) {
+      tmp_md = md;
+    }
+  }
+  return tmp_md;
+}
+
 ModifierData *BKE_modifiers_get_virtual_modifierlist(const Object *ob,
                                                      VirtualModifierData *virtual_modifier_data)
 {
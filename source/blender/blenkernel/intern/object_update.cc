@@ -15,6 +15,7 @@
 #include "DNA_mesh_types.h"
 #include "DNA_modifier_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_math_matrix.h"
@@ -240,6 +241,24 @@ void BKE_object_handle_data_update(Depsgraph *depsgraph, Scene *scene, Object *o
   }
 }
 
+bool BKE_object_eval_can_defer_modifiers(const Depsgraph *depsgraph, const Object *ob)
+{
+  if (!USER_EXPERIMENTAL_TEST(&U, use_deferred_hidden_modifiers)) {
+    return false;
+  }
+  if (!DEG_use_deferred_geometry(depsgraph)) {
+    return false;
+  }
+  /* Edit and paint modes work on the evaluated geometry of hidden objects too. */
+  if (ob->mode != OB_MODE_OBJECT) {
+    return false;
+  }
+  if (ob->base_flag & BASE_ENABLED_AND_MAYBE_VISIBLE_IN_VIEWPORT) {
+    return false;
+  }
+  return (DEG_get_eval_flags_for_id(depsgraph, &ob->id) & DAG_EVAL_NEED_FINAL_GEOMETRY) == 0;
+}
+
 /** Bounding box from evaluated geometry. */
 static void object_sync_boundbox_to_original(Object *object_orig, Object *object_eval)
 {
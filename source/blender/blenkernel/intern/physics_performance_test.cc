@@ -0,0 +1,350 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_rand.hh"
+#include "BLI_threads.h"
+#include "BLI_timeit.hh"
+
+#include "BKE_appdir.h"
+#include "BKE_collection.h"
+#include "BKE_effect.h"
+#include "BKE_global.h"
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+#include "BKE_mesh.hh"
+#include "BKE_modifier.h"
+#include "BKE_object.hh"
+#include "BKE_pointcache.h"
+#include "BKE_scene.h"
+#include "BKE_softbody.h"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_build.hh"
+#include "DEG_depsgraph_query.hh"
+
+#include "DNA_cloth_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "CLG_log.h"
+
+/* Physics micro-benchmarks on generated scenes, for timing the solvers without going through
+ * Python (see `tests/performance/tests/physics.py` for the scene level benchmarks).
+ * Only built with `WITH_PHYSICS_PERFORMANCE_TESTS`. */
+
+namespace blender::bke::tests {
+
+/** Number of frames simulated by each test. */
+static constexpr int FRAMES_NUM = 25;
+
+class PhysicsPerformanceTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  Depsgraph *depsgraph = nullptr;
+
+ public:
+  static void SetUpTestCase()
+  {
+    CLG_init();
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+    DEG_register_node_types();
+  }
+
+  static void TearDownTestCase()
+  {
+    DEG_free_node_types();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    scene->r.sfra = 1;
+    scene->r.efra = FRAMES_NUM;
+  }
+
+  void TearDown() override
+  {
+    if (depsgraph) {
+      DEG_graph_free(depsgraph);
+    }
+    BKE_main_free(bmain);
+  }
+
+  /** Square grid in the XY plane with about \a verts_num vertices. */
+  Object *add_grid(const char *name, const int verts_num, const float3 location)
+  {
+    const int size = std::max(2, int(std::sqrt(float(verts_num))));
+    const int faces_num = (size - 1) * (size - 1);
+    Mesh *grid = BKE_mesh_new_nomain(size * size, 0, faces_num, faces_num * 4);
+
+    MutableSpan<float3> positions = grid->vert_positions_for_write();
+    for (const int y : IndexRange(size)) {
+      for (const int x : IndexRange(size)) {
+        positions[y * size + x] = float3(float(x) / (size - 1) * 2.0f - 1.0f,
+                                         float(y) / (size - 1) * 2.0f - 1.0f,
+                                         0.0f);
+      }
+    }
+
+    MutableSpan<int> face_offsets = grid->face_offsets_for_write();
+    MutableSpan<int> corner_verts = grid->corner_verts_for_write();
+    int face = 0;
+    for (const int y : IndexRange(size - 1)) {
+      for (const int x : IndexRange(size - 1)) {
+        face_offsets[face] = face * 4;
+        corner_verts[face * 4 + 0] = y * size + x;
+        corner_verts[face * 4 + 1] = y * size + x + 1;
+        corner_verts[face * 4 + 2] = (y + 1) * size + x + 1;
+        corner_verts[face * 4 + 3] = (y + 1) * size + x;
+        face++;
+      }
+    }
+    BKE_mesh_calc_edges(grid, false, false);
+
+    Object *ob = BKE_object_add_only_object(bmain, OB_MESH, name);
+    ob->data = BKE_mesh_add(bmain, name);
+    BKE_mesh_nomain_to_mesh(grid, static_cast<Mesh *>(ob->data), ob);
+    copy_v3_v3(ob->loc, location);
+    BKE_collection_object_add(bmain, scene->master_collection, ob);
+    return ob;
+  }
+
+  ModifierData *add_modifier(Object *ob, const ModifierType type)
+  {
+    ModifierData *md = BKE_modifier_new(type);
+    BLI_addtail(&ob->modifiers, md);
+    BKE_modifier_unique_name(&ob->modifiers, md);
+    if (type == eModifierType_Softbody) {
+      ob->soft = sbNew();
+      ob->softflag |= OB_SB_EDGES;
+    }
+    else if (type == eModifierType_Collision) {
+      ob->pd = BKE_partdeflect_new(PFIELD_NULL);
+      ob->pd->deflect = 1;
+    }
+    return md;
+  }
+
+  void add_effectors(const int effectors_num)
+  {
+    const int types[] = {PFIELD_FORCE, PFIELD_WIND, PFIELD_VORTEX, PFIELD_TURBULENCE};
+    for (const int i : IndexRange(effectors_num)) {
+      Object *ob = BKE_object_add_only_object(bmain, OB_EMPTY, "Field");
+      ob->pd = BKE_partdeflect_new(types[i % ARRAY_SIZE(types)]);
+      ob->pd->f_strength = 2.0f;
+      ob->loc[0] = float(i % 4) - 1.5f;
+      ob->loc[1] = float(i / 4) - 1.5f;
+      ob->loc[2] = 2.0f;
+      BKE_collection_object_add(bmain, scene->master_collection, ob);
+    }
+  }
+
+  void depsgraph_build()
+  {
+    ViewLayer *view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+    depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph);
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+  }
+
+  /** Evaluate all frames in order, which runs the simulations. */
+  void step_frames(const char *name)
+  {
+    SCOPED_TIMER(name);
+    for (const int frame : IndexRange(1, FRAMES_NUM)) {
+      BKE_scene_frame_set(scene, float(frame));
+      BKE_scene_graph_update_for_newframe(depsgraph);
+    }
+  }
+
+  void test_cloth(const int objects_num,
+                  const int verts_num,
+                  const bool use_collision,
+                  const int effectors_num)
+  {
+    for (const int i : IndexRange(objects_num)) {
+      Object *ob = add_grid(
+          "Cloth", verts_num, float3(float(i % 4) * 2.5f, float(i / 4) * 2.5f, 1.0f));
+      ClothModifierData *clmd = reinterpret_cast<ClothModifierData *>(
+          add_modifier(ob, eModifierType_Cloth));
+      if (use_collision) {
+        clmd->coll_parms->flags |= CLOTH_COLLSETTINGS_FLAG_SELF;
+        Object *ob_collider = add_grid(
+            "Collider", 100, float3(float(i % 4) * 2.5f, float(i / 4) * 2.5f, 0.0f));
+        add_modifier(ob_collider, eModifierType_Collision);
+      }
+    }
+    add_effectors(effectors_num);
+    depsgraph_build();
+    step_frames("cloth frame");
+  }
+
+  void test_softbody(const int objects_num, const int verts_num)
+  {
+    for (const int i : IndexRange(objects_num)) {
+      Object *ob = add_grid(
+          "Softbody", verts_num, float3(float(i % 4) * 2.5f, float(i / 4) * 2.5f, 1.0f));
+      add_modifier(ob, eModifierType_Softbody);
+    }
+    depsgraph_build();
+    step_frames("softbody frame");
+  }
+
+  void test_effectors(const int points_num, const int effectors_num)
+  {
+    Object *ob = add_grid("Points", 4, float3(0.0f));
+    add_effectors(effectors_num);
+    depsgraph_build();
+
+    RandomNumberGenerator rng(0);
+    Array<float3> positions(points_num);
+    Array<float3> velocities(points_num, float3(0.0f));
+    for (float3 &position : positions) {
+      position = float3(rng.get_float(), rng.get_float(), rng.get_float()) * 4.0f - 2.0f;
+    }
+
+    EffectorWeights *weights = BKE_effector_add_weights(nullptr);
+    Object *ob_eval = DEG_get_evaluated_object(depsgraph, ob);
+    ListBase *effectors = BKE_effectors_create(depsgraph, ob_eval, nullptr, weights, false);
+
+    Array<float3> forces(points_num, float3(0.0f));
+    {
+      SCOPED_TIMER("BKE_effectors_apply");
+      for (const int i : positions.index_range()) {
+        EffectedPoint point;
+        pd_point_from_loc(scene, positions[i], velocities[i], i, &point);
+        BKE_effectors_apply(effectors, nullptr, weights, &point, forces[i], nullptr, nullptr);
+      }
+    }
+
+    Array<float3> forces_batch(points_num, float3(0.0f));
+    {
+      SCOPED_TIMER("effectors_apply_batch");
+      effectors_apply_batch(
+          effectors, nullptr, weights, scene, positions, velocities, forces_batch, {});
+    }
+    for (const int i : positions.index_range()) {
+      EXPECT_V3_NEAR(forces[i], forces_batch[i], 1e-4f);
+    }
+
+    BKE_effectors_free(effectors);
+    MEM_freeN(weights);
+  }
+
+  void test_point_cache(const int objects_num, const int verts_num)
+  {
+    /* The disk cache of an unsaved file is written to the session temporary directory. */
+    BKE_tempdir_init("");
+    Main *prev_bmain = G_MAIN;
+    G_MAIN = bmain;
+
+    Vector<Object *> objects;
+    for (const int i : IndexRange(objects_num)) {
+      Object *ob = add_grid("Cloth", verts_num, float3(float(i % 4) * 2.5f, 0.0f, 1.0f));
+      ClothModifierData *clmd = reinterpret_cast<ClothModifierData *>(
+          add_modifier(ob, eModifierType_Cloth));
+      clmd->point_cache->flag |= PTCACHE_DISK_CACHE;
+      objects.append(ob);
+    }
+    depsgraph_build();
+    step_frames("cloth frame");
+
+    /* Write the last simulated state to an empty cache for every frame, then read it back. */
+    Vector<PTCacheID> pids;
+    for (Object *ob : objects) {
+      Object *ob_eval = DEG_get_evaluated_object(depsgraph, ob);
+      ClothModifierData *clmd = reinterpret_cast<ClothModifierData *>(
+          BKE_modifiers_findby_type(ob_eval, eModifierType_Cloth));
+      PTCacheID pid;
+      BKE_ptcache_id_from_cloth(&pid, ob_eval, clmd);
+      BKE_ptcache_id_clear(&pid, PTCACHE_CLEAR_ALL, 0);
+      pids.append(pid);
+    }
+    {
+      SCOPED_TIMER("BKE_ptcache_write");
+      for (PTCacheID &pid : pids) {
+        for (const int frame : IndexRange(1, FRAMES_NUM)) {
+          BKE_ptcache_write(&pid, uint(frame));
+        }
+      }
+    }
+    {
+      SCOPED_TIMER("BKE_ptcache_read");
+      for (PTCacheID &pid : pids) {
+        for (const int frame : IndexRange(1, FRAMES_NUM)) {
+          EXPECT_EQ(BKE_ptcache_read(&pid, float(frame), false), PTCACHE_READ_EXACT);
+        }
+      }
+    }
+
+    G_MAIN = prev_bmain;
+    BKE_tempdir_session_purge();
+  }
+};
+
+TEST_F(PhysicsPerformanceTest, cloth_1ob_2500v)
+{
+  test_cloth(1, 2500, false, 0);
+}
+TEST_F(PhysicsPerformanceTest, cloth_1ob_10000v)
+{
+  test_cloth(1, 10000, false, 0);
+}
+TEST_F(PhysicsPerformanceTest, cloth_8ob_2500v)
+{
+  test_cloth(8, 2500, false, 0);
+}
+TEST_F(PhysicsPerformanceTest, cloth_collision_1ob_2500v)
+{
+  test_cloth(1, 2500, true, 0);
+}
+TEST_F(PhysicsPerformanceTest, cloth_collision_4ob_2500v)
+{
+  test_cloth(4, 2500, true, 0);
+}
+TEST_F(PhysicsPerformanceTest, cloth_effectors_1ob_2500v_4eff)
+{
+  test_cloth(1, 2500, false, 4);
+}
+TEST_F(PhysicsPerformanceTest, softbody_1ob_1000v)
+{
+  test_softbody(1, 1000);
+}
+TEST_F(PhysicsPerformanceTest, softbody_4ob_1000v)
+{
+  test_softbody(4, 1000);
+}
+TEST_F(PhysicsPerformanceTest, effectors_100000p_1eff)
+{
+  test_effectors(100000, 1);
+}
+TEST_F(PhysicsPerformanceTest, effectors_100000p_16eff)
+{
+  test_effectors(100000, 16);
+}
+TEST_F(PhysicsPerformanceTest, point_cache_4ob_2500v)
+{
+  test_point_cache(4, 2500);
+}
+
+}  // namespace blender::bke::tests
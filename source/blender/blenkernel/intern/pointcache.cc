@@ -6,11 +6,18 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <cmath>
 #include <cstring>
+#include <memory>
+#include <string>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <vector>
+
+#include <zstd.h>
 
 #include "CLG_log.h"
 
@@ -27,11 +34,15 @@
 #include "DNA_rigidbody_types.h"
 #include "DNA_scene_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_endian_switch.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_map.hh"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -57,6 +68,9 @@
 
 #include "BIK_api.h"
 
+#include "pointcache_container.hh"
+#include "pointcache_delta.hh"
+
 #ifdef WITH_BULLET
 #  include "RBI_api.h"
 #endif
@@ -118,6 +132,7 @@ static int ptcache_extra_datasize[] = {
     0,
     sizeof(ParticleSpring),
     sizeof(float[3]),
+    sizeof(float),
 };
 
 /* forward declarations */
@@ -133,11 +148,11 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
   int error = 0;
 
   /* Custom functions should read these basic elements too! */
-  if (!error && !fread(&pf->totpoint, sizeof(uint), 1, pf->fp)) {
+  if (!error && !ptcache_file_read(pf, &pf->totpoint, 1, sizeof(uint))) {
     error = 1;
   }
 
-  if (!error && !fread(&pf->data_types, sizeof(uint), 1, pf->fp)) {
+  if (!error && !ptcache_file_read(pf, &pf->data_types, 1, sizeof(uint))) {
     error = 1;
   }
 
@@ -146,11 +161,11 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
 static int ptcache_basic_header_write(PTCacheFile *pf)
 {
   /* Custom functions should write these basic elements too! */
-  if (!fwrite(&pf->totpoint, sizeof(uint), 1, pf->fp)) {
+  if (!ptcache_file_write(pf, &pf->totpoint, 1, sizeof(uint))) {
     return 0;
   }
 
-  if (!fwrite(&pf->data_types, sizeof(uint), 1, pf->fp)) {
+  if (!ptcache_file_write(pf, &pf->data_types, 1, sizeof(uint))) {
     return 0;
   }
 
@@ -618,6 +633,13 @@ static void ptcache_cloth_extra_write(void *cloth_v, PTCacheMem *pm, int /*cfra*
   if (!is_zero_v3(cloth->average_acceleration)) {
     ptcache_add_extra_data(pm, BPHYS_EXTRA_CLOTH_ACCELERATION, 1, cloth->average_acceleration);
   }
+
+  /* Step sizes of the frame followed by the step size the next frame starts with. */
+  if (cloth->adaptive_dt > 0.0f) {
+    blender::Vector<float> steps = cloth->adaptive_steps;
+    steps.append(cloth->adaptive_dt);
+    ptcache_add_extra_data(pm, BPHYS_EXTRA_CLOTH_ADAPTIVE_STEPS, uint(steps.size()), steps.data());
+  }
 }
 static void ptcache_cloth_extra_read(void *cloth_v, PTCacheMem *pm, float /*cfra*/)
 {
@@ -626,6 +648,8 @@ static void ptcache_cloth_extra_read(void *cloth_v, PTCacheMem *pm, float /*cfra
   PTCacheExtra *extra = static_cast<PTCacheExtra *>(pm->extradata.first);
 
   zero_v3(cloth->average_acceleration);
+  cloth->adaptive_dt = 0.0f;
+  cloth->adaptive_steps.clear();
 
   for (; extra; extra = extra->next) {
     switch (extra->type) {
@@ -633,6 +657,16 @@ static void ptcache_cloth_extra_read(void *cloth_v, PTCacheMem *pm, float /*cfra
         copy_v3_v3(cloth->average_acceleration, static_cast<const float *>(extra->data));
         break;
       }
+      case BPHYS_EXTRA_CLOTH_ADAPTIVE_STEPS: {
+        /* Continuing the simulation from this frame takes the same steps as an uninterrupted
+         * run. Caches of older versions only store the next step size. */
+        if (extra->totdata > 0) {
+          const float *steps = static_cast<const float *>(extra->data);
+          cloth->adaptive_steps.extend({steps, int64_t(extra->totdata) - 1});
+          cloth->adaptive_dt = steps[extra->totdata - 1];
+        }
+        break;
+      }
     }
   }
 }
@@ -1450,29 +1484,675 @@ static int ptcache_filepath(PTCacheID *pid,
   return len; /* make sure the above string is always 16 chars */
 }
 
-/**
- * Caller must close after!
- */
-static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
-{
-  PTCacheFile *pf;
-  FILE *fp = nullptr;
+/* Single file container, see #PTCACHE_DISK_CONTAINER. */
+
+namespace ptcache_container = blender::bke::pointcache;
+
+/** See #PTCacheFile.container. */
+struct PTCacheContainerRecord {
   char filepath[MAX_PTCACHE_FILE];
+  /** Reading: the mapped container and the record of the frame. */
+  ptcache_container::ContainerReader reader;
+  const ptcache_container::ContainerFrame *record = nullptr;
+  uint64_t pos = 0;
+  /** Writing: the record is collected here and added to the container on close. */
+  blender::Vector<uint8_t> buffer;
+  bool write = false;
+};
 
-#ifndef DURIAN_POINTCACHE_LIB_OK
-  /* don't allow writing for linked objects */
-  if (pid->owner_id->lib && mode == PTCACHE_FILE_WRITE) {
+static bool ptcache_use_container(const PTCacheID *pid)
+{
+  const int flag = pid->cache->flag;
+  return (flag & PTCACHE_DISK_CACHE) && (flag & PTCACHE_DISK_CONTAINER) &&
+         (flag & PTCACHE_EXTERNAL) == 0 && pid->file_type == PTCACHE_FILE_PTCACHE;
+}
+
+static bool ptcache_container_filepath(PTCacheID *pid, char filepath[MAX_PTCACHE_FILE])
+{
+  const int len = ptcache_filepath(pid, filepath, 0, true, false);
+  if (len == 0) {
+    return false;
+  }
+
+  /* PointCaches are inserted in object's list on demand, we need a valid index now. */
+  if (pid->cache->index < 0) {
+    BLI_assert(GS(pid->owner_id->name) == ID_OB);
+    pid->cache->index = pid->stack_index = BKE_object_insert_ptcache((Object *)pid->owner_id);
+  }
+
+  BLI_snprintf(filepath + len,
+               MAX_PTCACHE_FILE - len,
+               "_%02u" PTCACHE_CONTAINER_EXT,
+               uint(pid->stack_index));
+  return true;
+}
+
+/** Report problems writing the container at \a filepath, returns false when the write failed. */
+static bool ptcache_container_status_check(const ptcache_container::ContainerWriteStatus status,
+                                           const char *filepath)
+{
+  switch (status) {
+    case ptcache_container::ContainerWriteStatus::Ok:
+      return true;
+    case ptcache_container::ContainerWriteStatus::InvalidFile:
+      CLOG_ERROR(&LOG,
+                 "'%s' is not a valid point cache container, free the cache to replace it",
+                 filepath);
+      return false;
+    case ptcache_container::ContainerWriteStatus::WriteFailed:
+      CLOG_ERROR(&LOG, "Error writing point cache container '%s'", filepath);
+      return false;
+    case ptcache_container::ContainerWriteStatus::CompactFailed:
+      /* The frames are stored, the unused space is reclaimed by a later compaction. */
+      CLOG_WARN(&LOG, "Failed to replace '%s' with its compacted copy", filepath);
+      return true;
+  }
+  return false;
+}
+
+static PTCacheFile *ptcache_container_file_open(const char *filepath, int mode, int cfra)
+{
+  PTCacheContainerRecord *container = MEM_new<PTCacheContainerRecord>(__func__);
+  STRNCPY(container->filepath, filepath);
+  bool ok = true;
+
+  if (mode == PTCACHE_FILE_READ) {
+    ok = container->reader.open(container->filepath) &&
+         (container->record = container->reader.find(cfra)) != nullptr;
+  }
+  else if (mode == PTCACHE_FILE_WRITE) {
+    container->write = true;
+  }
+  else {
+    /* Records can't be updated in place. */
+    ok = false;
+  }
+
+  if (!ok) {
+    MEM_delete(container);
     return nullptr;
   }
-#endif
+
+  PTCacheFile *pf = static_cast<PTCacheFile *>(MEM_mallocN(sizeof(PTCacheFile), "PTCacheFile"));
+  pf->fp = nullptr;
+  pf->container = container;
+  pf->old_format = 0;
+  pf->frame = cfra;
+
+  return pf;
+}
+
+/**
+ * File that stores frame \a cfra of \a pid, either the frame file or the container.
+ * Returns false when the disk cache can't be used.
+ */
+static bool ptcache_file_target(PTCacheID *pid,
+                                int cfra,
+                                char r_filepath[MAX_PTCACHE_FILE],
+                                bool *r_use_container)
+{
   if ((pid->cache->flag & PTCACHE_EXTERNAL) == 0) {
     const char *blendfile_path = BKE_main_blendfile_path_from_global();
     if (blendfile_path[0] == '\0') {
-      return nullptr; /* save blend file before using disk pointcache */
+      return false; /* save blend file before using disk pointcache */
+    }
+  }
+
+  *r_use_container = ptcache_use_container(pid);
+  if (*r_use_container) {
+    return ptcache_container_filepath(pid, r_filepath);
+  }
+
+  ptcache_filepath(pid, r_filepath, cfra, true, true);
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Delta Encoding
+ *
+ * With #PTCACHE_COMPRESS_ZSTD the locations and velocities of frames between key-frames are
+ * stored relative to the last key-frame. Nearby frames of a simulation share most sign, exponent
+ * and high mantissa bits, so the difference compresses much better than the values themselves.
+ * Lossless deltas XOR the float bits, with a tolerance the difference is quantized instead.
+ *
+ * Key-frames are stored whole. A delta records the key-frame and a hash of the key-frame values it
+ * was made against, reading fails when the key-frame changed since.
+ * \{ */
+
+#define PTCACHE_ZSTD_LEVEL 3
+/** Key-frame distance in cache steps. */
+#define PTCACHE_DELTA_KEYFRAME_INTERVAL 10
+/** Number of key-frames kept in memory. */
+#define PTCACHE_DELTA_REFS_MAX 16
+#define PTCACHE_DELTA_CHANNELS ((1 << BPHYS_DATA_LOCATION) | (1 << BPHYS_DATA_VELOCITY))
+
+/* Compressed block types, following #PTCACHE_COMPRESS_LZO (1) and #PTCACHE_COMPRESS_LZMA (2). */
+#define PTCACHE_BLOCK_ZSTD 3
+#define PTCACHE_BLOCK_DELTA 4
+
+/** Key-frame channels deltas are made against. */
+struct PTCacheDeltaRef {
+  int frame;
+  uint totpoint;
+  /** Hash of the index channel (zero without one), deltas need the same points in same order. */
+  uint index_hash;
+  std::vector<float> data[BPHYS_TOT_DATA];
+  uint hash[BPHYS_TOT_DATA];
+};
+
+struct PTCacheDeltaRefEntry {
+  std::string filepath;
+  int frame;
+  std::shared_ptr<const PTCacheDeltaRef> ref;
+};
+
+/**
+ * Recently written or read key-frames, oldest first. Uses standard containers, entries can
+ * outlive the guarded allocator's leak check.
+ */
+static std::vector<PTCacheDeltaRefEntry> ptcache_delta_refs;
+static ThreadMutex ptcache_delta_refs_mutex = BLI_MUTEX_INITIALIZER;
+
+static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra);
+static void ptcache_mem_clear(PTCacheMem *pm);
+static int ptcache_file_compressed_read_block(PTCacheFile *pf,
+                                              uchar compressed,
+                                              uchar *result,
+                                              uint len);
+
+static int ptcache_delta_keyframe(const PointCache *cache, int cfra)
+{
+  const int interval = max_ii(cache->step, 1) * PTCACHE_DELTA_KEYFRAME_INTERVAL;
+  if (cfra <= cache->startframe) {
+    return cfra;
+  }
+  return cache->startframe + ((cfra - cache->startframe) / interval) * interval;
+}
+
+static uint ptcache_delta_index_hash(const PTCacheMem *pm)
+{
+  if (pm->data[BPHYS_DATA_INDEX] == nullptr) {
+    return 0;
+  }
+  return BLI_hash_mm2(static_cast<const uchar *>(pm->data[BPHYS_DATA_INDEX]),
+                      size_t(pm->totpoint) * ptcache_data_size[BPHYS_DATA_INDEX],
+                      0);
+}
+
+static std::shared_ptr<const PTCacheDeltaRef> ptcache_delta_ref_from_mem(const PTCacheMem *pm)
+{
+  std::shared_ptr<PTCacheDeltaRef> ref = std::make_shared<PTCacheDeltaRef>();
+  ref->frame = pm->frame;
+  ref->totpoint = pm->totpoint;
+  ref->index_hash = ptcache_delta_index_hash(pm);
+
+  for (int i = 0; i < BPHYS_TOT_DATA; i++) {
+    ref->hash[i] = 0;
+    if (pm->data[i] && (PTCACHE_DELTA_CHANNELS & (1 << i))) {
+      const float *values = static_cast<const float *>(pm->data[i]);
+      const size_t values_num = size_t(pm->totpoint) * 3;
+      ref->data[i].assign(values, values + values_num);
+      ref->hash[i] = BLI_hash_mm2(
+          reinterpret_cast<const uchar *>(values), values_num * sizeof(float), 0);
+    }
+  }
+  return ref;
+}
+
+static void ptcache_delta_ref_add(const char *filepath,
+                                  int frame,
+                                  std::shared_ptr<const PTCacheDeltaRef> ref)
+{
+  BLI_mutex_lock(&ptcache_delta_refs_mutex);
+  std::vector<PTCacheDeltaRefEntry> &refs = ptcache_delta_refs;
+  refs.erase(std::remove_if(refs.begin(),
+                            refs.end(),
+                            [&](const PTCacheDeltaRefEntry &entry) {
+                              return entry.frame == frame && entry.filepath == filepath;
+                            }),
+             refs.end());
+  if (refs.size() >= PTCACHE_DELTA_REFS_MAX) {
+    refs.erase(refs.begin());
+  }
+  refs.push_back({filepath, frame, std::move(ref)});
+  BLI_mutex_unlock(&ptcache_delta_refs_mutex);
+}
+
+static std::shared_ptr<const PTCacheDeltaRef> ptcache_delta_ref_find(const char *filepath,
+                                                                     int frame)
+{
+  std::shared_ptr<const PTCacheDeltaRef> ref;
+  BLI_mutex_lock(&ptcache_delta_refs_mutex);
+  for (const PTCacheDeltaRefEntry &entry : ptcache_delta_refs) {
+    if (entry.frame == frame && entry.filepath == filepath) {
+      ref = entry.ref;
+      break;
+    }
+  }
+  BLI_mutex_unlock(&ptcache_delta_refs_mutex);
+  return ref;
+}
+
+/**
+ * Forget the key-frames of \a pid that clearing the cache with \a mode removes, key-frames of
+ * other caches are kept.
+ */
+static void ptcache_delta_refs_remove(PTCacheID *pid, const int mode, const uint cfra)
+{
+  BLI_mutex_lock(&ptcache_delta_refs_mutex);
+  std::vector<PTCacheDeltaRefEntry> &refs = ptcache_delta_refs;
+  refs.erase(std::remove_if(refs.begin(),
+                            refs.end(),
+                            [&](const PTCacheDeltaRefEntry &entry) {
+                              if ((mode == PTCACHE_CLEAR_FRAME && entry.frame != int(cfra)) ||
+                                  (mode == PTCACHE_CLEAR_BEFORE && entry.frame >= int(cfra)) ||
+                                  (mode == PTCACHE_CLEAR_AFTER && entry.frame <= int(cfra)))
+                              {
+                                return false;
+                              }
+                              char filepath[MAX_PTCACHE_FILE];
+                              bool use_container;
+                              return ptcache_file_target(
+                                         pid, entry.frame, filepath, &use_container) &&
+                                     entry.filepath == filepath;
+                            }),
+             refs.end());
+  BLI_mutex_unlock(&ptcache_delta_refs_mutex);
+}
+
+/** Key-frame \a frame of \a pid, read from disk if it isn't in memory. */
+static std::shared_ptr<const PTCacheDeltaRef> ptcache_delta_ref_get(PTCacheID *pid, int frame)
+{
+  char filepath[MAX_PTCACHE_FILE];
+  bool use_container;
+
+  if (!ptcache_file_target(pid, frame, filepath, &use_container)) {
+    return nullptr;
+  }
+  if (std::shared_ptr<const PTCacheDeltaRef> ref = ptcache_delta_ref_find(filepath, frame)) {
+    return ref;
+  }
+
+  PTCacheMem *pm = ptcache_disk_frame_to_mem(pid, frame);
+  if (pm == nullptr) {
+    return nullptr;
+  }
+  std::shared_ptr<const PTCacheDeltaRef> ref = ptcache_delta_ref_from_mem(pm);
+  ptcache_mem_clear(pm);
+  MEM_freeN(pm);
+
+  ptcache_delta_ref_add(filepath, frame, ref);
+  return ref;
+}
+
+/**
+ * Key-frame to delta encode \a pm against, null to store it whole. Key-frames are remembered as
+ * reference for the frames that follow.
+ */
+static std::shared_ptr<const PTCacheDeltaRef> ptcache_delta_ref_for_write(PTCacheID *pid,
+                                                                          const PTCacheMem *pm)
+{
+  if (pid->cache->compression != PTCACHE_COMPRESS_ZSTD ||
+      (pm->data_types & PTCACHE_DELTA_CHANNELS) == 0)
+  {
+    return nullptr;
+  }
+
+  const int keyframe = ptcache_delta_keyframe(pid->cache, pm->frame);
+  if (keyframe == pm->frame) {
+    char filepath[MAX_PTCACHE_FILE];
+    bool use_container;
+    if (ptcache_file_target(pid, keyframe, filepath, &use_container)) {
+      ptcache_delta_ref_add(filepath, keyframe, ptcache_delta_ref_from_mem(pm));
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<const PTCacheDeltaRef> ref = ptcache_delta_ref_get(pid, keyframe);
+  if (ref && ref->totpoint == pm->totpoint && ref->index_hash == ptcache_delta_index_hash(pm)) {
+    return ref;
+  }
+  return nullptr;
+}
+
+static uint32_t ptcache_delta_float_bits(const float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static float ptcache_delta_bits_float(const uint32_t bits)
+{
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+namespace blender::bke::pointcache {
+
+uint8_t delta_encode(const Span<float> values,
+                     const Span<float> ref_values,
+                     const float tolerance,
+                     MutableSpan<uint32_t> r_words)
+{
+  BLI_assert(values.size() == ref_values.size() && values.size() == r_words.size());
+
+  if (tolerance > 0.0f) {
+    bool use_quantize = true;
+    for (const int64_t i : values.index_range()) {
+      const double steps = std::round((double(values[i]) - double(ref_values[i])) / tolerance);
+      if (!(std::abs(steps) < double(1 << 30))) {
+        /* Too far from the key-frame (or not finite), store the values exactly. */
+        use_quantize = false;
+        break;
+      }
+      /* Zig-zag encoding keeps small negative steps small. */
+      const int32_t step = int32_t(steps);
+      r_words[i] = (uint32_t(step) << 1) ^ uint32_t(step >> 31);
+    }
+    if (use_quantize) {
+      return PTCACHE_DELTA_QUANTIZE;
+    }
+  }
+
+  for (const int64_t i : values.index_range()) {
+    r_words[i] = ptcache_delta_float_bits(values[i]) ^ ptcache_delta_float_bits(ref_values[i]);
+  }
+  return PTCACHE_DELTA_XOR;
+}
+
+void delta_decode(const uint8_t mode,
+                  const Span<uint32_t> words,
+                  const Span<float> ref_values,
+                  const float tolerance,
+                  MutableSpan<float> r_values)
+{
+  BLI_assert(words.size() == ref_values.size() && words.size() == r_values.size());
+
+  for (const int64_t i : words.index_range()) {
+    const uint32_t word = words[i];
+    if (mode == PTCACHE_DELTA_QUANTIZE) {
+      const int32_t step = int32_t(word >> 1) ^ -int32_t(word & 1);
+      r_values[i] = ref_values[i] + float(double(step) * tolerance);
+    }
+    else {
+      r_values[i] = ptcache_delta_bits_float(word ^ ptcache_delta_float_bits(ref_values[i]));
+    }
+  }
+}
+
+}  // namespace blender::bke::pointcache
+
+/**
+ * Write \a channel of \a pm as delta against \a ref. Returns false without writing anything when
+ * the channel can't be delta encoded.
+ */
+static bool ptcache_file_delta_write(PTCacheFile *pf,
+                                     const PTCacheMem *pm,
+                                     const int channel,
+                                     const PTCacheDeltaRef &ref,
+                                     const float tolerance)
+{
+  const size_t values_num = size_t(pm->totpoint) * 3;
+  const float *values = static_cast<const float *>(pm->data[channel]);
+
+  if (ref.data[channel].size() != values_num || values_num == 0) {
+    return false;
+  }
+
+  blender::Array<uint32_t> words(values_num);
+  const uchar mode = blender::bke::pointcache::delta_encode(
+      {values, int64_t(values_num)}, ref.data[channel], tolerance, words);
+
+  /* Group the bytes by significance, the high bytes of the deltas are mostly zero. */
+  blender::Array<uint8_t> planes(values_num * 4);
+  for (size_t i = 0; i < values_num; i++) {
+    for (int b = 0; b < 4; b++) {
+      planes[b * values_num + i] = uint8_t(words[i] >> (b * 8));
+    }
+  }
+
+  blender::Array<uint8_t> out(ZSTD_compressBound(planes.size()));
+  const size_t out_len = ZSTD_compress(
+      out.data(), out.size(), planes.data(), planes.size(), PTCACHE_ZSTD_LEVEL);
+  if (ZSTD_isError(out_len)) {
+    return false;
+  }
+
+  const uchar compressed = PTCACHE_BLOCK_DELTA;
+  const int ref_frame = ref.frame;
+  const uint ref_hash = ref.hash[channel];
+  const uint size = uint(out_len);
+  ptcache_file_write(pf, &compressed, 1, sizeof(uchar));
+  ptcache_file_write(pf, &mode, 1, sizeof(uchar));
+  ptcache_file_write(pf, &ref_frame, 1, sizeof(int));
+  ptcache_file_write(pf, &ref_hash, 1, sizeof(uint));
+  ptcache_file_write(pf, &tolerance, 1, sizeof(float));
+  ptcache_file_write(pf, &size, 1, sizeof(uint));
+  ptcache_file_write(pf, out.data(), size, sizeof(uchar));
+  return true;
+}
+
+/** Read a delta block of \a channel into \a pm, the block type is already read. */
+static bool ptcache_file_delta_read(PTCacheFile *pf,
+                                    PTCacheID *pid,
+                                    PTCacheMem *pm,
+                                    const int channel)
+{
+  const size_t values_num = size_t(pm->totpoint) * 3;
+  uchar mode;
+  int ref_frame;
+  uint ref_hash, size;
+  float tolerance;
+
+  if (!ptcache_file_read(pf, &mode, 1, sizeof(uchar)) ||
+      !ptcache_file_read(pf, &ref_frame, 1, sizeof(int)) ||
+      !ptcache_file_read(pf, &ref_hash, 1, sizeof(uint)) ||
+      !ptcache_file_read(pf, &tolerance, 1, sizeof(float)) ||
+      !ptcache_file_read(pf, &size, 1, sizeof(uint)))
+  {
+    return false;
+  }
+
+  blender::Array<uint8_t> in(size);
+  if (size && !ptcache_file_read(pf, in.data(), size, sizeof(uchar))) {
+    return false;
+  }
+
+  /* Key-frames always come first, this also stops reading from recursing. */
+  if ((PTCACHE_DELTA_CHANNELS & (1 << channel)) == 0 || ref_frame >= pm->frame) {
+    return false;
+  }
+  std::shared_ptr<const PTCacheDeltaRef> ref = ptcache_delta_ref_get(pid, ref_frame);
+  if (!ref || ref->totpoint != pm->totpoint || ref->hash[channel] != ref_hash ||
+      ref->data[channel].size() != values_num)
+  {
+    return false;
+  }
+
+  blender::Array<uint8_t> planes(values_num * 4);
+  if (ZSTD_decompress(planes.data(), planes.size(), in.data(), in.size()) != planes.size()) {
+    return false;
+  }
+
+  blender::Array<uint32_t> words(values_num);
+  for (size_t i = 0; i < values_num; i++) {
+    uint32_t word = 0;
+    for (int b = 0; b < 4; b++) {
+      word |= uint32_t(planes[b * values_num + i]) << (b * 8);
+    }
+    words[i] = word;
+  }
+
+  blender::bke::pointcache::delta_decode(
+      mode,
+      words,
+      ref->data[channel],
+      tolerance,
+      {static_cast<float *>(pm->data[channel]), int64_t(values_num)});
+  return true;
+}
+
+/** Read \a channel of \a pm, which may be stored compressed or as delta. */
+static bool ptcache_file_channel_read(PTCacheFile *pf,
+                                      PTCacheID *pid,
+                                      PTCacheMem *pm,
+                                      const int channel)
+{
+  uchar compressed = 0;
+
+  if (!ptcache_file_read(pf, &compressed, 1, sizeof(uchar))) {
+    return false;
+  }
+  if (compressed == PTCACHE_BLOCK_DELTA) {
+    return ptcache_file_delta_read(pf, pid, pm, channel);
+  }
+  return ptcache_file_compressed_read_block(pf,
+                                            compressed,
+                                            static_cast<uchar *>(pm->data[channel]),
+                                            pm->totpoint * ptcache_data_size[channel]) == 0;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Background Writer
+ *
+ * While baking, disk cache frames are handed to worker threads that compress and write them
+ * while the simulation continues with the next frame. The number of frames in flight is bounded
+ * by the number of workers: submitting a frame with all workers busy waits for the oldest one.
+ *
+ * Frames in flight count as existing. Reading or clearing one of them, or any operation on the
+ * whole cache, waits for the pending writes first.
+ * \{ */
+
+#define PTCACHE_WRITE_THREADS_MAX 4
+
+struct PTCacheWriter;
+
+struct PTCacheWriteTask {
+  PTCacheWriteTask *next, *prev;
+  PTCacheWriter *writer;
+
+  /** Owned snapshot of the frame. */
+  PTCacheMem *pm;
+  char filepath[MAX_PTCACHE_FILE];
+  bool use_container;
+  int frame;
+  uint type;
+  int compression;
+  float compression_tolerance;
+  /** Key-frame to delta encode against, see #ptcache_delta_ref_for_write. */
+  std::shared_ptr<const PTCacheDeltaRef> delta_ref;
+  int (*write_header)(PTCacheFile *pf);
+};
+
+struct PTCacheWriter {
+  ListBase threadpool;
+  ListBase tasks;
+  /** Frames are written from depsgraph evaluation, serializes submitting and joining tasks. */
+  ThreadMutex submit_mutex;
+
+  /** Protects #pending and #write_error. */
+  ThreadMutex mutex;
+  ThreadCondition condition;
+  /** Number of queued or running writes by file path and frame. */
+  blender::Map<std::pair<std::string, int>, int> pending;
+  bool write_error;
+};
+
+/** Only set while #BKE_ptcache_bake runs. */
+static PTCacheWriter *ptcache_writer = nullptr;
+
+static bool ptcache_writer_is_pending(const char *filepath, int cfra)
+{
+  PTCacheWriter *writer = ptcache_writer;
+  if (writer == nullptr) {
+    return false;
+  }
+
+  BLI_mutex_lock(&writer->mutex);
+  const bool pending = writer->pending.contains({filepath, cfra});
+  BLI_mutex_unlock(&writer->mutex);
+  return pending;
+}
+
+/** Wait until frame \a cfra stored in \a filepath is written. */
+static void ptcache_writer_wait(const char *filepath, int cfra)
+{
+  PTCacheWriter *writer = ptcache_writer;
+  if (writer == nullptr) {
+    return;
+  }
+
+  const std::pair<std::string, int> key(filepath, cfra);
+  BLI_mutex_lock(&writer->mutex);
+  while (writer->pending.contains(key)) {
+    BLI_condition_wait(&writer->condition, &writer->mutex);
+  }
+  BLI_mutex_unlock(&writer->mutex);
+}
+
+/** Wait until all frames in flight are written. */
+static void ptcache_writer_flush()
+{
+  PTCacheWriter *writer = ptcache_writer;
+  if (writer == nullptr) {
+    return;
+  }
+
+  BLI_mutex_lock(&writer->mutex);
+  while (!writer->pending.is_empty()) {
+    BLI_condition_wait(&writer->condition, &writer->mutex);
+  }
+  BLI_mutex_unlock(&writer->mutex);
+}
+
+/** \} */
+
+/** Frames stored in the container of \a pid including frames in flight, sorted. */
+static blender::Vector<int> ptcache_container_frames(PTCacheID *pid)
+{
+  char filepath[MAX_PTCACHE_FILE];
+  blender::Vector<int> frames;
+
+  if (!ptcache_container_filepath(pid, filepath)) {
+    return frames;
+  }
+
+  for (const ptcache_container::ContainerFrame &entry :
+       ptcache_container::container_index_read(filepath))
+  {
+    frames.append(entry.frame);
+  }
+
+  if (PTCacheWriter *writer = ptcache_writer) {
+    BLI_mutex_lock(&writer->mutex);
+    for (const std::pair<std::string, int> &key : writer->pending.keys()) {
+      if (key.first == filepath) {
+        frames.append(key.second);
+      }
     }
+    BLI_mutex_unlock(&writer->mutex);
+
+    std::sort(frames.begin(), frames.end());
+    frames.resize(std::unique(frames.begin(), frames.end()) - frames.begin());
   }
+  return frames;
+}
 
-  ptcache_filepath(pid, filepath, cfra, true, true);
+static PTCacheFile *ptcache_file_open_filepath(const char *filepath,
+                                               const bool use_container,
+                                               int mode,
+                                               int cfra)
+{
+  PTCacheFile *pf;
+  FILE *fp = nullptr;
+
+  if (use_container) {
+    return ptcache_container_file_open(filepath, mode, cfra);
+  }
 
   if (mode == PTCACHE_FILE_READ) {
     fp = BLI_fopen(filepath, "rb");
@@ -1486,29 +2166,77 @@ static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
     fp = BLI_fopen(filepath, "rb+");
   }
 
-  if (!fp) {
+  if (!fp) {
+    return nullptr;
+  }
+
+  pf = static_cast<PTCacheFile *>(MEM_mallocN(sizeof(PTCacheFile), "PTCacheFile"));
+  pf->fp = fp;
+  pf->container = nullptr;
+  pf->old_format = 0;
+  pf->frame = cfra;
+
+  return pf;
+}
+
+/**
+ * Caller must close after!
+ */
+static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
+{
+  char filepath[MAX_PTCACHE_FILE];
+  bool use_container;
+
+#ifndef DURIAN_POINTCACHE_LIB_OK
+  /* don't allow writing for linked objects */
+  if (pid->owner_id->lib && mode == PTCACHE_FILE_WRITE) {
+    return nullptr;
+  }
+#endif
+  if (!ptcache_file_target(pid, cfra, filepath, &use_container)) {
     return nullptr;
   }
 
-  pf = static_cast<PTCacheFile *>(MEM_mallocN(sizeof(PTCacheFile), "PTCacheFile"));
-  pf->fp = fp;
-  pf->old_format = 0;
-  pf->frame = cfra;
+  ptcache_writer_wait(filepath, cfra);
 
-  return pf;
+  return ptcache_file_open_filepath(filepath, use_container, mode, cfra);
 }
-static void ptcache_file_close(PTCacheFile *pf)
+/** Close \a pf, returns false when writing a container record failed. */
+static bool ptcache_file_close(PTCacheFile *pf)
 {
+  bool ok = true;
   if (pf) {
-    fclose(pf->fp);
+    if (pf->container) {
+      if (pf->container->write) {
+        ok = ptcache_container_status_check(
+            ptcache_container::container_frame_write(
+                pf->container->filepath, pf->frame, pf->container->buffer),
+            pf->container->filepath);
+      }
+      MEM_delete(pf->container);
+    }
+    else {
+      fclose(pf->fp);
+    }
     MEM_freeN(pf);
   }
+  return ok;
 }
 
 static int ptcache_file_compressed_read(PTCacheFile *pf, uchar *result, uint len)
 {
-  int r = 0;
   uchar compressed = 0;
+
+  ptcache_file_read(pf, &compressed, 1, sizeof(uchar));
+  return ptcache_file_compressed_read_block(pf, compressed, result, len);
+}
+/** Read a block stored by #ptcache_file_compressed_write, the block type is already read. */
+static int ptcache_file_compressed_read_block(PTCacheFile *pf,
+                                              uchar compressed,
+                                              uchar *result,
+                                              uint len)
+{
+  int r = 0;
   size_t in_len;
 #ifdef WITH_LZO
   size_t out_len = len;
@@ -1516,7 +2244,6 @@ static int ptcache_file_compressed_read(PTCacheFile *pf, uchar *result, uint len
   uchar *in;
   uchar *props = static_cast<uchar *>(MEM_callocN(sizeof(char[16]), "tmp"));
 
-  ptcache_file_read(pf, &compressed, 1, sizeof(uchar));
   if (compressed) {
     uint size;
     ptcache_file_read(pf, &size, 1, sizeof(uint));
@@ -1542,6 +2269,10 @@ static int ptcache_file_compressed_read(PTCacheFile *pf, uchar *result, uint len
         r = LzmaUncompress(result, &leno, in, &leni, props, sizeOfIt);
       }
 #endif
+      if (compressed == PTCACHE_BLOCK_ZSTD) {
+        const size_t result_len = ZSTD_decompress(result, len, in, in_len);
+        r = (result_len == len) ? 0 : -1;
+      }
       MEM_freeN(in);
     }
   }
@@ -1603,6 +2334,16 @@ static int ptcache_file_compressed_write(
     }
   }
 #endif
+  if (mode == PTCACHE_COMPRESS_ZSTD) {
+    /* Callers size `out` for LZO, which is always at least #ZSTD_compressBound. */
+    out_len = ZSTD_compress(out, LZO_OUT_LEN(in_len), in, in_len, PTCACHE_ZSTD_LEVEL);
+    if (ZSTD_isError(out_len) || (out_len >= in_len)) {
+      compressed = 0;
+    }
+    else {
+      compressed = PTCACHE_BLOCK_ZSTD;
+    }
+  }
 
   ptcache_file_write(pf, &compressed, 1, sizeof(uchar));
   if (compressed) {
@@ -1626,10 +2367,24 @@ static int ptcache_file_compressed_write(
 }
 static int ptcache_file_read(PTCacheFile *pf, void *f, uint tot, uint size)
 {
+  if (pf->container) {
+    PTCacheContainerRecord *container = pf->container;
+    const uint64_t len = uint64_t(tot) * size;
+    if (!container->reader.read(*container->record, f, container->pos, len)) {
+      return 0;
+    }
+    container->pos += len;
+    return 1;
+  }
   return (fread(f, size, tot, pf->fp) == tot);
 }
 static int ptcache_file_write(PTCacheFile *pf, const void *f, uint tot, uint size)
 {
+  if (pf->container) {
+    pf->container->buffer.extend(
+        blender::Span<uint8_t>(static_cast<const uint8_t *>(f), int64_t(tot) * size));
+    return 1;
+  }
   return (fwrite(f, size, tot, pf->fp) == tot);
 }
 static int ptcache_file_data_read(PTCacheFile *pf)
@@ -1666,7 +2421,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 
   pf->data_types = 0;
 
-  if (fread(bphysics, sizeof(char), 8, pf->fp) != 8) {
+  if (!ptcache_file_read(pf, bphysics, 8, sizeof(char))) {
     error = 1;
   }
 
@@ -1674,7 +2429,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
     error = 1;
   }
 
-  if (!error && !fread(&typeflag, sizeof(uint), 1, pf->fp)) {
+  if (!error && !ptcache_file_read(pf, &typeflag, 1, sizeof(uint))) {
     error = 1;
   }
 
@@ -1683,7 +2438,12 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 
   /* if there was an error set file as it was */
   if (error) {
-    BLI_fseek(pf->fp, 0, SEEK_SET);
+    if (pf->container) {
+      pf->container->pos = 0;
+    }
+    else {
+      BLI_fseek(pf->fp, 0, SEEK_SET);
+    }
   }
 
   return !error;
@@ -1693,11 +2453,11 @@ static int ptcache_file_header_begin_write(PTCacheFile *pf)
   const char *bphysics = "BPHYSICS";
   uint typeflag = pf->type + pf->flag;
 
-  if (fwrite(bphysics, sizeof(char), 8, pf->fp) != 8) {
+  if (!ptcache_file_write(pf, bphysics, 8, sizeof(char))) {
     return 0;
   }
 
-  if (!fwrite(&typeflag, sizeof(uint), 1, pf->fp)) {
+  if (!ptcache_file_write(pf, &typeflag, 1, sizeof(uint))) {
     return 0;
   }
 
@@ -1878,7 +2638,29 @@ static int ptcache_old_elemsize(PTCacheID *pid)
 
 static void ptcache_find_frames_around(PTCacheID *pid, uint frame, int *fra1, int *fra2)
 {
-  if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+  if (ptcache_use_container(pid)) {
+    /* One index read instead of probing the container for every frame. */
+    const blender::Vector<int> frames = ptcache_container_frames(pid);
+    const int *next = std::upper_bound(frames.begin(), frames.end(), int(frame));
+    int cfra1 = 0, cfra2 = 0;
+
+    if (next != frames.begin() && *(next - 1) >= pid->cache->startframe) {
+      cfra1 = *(next - 1);
+    }
+    if (next != frames.end() && *next <= pid->cache->endframe) {
+      cfra2 = *next;
+    }
+
+    if (cfra1 && !cfra2) {
+      *fra1 = 0;
+      *fra2 = cfra1;
+    }
+    else {
+      *fra1 = cfra1;
+      *fra2 = cfra2;
+    }
+  }
+  else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
     int cfra1 = frame, cfra2 = frame + 1;
 
     while (cfra1 >= pid->cache->startframe && !BKE_ptcache_id_exist(pid, cfra1)) {
@@ -1963,9 +2745,9 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
 
     if (pf->flag & PTCACHE_TYPEFLAG_COMPRESS) {
       for (i = 0; i < BPHYS_TOT_DATA; i++) {
-        uint out_len = pm->totpoint * ptcache_data_size[i];
-        if (pf->data_types & (1 << i)) {
-          ptcache_file_compressed_read(pf, (uchar *)(pm->data[i]), out_len);
+        if ((pf->data_types & (1 << i)) && !ptcache_file_channel_read(pf, pid, pm, i)) {
+          error = 1;
+          break;
         }
       }
     }
@@ -2025,47 +2807,49 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
 
   return pm;
 }
-static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
+/**
+ * Write \a pm to the opened file and close it. Doesn't access the #PTCacheID, so it can run on the
+ * background writer threads.
+ */
+static int ptcache_mem_frame_write(PTCacheFile *pf,
+                                   PTCacheMem *pm,
+                                   const uint type,
+                                   const int compression,
+                                   const float compression_tolerance,
+                                   const PTCacheDeltaRef *delta_ref,
+                                   int (*write_header)(PTCacheFile *pf))
 {
-  PTCacheFile *pf = nullptr;
   uint i, error = 0;
 
-  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, pm->frame);
-
-  pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, pm->frame);
-
-  if (pf == nullptr) {
-    if (G.debug & G_DEBUG) {
-      printf("Error opening disk cache file for writing\n");
-    }
-    return 0;
-  }
-
   pf->data_types = pm->data_types;
   pf->totpoint = pm->totpoint;
-  pf->type = pid->type;
+  pf->type = type;
   pf->flag = 0;
 
   if (pm->extradata.first) {
     pf->flag |= PTCACHE_TYPEFLAG_EXTRADATA;
   }
 
-  if (pid->cache->compression) {
+  if (compression) {
     pf->flag |= PTCACHE_TYPEFLAG_COMPRESS;
   }
 
-  if (!ptcache_file_header_begin_write(pf) || !pid->write_header(pf)) {
+  if (!ptcache_file_header_begin_write(pf) || !write_header(pf)) {
     error = 1;
   }
 
   if (!error) {
-    if (pid->cache->compression) {
+    if (compression) {
       for (i = 0; i < BPHYS_TOT_DATA; i++) {
         if (pm->data[i]) {
+          if (delta_ref && (PTCACHE_DELTA_CHANNELS & (1 << i)) &&
+              ptcache_file_delta_write(pf, pm, i, *delta_ref, compression_tolerance))
+          {
+            continue;
+          }
           uint in_len = pm->totpoint * ptcache_data_size[i];
           uchar *out = (uchar *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
-          ptcache_file_compressed_write(
-              pf, (uchar *)(pm->data[i]), in_len, out, pid->cache->compression);
+          ptcache_file_compressed_write(pf, (uchar *)(pm->data[i]), in_len, out, compression);
           MEM_freeN(out);
         }
       }
@@ -2097,11 +2881,10 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
       ptcache_file_write(pf, &extra->type, 1, sizeof(uint));
       ptcache_file_write(pf, &extra->totdata, 1, sizeof(uint));
 
-      if (pid->cache->compression) {
+      if (compression) {
         uint in_len = extra->totdata * ptcache_extra_datasize[extra->type];
         uchar *out = (uchar *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
-        ptcache_file_compressed_write(
-            pf, (uchar *)(extra->data), in_len, out, pid->cache->compression);
+        ptcache_file_compressed_write(pf, (uchar *)(extra->data), in_len, out, compression);
         MEM_freeN(out);
       }
       else {
@@ -2110,7 +2893,9 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
     }
   }
 
-  ptcache_file_close(pf);
+  if (!ptcache_file_close(pf)) {
+    error = 1;
+  }
 
   if (error && G.debug & G_DEBUG) {
     printf("Error writing to disk cache\n");
@@ -2118,6 +2903,210 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
 
   return error == 0;
 }
+static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
+{
+  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, pm->frame);
+
+  const std::shared_ptr<const PTCacheDeltaRef> delta_ref = ptcache_delta_ref_for_write(pid, pm);
+  PTCacheFile *pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, pm->frame);
+
+  if (pf == nullptr) {
+    if (G.debug & G_DEBUG) {
+      printf("Error opening disk cache file for writing\n");
+    }
+    return 0;
+  }
+
+  return ptcache_mem_frame_write(pf,
+                                 pm,
+                                 pid->type,
+                                 pid->cache->compression,
+                                 pid->cache->compression_tolerance,
+                                 delta_ref.get(),
+                                 pid->write_header);
+}
+
+/**
+ * Store the frames from \a cfra to the next key-frame whole, so the ones delta encoded against a
+ * key-frame before \a cfra stay readable when the frames before \a cfra are cleared.
+ */
+static void ptcache_delta_dependents_store_whole(PTCacheID *pid, const int cfra)
+{
+  PointCache *cache = pid->cache;
+  const int keyframe = ptcache_delta_keyframe(cache, cfra);
+  if (keyframe == cfra) {
+    return;
+  }
+
+  const int keyframe_next = keyframe + max_ii(cache->step, 1) * PTCACHE_DELTA_KEYFRAME_INTERVAL;
+  for (int frame = cfra; frame < keyframe_next; frame++) {
+    if (!BKE_ptcache_id_exist(pid, frame)) {
+      continue;
+    }
+    /* Decoded while the key-frame still exists. */
+    PTCacheMem *pm = ptcache_disk_frame_to_mem(pid, frame);
+    if (pm == nullptr) {
+      continue;
+    }
+
+    BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, frame);
+    PTCacheFile *pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, frame);
+    if (pf && ptcache_mem_frame_write(pf,
+                                      pm,
+                                      pid->type,
+                                      cache->compression,
+                                      cache->compression_tolerance,
+                                      nullptr,
+                                      pid->write_header))
+    {
+      if (cache->cached_frames) {
+        cache->cached_frames[frame - cache->startframe] = 1;
+      }
+    }
+    ptcache_mem_clear(pm);
+    MEM_freeN(pm);
+  }
+}
+
+/* Background writer. */
+
+static void *ptcache_write_task(void *userdata)
+{
+  PTCacheWriteTask *task = static_cast<PTCacheWriteTask *>(userdata);
+  PTCacheWriter *writer = task->writer;
+
+  PTCacheFile *pf = ptcache_file_open_filepath(
+      task->filepath, task->use_container, PTCACHE_FILE_WRITE, task->frame);
+  const bool ok = pf && ptcache_mem_frame_write(pf,
+                                                task->pm,
+                                                task->type,
+                                                task->compression,
+                                                task->compression_tolerance,
+                                                task->delta_ref.get(),
+                                                task->write_header);
+
+  ptcache_mem_clear(task->pm);
+  MEM_freeN(task->pm);
+  task->pm = nullptr;
+  task->delta_ref.reset();
+
+  BLI_mutex_lock(&writer->mutex);
+  const std::pair<std::string, int> key(task->filepath, task->frame);
+  int &count = writer->pending.lookup(key);
+  if (--count == 0) {
+    writer->pending.remove(key);
+  }
+  if (!ok) {
+    writer->write_error = true;
+  }
+  BLI_mutex_unlock(&writer->mutex);
+  BLI_condition_notify_all(&writer->condition);
+
+  return nullptr;
+}
+
+static void ptcache_writer_begin()
+{
+  BLI_assert(ptcache_writer == nullptr);
+
+  const int num_threads = min_ii(BLI_system_thread_count() - 1, PTCACHE_WRITE_THREADS_MAX);
+  if (num_threads < 1) {
+    /* Writing in the background only pays off with a spare thread. */
+    return;
+  }
+
+  PTCacheWriter *writer = MEM_new<PTCacheWriter>(__func__);
+  BLI_threadpool_init(&writer->threadpool, ptcache_write_task, num_threads);
+  BLI_listbase_clear(&writer->tasks);
+  BLI_mutex_init(&writer->submit_mutex);
+  BLI_mutex_init(&writer->mutex);
+  BLI_condition_init(&writer->condition);
+  writer->write_error = false;
+
+  ptcache_writer = writer;
+}
+
+/** Wait for all frames in flight and stop the workers. */
+static void ptcache_writer_end()
+{
+  PTCacheWriter *writer = ptcache_writer;
+  if (writer == nullptr) {
+    return;
+  }
+
+  BLI_threadpool_end(&writer->threadpool);
+  LISTBASE_FOREACH_MUTABLE (PTCacheWriteTask *, task, &writer->tasks) {
+    MEM_delete(task);
+  }
+  BLI_listbase_clear(&writer->tasks);
+  ptcache_writer = nullptr;
+
+  if (writer->write_error) {
+    CLOG_ERROR(&LOG, "Error writing to disk cache");
+  }
+
+  BLI_mutex_end(&writer->submit_mutex);
+  BLI_mutex_end(&writer->mutex);
+  BLI_condition_end(&writer->condition);
+  MEM_delete(writer);
+}
+
+/**
+ * Write \a pm to disk and free it. While baking this happens on the background writer threads,
+ * errors are reported when the bake ends.
+ */
+static int ptcache_mem_frame_to_disk_and_free(PTCacheID *pid, PTCacheMem *pm)
+{
+  PTCacheWriter *writer = ptcache_writer;
+  char filepath[MAX_PTCACHE_FILE];
+  bool use_container;
+
+  if (writer == nullptr) {
+    const int ok = ptcache_mem_frame_to_disk(pid, pm);
+    ptcache_mem_clear(pm);
+    MEM_freeN(pm);
+    return ok;
+  }
+
+  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, pm->frame);
+
+  if (!ptcache_file_target(pid, pm->frame, filepath, &use_container)) {
+    ptcache_mem_clear(pm);
+    MEM_freeN(pm);
+    return 0;
+  }
+
+  PTCacheWriteTask *task = MEM_new<PTCacheWriteTask>(__func__);
+  task->writer = writer;
+  task->pm = pm;
+  STRNCPY(task->filepath, filepath);
+  task->use_container = use_container;
+  task->frame = pm->frame;
+  task->type = pid->type;
+  task->compression = pid->cache->compression;
+  task->compression_tolerance = pid->cache->compression_tolerance;
+  task->delta_ref = ptcache_delta_ref_for_write(pid, pm);
+  task->write_header = pid->write_header;
+
+  BLI_mutex_lock(&writer->mutex);
+  writer->pending.lookup_or_add({filepath, task->frame}, 0)++;
+  BLI_mutex_unlock(&writer->mutex);
+
+  BLI_mutex_lock(&writer->submit_mutex);
+  BLI_addtail(&writer->tasks, task);
+  /* With all workers busy wait for the oldest task, this bounds the frames in flight. */
+  if (!BLI_available_threads(&writer->threadpool)) {
+    PTCacheWriteTask *first_task = static_cast<PTCacheWriteTask *>(writer->tasks.first);
+    BLI_assert(first_task != task);
+    BLI_threadpool_remove(&writer->threadpool, first_task);
+    BLI_remlink(&writer->tasks, first_task);
+    MEM_delete(first_task);
+  }
+  BLI_threadpool_insert(&writer->threadpool, task);
+  BLI_mutex_unlock(&writer->submit_mutex);
+
+  return 1;
+}
 
 static int ptcache_read_stream(PTCacheID *pid, int cfra)
 {
@@ -2406,7 +3395,9 @@ static int ptcache_write_stream(PTCacheID *pid, int cfra, int totpoint)
     pid->write_stream(pf, pid->calldata);
   }
 
-  ptcache_file_close(pf);
+  if (!ptcache_file_close(pf)) {
+    error = 1;
+  }
 
   if (error && G.debug & G_DEBUG) {
     printf("Error writing to disk cache\n");
@@ -2468,18 +3459,10 @@ static int ptcache_write(PTCacheID *pid, int cfra, int overwrite)
   pm->frame = cfra;
 
   if (cache->flag & PTCACHE_DISK_CACHE) {
-    error += !ptcache_mem_frame_to_disk(pid, pm);
-
-    // if (pm) /* pm is always set */
-    {
-      ptcache_mem_clear(pm);
-      MEM_freeN(pm);
-    }
+    error += !ptcache_mem_frame_to_disk_and_free(pid, pm);
 
     if (pm2) {
-      error += !ptcache_mem_frame_to_disk(pid, pm2);
-      ptcache_mem_clear(pm2);
-      MEM_freeN(pm2);
+      error += !ptcache_mem_frame_to_disk_and_free(pid, pm2);
     }
   }
   else {
@@ -2625,12 +3608,56 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, uint cfra)
   }
 #endif
 
+  if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+    if (mode == PTCACHE_CLEAR_FRAME) {
+      bool use_container;
+      if (ptcache_file_target(pid, cfra, filepath, &use_container)) {
+        ptcache_writer_wait(filepath, cfra);
+      }
+    }
+    else {
+      ptcache_writer_flush();
+      if (mode == PTCACHE_CLEAR_BEFORE) {
+        ptcache_delta_dependents_store_whole(pid, int(cfra));
+      }
+    }
+    ptcache_delta_refs_remove(pid, mode, cfra);
+  }
+
   /* Clear all files in the temp dir with the prefix of the ID and the `.bphys` suffix. */
   switch (mode) {
     case PTCACHE_CLEAR_ALL:
     case PTCACHE_CLEAR_BEFORE:
     case PTCACHE_CLEAR_AFTER:
-      if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+      if (ptcache_use_container(pid)) {
+        if (!ptcache_container_filepath(pid, filepath) || !BLI_exists(filepath)) {
+          return;
+        }
+
+        if (mode == PTCACHE_CLEAR_ALL) {
+          pid->cache->last_exact = MIN2(pid->cache->startframe, 0);
+          ptcache_container::container_close(filepath);
+          BLI_delete(filepath, false, false);
+          if (pid->cache->cached_frames) {
+            memset(pid->cache->cached_frames, 0, MEM_allocN_len(pid->cache->cached_frames));
+          }
+        }
+        else {
+          /* Removed records are reclaimed by compacting the container. */
+          ptcache_container::container_frames_remove(filepath, [&](const int frame) {
+            if ((mode == PTCACHE_CLEAR_BEFORE && frame < int(cfra)) ||
+                (mode == PTCACHE_CLEAR_AFTER && frame > int(cfra)))
+            {
+              if (pid->cache->cached_frames && frame >= int(sta) && frame <= int(end)) {
+                pid->cache->cached_frames[frame - sta] = 0;
+              }
+              return true;
+            }
+            return false;
+          });
+        }
+      }
+      else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
         ptcache_path(pid, path);
 
         dir = opendir(path);
@@ -2720,7 +3747,13 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, uint cfra)
       break;
 
     case PTCACHE_CLEAR_FRAME:
-      if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+      if (ptcache_use_container(pid)) {
+        if (ptcache_container_filepath(pid, filepath) && BLI_exists(filepath)) {
+          ptcache_container::container_frames_remove(
+              filepath, [&](const int frame) { return frame == int(cfra); });
+        }
+      }
+      else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
         if (BKE_ptcache_id_exist(pid, cfra)) {
           ptcache_filepath(pid, filepath, cfra, true, true); /* no path */
           BLI_delete(filepath, false, false);
@@ -2760,12 +3793,21 @@ bool BKE_ptcache_id_exist(PTCacheID *pid, int cfra)
     return false;
   }
 
+  if (ptcache_use_container(pid)) {
+    char filepath[MAX_PTCACHE_FILE];
+    if (!ptcache_container_filepath(pid, filepath)) {
+      return false;
+    }
+    return ptcache_writer_is_pending(filepath, cfra) ||
+           ptcache_container::container_frame_exists(filepath, cfra);
+  }
+
   if (pid->cache->flag & PTCACHE_DISK_CACHE) {
     char filepath[MAX_PTCACHE_FILE];
 
     ptcache_filepath(pid, filepath, cfra, true, true);
 
-    return BLI_exists(filepath);
+    return ptcache_writer_is_pending(filepath, cfra) || BLI_exists(filepath);
   }
 
   PTCacheMem *pm = static_cast<PTCacheMem *>(pid->cache->mem_cache.first);
@@ -2828,7 +3870,14 @@ void BKE_ptcache_id_time(
     cache->cached_frames = static_cast<char *>(
         MEM_callocN(sizeof(char) * cache->cached_frames_len, "cached frames array"));
 
-    if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+    if (ptcache_use_container(pid)) {
+      for (const int frame : ptcache_container_frames(pid)) {
+        if (frame >= int(sta) && frame <= int(end)) {
+          cache->cached_frames[frame - sta] = 1;
+        }
+      }
+    }
+    else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
       /* mode is same as fopen's modes */
       DIR *dir;
       dirent *de;
@@ -2837,6 +3886,9 @@ void BKE_ptcache_id_time(
       char ext[MAX_PTCACHE_FILE];
       uint len; /* store the length of the string */
 
+      /* Frames in flight may not have a file yet. */
+      ptcache_writer_flush();
+
       ptcache_path(pid, path);
 
       len = ptcache_filepath(pid, filepath, int(cfra), false, false); /* no path */
@@ -3295,6 +4347,10 @@ void BKE_ptcache_bake(PTCacheBaker *baker)
 
   stime = ptime = PIL_check_seconds_timer();
 
+  /* Containers stay open while baking, their indices are written once at the end. */
+  ptcache_container::container_write_begin();
+  ptcache_writer_begin();
+
   for (int fr = scene->r.cfra; fr <= endframe; fr += baker->quick_step, scene->r.cfra = fr) {
     BKE_scene_graph_update_for_newframe(depsgraph);
 
@@ -3337,6 +4393,12 @@ void BKE_ptcache_bake(PTCacheBaker *baker)
     scene->r.cfra += 1;
   }
 
+  /* Finish writing the baked frames, also when canceled. */
+  ptcache_writer_end();
+  if (!ptcache_container::container_write_end()) {
+    CLOG_ERROR(&LOG, "Error writing point cache container indices");
+  }
+
   if (use_timer) {
     /* start with newline because of \r above */
     ptcache_dt_to_str(run, sizeof(run), PIL_check_seconds_timer() - stime);
@@ -3500,6 +4562,60 @@ void BKE_ptcache_toggle_disk_cache(PTCacheID *pid)
   }
 }
 
+void BKE_ptcache_toggle_disk_container(PTCacheID *pid)
+{
+  PointCache *cache = pid->cache;
+  int last_exact = cache->last_exact;
+  int baked = cache->flag & PTCACHE_BAKED;
+  ListBase mem_cache = {nullptr, nullptr};
+
+  if ((cache->flag & PTCACHE_DISK_CACHE) == 0) {
+    return;
+  }
+
+  /* Read the frames in the previous layout. */
+  cache->flag ^= PTCACHE_DISK_CONTAINER;
+
+  for (int cfra = cache->startframe; cfra <= cache->endframe; cfra++) {
+    PTCacheMem *pm = ptcache_disk_frame_to_mem(pid, cfra);
+
+    if (pm) {
+      BLI_addtail(&mem_cache, pm);
+    }
+  }
+
+  /* Remove possible bake flag to allow clear */
+  cache->flag &= ~PTCACHE_BAKED;
+  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_ALL, 0);
+
+  cache->flag ^= PTCACHE_DISK_CONTAINER;
+
+  LISTBASE_FOREACH (PTCacheMem *, pm, &mem_cache) {
+    if (ptcache_mem_frame_to_disk(pid, pm) == 0) {
+      break;
+    }
+  }
+  BKE_ptcache_free_mem(&mem_cache);
+
+  /* restore possible bake flag */
+  cache->flag |= baked;
+  cache->last_exact = last_exact;
+
+  /* write info file */
+  if (cache->flag & PTCACHE_BAKED) {
+    BKE_ptcache_write(pid, 0);
+  }
+
+  if (cache->cached_frames) {
+    MEM_freeN(cache->cached_frames);
+    cache->cached_frames = nullptr;
+    cache->cached_frames_len = 0;
+  }
+  BKE_ptcache_id_time(pid, nullptr, 0.0f, nullptr, nullptr, nullptr);
+
+  cache->flag |= PTCACHE_FLAG_INFO_DIRTY;
+}
+
 void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const char *name_dst)
 {
   char old_name[80];
@@ -3518,9 +4634,27 @@ void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const c
     return;
   }
 
+  ptcache_writer_flush();
+
   /* save old name */
   STRNCPY(old_name, pid->cache->name);
 
+  if (ptcache_use_container(pid)) {
+    char new_container[MAX_PTCACHE_FILE];
+
+    STRNCPY(pid->cache->name, name_src);
+    const bool has_src = ptcache_container_filepath(pid, old_path_full);
+    STRNCPY(pid->cache->name, name_dst);
+    if (has_src && ptcache_container_filepath(pid, new_container) && BLI_exists(old_path_full)) {
+      ptcache_container_status_check(ptcache_container::container_close(old_path_full),
+                                     old_path_full);
+      BLI_rename_overwrite(old_path_full, new_container);
+    }
+
+    STRNCPY(pid->cache->name, old_name);
+    return;
+  }
+
   /* get "from" filename */
   STRNCPY(pid->cache->name, name_src);
 
@@ -3711,6 +4845,15 @@ void BKE_ptcache_update_info(PTCacheID *pid)
         SNPRINTF(mem_info, TIP_("%i cells cached"), totpoint);
       }
     }
+    else if (ptcache_use_container(pid)) {
+      for (const int frame : ptcache_container_frames(pid)) {
+        if (frame >= cache->startframe && frame <= cache->endframe) {
+          totframes++;
+        }
+      }
+
+      SNPRINTF(mem_info, TIP_("%i frames on disk"), totframes);
+    }
     else {
       int cfra = cache->startframe;
 
@@ -3792,6 +4935,7 @@ static const char *ptcache_extra_struct[] = {
     "",
     "ParticleSpring",
     "vec3f",
+    "vec2f",
 };
 void BKE_ptcache_blend_write(BlendWriter *writer, ListBase *ptcaches)
 {
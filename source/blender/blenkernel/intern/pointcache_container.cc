@@ -0,0 +1,632 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "BLI_fileops.h"
+#include "BLI_map.hh"
+#include "BLI_mmap.h"
+
+#include "pointcache_container.hh"
+
+namespace blender::bke::pointcache {
+
+static const char container_magic[8] = {'B', 'P', 'H', 'Y', 'S', 'C', 'O', 'N'};
+static const char index_magic[8] = {'B', 'P', 'H', 'Y', 'S', 'I', 'D', 'X'};
+
+static constexpr uint32_t CONTAINER_VERSION = 1;
+static constexpr uint64_t CONTAINER_HEADER_SIZE = sizeof(container_magic);
+
+/** Last bytes of every container. */
+struct ContainerTrailer {
+  uint64_t index_offset;
+  uint32_t frames_num;
+  uint32_t version;
+  char magic[8];
+};
+
+/**
+ * Guards all container file access, frames can be written by the point cache background writer
+ * while the simulation reads and clears frames of the same container.
+ */
+static std::mutex container_mutex;
+
+static_assert(sizeof(ContainerFrame) == 24, "Container index entries are stored as is");
+static_assert(sizeof(ContainerTrailer) == 24, "Container trailer is stored as is");
+
+using ReadFn = FunctionRef<bool(void *dst, uint64_t offset, uint64_t size)>;
+
+/** Read the index of the trailer ending at \a trailer_end, false if there is no valid one. */
+static bool container_trailer_parse(const uint64_t trailer_end,
+                                    ReadFn read_fn,
+                                    Vector<ContainerFrame> &r_index,
+                                    uint64_t &r_index_offset)
+{
+  ContainerTrailer trailer;
+  if (trailer_end < CONTAINER_HEADER_SIZE + sizeof(ContainerTrailer) ||
+      !read_fn(&trailer, trailer_end - sizeof(ContainerTrailer), sizeof(ContainerTrailer)) ||
+      memcmp(trailer.magic, index_magic, sizeof(index_magic)) != 0 ||
+      trailer.version != CONTAINER_VERSION)
+  {
+    return false;
+  }
+
+  const uint64_t index_size = uint64_t(trailer.frames_num) * sizeof(ContainerFrame);
+  if (trailer.index_offset < CONTAINER_HEADER_SIZE ||
+      trailer.index_offset + index_size != trailer_end - sizeof(ContainerTrailer))
+  {
+    return false;
+  }
+
+  r_index.resize(trailer.frames_num);
+  if (index_size && !read_fn(r_index.data(), trailer.index_offset, index_size)) {
+    return false;
+  }
+  for (const ContainerFrame &entry : r_index) {
+    if (entry.offset < CONTAINER_HEADER_SIZE || entry.offset + entry.size > trailer.index_offset) {
+      return false;
+    }
+  }
+
+  r_index_offset = trailer.index_offset;
+  return true;
+}
+
+static bool container_index_parse(const uint64_t file_size,
+                                  ReadFn read_fn,
+                                  Vector<ContainerFrame> &r_index,
+                                  uint64_t &r_index_offset)
+{
+  char magic[8];
+  if (file_size < CONTAINER_HEADER_SIZE + sizeof(ContainerTrailer)) {
+    return false;
+  }
+  if (!read_fn(magic, 0, sizeof(magic)) || memcmp(magic, container_magic, sizeof(magic)) != 0) {
+    return false;
+  }
+  if (container_trailer_parse(file_size, read_fn, r_index, r_index_offset)) {
+    return true;
+  }
+
+  /* A write was interrupted before its trailer was complete. Every write appends a complete
+   * index and trailer, so the last valid trailer before the torn data holds the last state. */
+  constexpr uint64_t block_size = 1 << 16;
+  Vector<char> block(block_size + sizeof(index_magic));
+  uint64_t block_end = file_size;
+  while (block_end > CONTAINER_HEADER_SIZE) {
+    const uint64_t block_start = std::max(block_end - std::min(block_end, block_size),
+                                          CONTAINER_HEADER_SIZE);
+    /* Overlap with the next block, so magic values crossing the block boundary are found. */
+    const uint64_t read_end = std::min(block_end + sizeof(index_magic), file_size);
+    if (!read_fn(block.data(), block_start, read_end - block_start)) {
+      return false;
+    }
+    for (int64_t i = int64_t(block_end - block_start) - 1; i >= 0; i--) {
+      if (uint64_t(i) + sizeof(index_magic) > read_end - block_start ||
+          memcmp(&block[i], index_magic, sizeof(index_magic)) != 0)
+      {
+        continue;
+      }
+      const uint64_t trailer_end = block_start + uint64_t(i) + sizeof(index_magic);
+      if (container_trailer_parse(trailer_end, read_fn, r_index, r_index_offset)) {
+        return true;
+      }
+    }
+    block_end = block_start;
+  }
+  return false;
+}
+
+static bool container_index_parse(FILE *fp,
+                                  const uint64_t file_size,
+                                  Vector<ContainerFrame> &r_index,
+                                  uint64_t &r_index_offset)
+{
+  return container_index_parse(
+      file_size,
+      [&](void *dst, const uint64_t offset, const uint64_t size) {
+        return BLI_fseek(fp, int64_t(offset), SEEK_SET) == 0 && fread(dst, 1, size, fp) == size;
+      },
+      r_index,
+      r_index_offset);
+}
+
+/**
+ * Write \a index followed by the trailer at \a index_offset, which is the end of the file.
+ * Existing data is never overwritten. The trailer is written last, once everything it refers to
+ * is written, so an interrupted write leaves the previous index and trailer intact.
+ */
+static bool container_index_write(FILE *fp,
+                                  const Span<ContainerFrame> index,
+                                  const uint64_t index_offset)
+{
+  ContainerTrailer trailer;
+  trailer.index_offset = index_offset;
+  trailer.frames_num = uint32_t(index.size());
+  trailer.version = CONTAINER_VERSION;
+  memcpy(trailer.magic, index_magic, sizeof(index_magic));
+
+  if (BLI_fseek(fp, int64_t(index_offset), SEEK_SET) != 0) {
+    return false;
+  }
+  if (fwrite(index.data(), sizeof(ContainerFrame), size_t(index.size()), fp) != index.size()) {
+    return false;
+  }
+  if (fflush(fp) != 0) {
+    return false;
+  }
+  if (fwrite(&trailer, sizeof(ContainerTrailer), 1, fp) != 1) {
+    return false;
+  }
+  return fflush(fp) == 0;
+}
+
+/** Whether more than half of the file is taken by replaced records and old indices. */
+static bool container_needs_compact(const Span<ContainerFrame> index, const uint64_t file_size)
+{
+  uint64_t live_size = CONTAINER_HEADER_SIZE + index.size_in_bytes() + sizeof(ContainerTrailer);
+  for (const ContainerFrame &entry : index) {
+    live_size += entry.size;
+  }
+  return file_size > 2 * live_size;
+}
+
+/** Copy the records in \a index from \a fp_src to a new file at \a filepath_dst. */
+static bool container_compact(FILE *fp_src, const char *filepath_dst, Span<ContainerFrame> index)
+{
+  FILE *fp_dst = BLI_fopen(filepath_dst, "wb");
+  if (fp_dst == nullptr) {
+    return false;
+  }
+
+  Vector<ContainerFrame> index_dst(index);
+  Vector<char> buffer(1 << 16);
+  bool ok = fwrite(container_magic, 1, sizeof(container_magic), fp_dst) ==
+            sizeof(container_magic);
+  uint64_t offset = CONTAINER_HEADER_SIZE;
+
+  for (ContainerFrame &entry : index_dst) {
+    if (!ok) {
+      break;
+    }
+    ok = BLI_fseek(fp_src, int64_t(entry.offset), SEEK_SET) == 0;
+    for (uint64_t copied = 0; ok && copied < entry.size;) {
+      const size_t len = size_t(std::min<uint64_t>(entry.size - copied, buffer.size()));
+      ok = fread(buffer.data(), 1, len, fp_src) == len &&
+           fwrite(buffer.data(), 1, len, fp_dst) == len;
+      copied += len;
+    }
+    entry.offset = offset;
+    offset += entry.size;
+  }
+
+  ok = ok && container_index_write(fp_dst, index_dst, offset);
+  ok = (fclose(fp_dst) == 0) && ok;
+  return ok;
+}
+
+/**
+ * Indices of the containers read or written by this session, so looking up frames doesn't read the
+ * file every time. An entry is only used while the file size and modification time match.
+ */
+struct ContainerIndexCache {
+  int64_t file_size;
+  int64_t mtime;
+  /** False when the file is not a valid container. */
+  bool is_valid;
+  Vector<ContainerFrame> index;
+};
+static Map<std::string, ContainerIndexCache> container_index_cache;
+
+static bool container_stat(const char *filepath, int64_t &r_file_size, int64_t &r_mtime)
+{
+  BLI_stat_t st;
+  if (BLI_stat(filepath, &st) != 0) {
+    return false;
+  }
+  r_file_size = int64_t(st.st_size);
+  r_mtime = int64_t(st.st_mtime);
+  return true;
+}
+
+static void container_index_cache_update(const char *filepath, const Span<ContainerFrame> index)
+{
+  ContainerIndexCache cache;
+  if (!container_stat(filepath, cache.file_size, cache.mtime)) {
+    container_index_cache.remove(filepath);
+    return;
+  }
+  cache.is_valid = true;
+  cache.index = index;
+  container_index_cache.add_overwrite(filepath, std::move(cache));
+}
+
+/** Index of the container at \a filepath, read from the file when it is not cached. */
+static const ContainerIndexCache *container_index_ensure(const char *filepath)
+{
+  int64_t file_size, mtime;
+  if (!container_stat(filepath, file_size, mtime)) {
+    container_index_cache.remove(filepath);
+    return nullptr;
+  }
+
+  ContainerIndexCache *cache = container_index_cache.lookup_ptr(filepath);
+  if (cache && cache->file_size == file_size && cache->mtime == mtime) {
+    return cache;
+  }
+
+  Vector<ContainerFrame> index;
+  uint64_t index_offset;
+  bool is_valid = false;
+  FILE *fp = BLI_fopen(filepath, "rb");
+  if (fp) {
+    is_valid = container_index_parse(fp, uint64_t(file_size), index, index_offset);
+    fclose(fp);
+  }
+  if (!is_valid) {
+    index.clear();
+  }
+  ContainerIndexCache &new_cache = container_index_cache.lookup_or_add_default(filepath);
+  new_cache.file_size = file_size;
+  new_cache.mtime = mtime;
+  new_cache.is_valid = is_valid;
+  new_cache.index = std::move(index);
+  return &new_cache;
+}
+
+/**
+ * Container open for appending records. The index is kept in memory and only written when the
+ * container is closed, see #container_write_begin.
+ */
+struct ContainerWriter {
+  FILE *fp = nullptr;
+  Vector<ContainerFrame> index;
+  /** End of the file, where the next record is appended. */
+  uint64_t file_size = 0;
+  /** Whether records were added or replaced since the index was last written. */
+  bool index_changed = false;
+};
+
+/** Containers kept open between frame writes, by file path. */
+static Map<std::string, ContainerWriter> container_writers;
+static bool container_use_writers = false;
+
+/**
+ * Open the container at \a filepath for appending, creating it if it doesn't exist. An existing
+ * file that is not a valid container is left untouched.
+ */
+static ContainerWriteStatus container_writer_open(const char *filepath, ContainerWriter &r_writer)
+{
+  const ContainerIndexCache *cache = container_index_ensure(filepath);
+  if (cache && cache->file_size > 0) {
+    if (!cache->is_valid) {
+      return ContainerWriteStatus::InvalidFile;
+    }
+    r_writer.fp = BLI_fopen(filepath, "rb+");
+    if (r_writer.fp == nullptr) {
+      return ContainerWriteStatus::WriteFailed;
+    }
+    r_writer.index = cache->index;
+    r_writer.file_size = uint64_t(cache->file_size);
+    return ContainerWriteStatus::Ok;
+  }
+
+  BLI_file_ensure_parent_dir_exists(filepath);
+  r_writer.fp = BLI_fopen(filepath, "wb+");
+  if (r_writer.fp == nullptr) {
+    return ContainerWriteStatus::WriteFailed;
+  }
+  /* Start with an empty index, so the file is a valid container even if no index is written
+   * after the records that follow. */
+  if (fwrite(container_magic, 1, sizeof(container_magic), r_writer.fp) !=
+          sizeof(container_magic) ||
+      !container_index_write(r_writer.fp, {}, CONTAINER_HEADER_SIZE))
+  {
+    fclose(r_writer.fp);
+    r_writer.fp = nullptr;
+    BLI_delete(filepath, false, false);
+    return ContainerWriteStatus::WriteFailed;
+  }
+  r_writer.index.clear();
+  r_writer.file_size = CONTAINER_HEADER_SIZE + sizeof(ContainerTrailer);
+  return ContainerWriteStatus::Ok;
+}
+
+/** Append the record of \a frame, replacing an existing record of the same frame in the index. */
+static bool container_writer_append(ContainerWriter &writer,
+                                    const int frame,
+                                    const Span<uint8_t> record)
+{
+  if (BLI_fseek(writer.fp, int64_t(writer.file_size), SEEK_SET) != 0 ||
+      fwrite(record.data(), 1, size_t(record.size()), writer.fp) != size_t(record.size()))
+  {
+    return false;
+  }
+
+  ContainerFrame entry{};
+  entry.frame = frame;
+  entry.offset = writer.file_size;
+  entry.size = uint64_t(record.size());
+  writer.file_size += entry.size;
+  writer.index_changed = true;
+
+  /* A replaced record of the same frame becomes unused space until the next compaction. */
+  ContainerFrame *pos = std::lower_bound(
+      writer.index.begin(), writer.index.end(), frame, [](const ContainerFrame &a, const int b) {
+        return a.frame < b;
+      });
+  if (pos != writer.index.end() && pos->frame == frame) {
+    *pos = entry;
+  }
+  else {
+    writer.index.insert(pos - writer.index.begin(), entry);
+  }
+  return true;
+}
+
+/**
+ * Write the index of \a writer if it changed and close the file. The file is compacted when
+ * more than half of it is unused. The index is written before, so a failed compaction still
+ * leaves all records readable.
+ */
+static ContainerWriteStatus container_writer_close(const char *filepath, ContainerWriter &writer)
+{
+  bool ok = true;
+  if (writer.index_changed) {
+    ok = container_index_write(writer.fp, writer.index, writer.file_size);
+    writer.file_size += uint64_t(writer.index.as_span().size_in_bytes()) +
+                        sizeof(ContainerTrailer);
+  }
+
+  /* The compacted copy replaces the file once the source is closed, as open files can't be
+   * replaced on all platforms. */
+  const std::string filepath_tmp = std::string(filepath) + ".tmp";
+  const bool use_compact = ok && container_needs_compact(writer.index, writer.file_size);
+  const bool compact_ok = use_compact &&
+                          container_compact(writer.fp, filepath_tmp.c_str(), writer.index);
+  ok = (fclose(writer.fp) == 0) && ok;
+  writer.fp = nullptr;
+
+  ContainerWriteStatus status = ContainerWriteStatus::Ok;
+  if (!ok) {
+    status = ContainerWriteStatus::WriteFailed;
+  }
+  else if (use_compact &&
+           (!compact_ok || BLI_rename_overwrite(filepath_tmp.c_str(), filepath) != 0))
+  {
+    status = ContainerWriteStatus::CompactFailed;
+  }
+  if (use_compact && status != ContainerWriteStatus::Ok) {
+    BLI_delete(filepath_tmp.c_str(), false, false);
+  }
+
+  if (status == ContainerWriteStatus::WriteFailed ||
+      (use_compact && status == ContainerWriteStatus::Ok))
+  {
+    /* The compacted file stores the records at other offsets, it's read again when needed. */
+    container_index_cache.remove(filepath);
+  }
+  else {
+    container_index_cache_update(filepath, writer.index);
+  }
+  return status;
+}
+
+static ContainerWriteStatus container_close_locked(const char *filepath)
+{
+  ContainerWriter *writer = container_writers.lookup_ptr(filepath);
+  if (writer == nullptr) {
+    return ContainerWriteStatus::Ok;
+  }
+  const ContainerWriteStatus status = container_writer_close(filepath, *writer);
+  container_writers.remove(filepath);
+  return status;
+}
+
+void container_write_begin()
+{
+  std::lock_guard lock(container_mutex);
+  container_use_writers = true;
+}
+
+bool container_write_end()
+{
+  std::lock_guard lock(container_mutex);
+  container_use_writers = false;
+  bool ok = true;
+  for (auto item : container_writers.items()) {
+    const ContainerWriteStatus status = container_writer_close(item.key.c_str(), item.value);
+    ok &= status != ContainerWriteStatus::WriteFailed;
+  }
+  container_writers.clear();
+  return ok;
+}
+
+ContainerWriteStatus container_close(const char *filepath)
+{
+  std::lock_guard lock(container_mutex);
+  return container_close_locked(filepath);
+}
+
+Vector<ContainerFrame> container_index_read(const char *filepath)
+{
+  std::lock_guard lock(container_mutex);
+  if (const ContainerWriter *writer = container_writers.lookup_ptr(filepath)) {
+    return writer->index;
+  }
+  const ContainerIndexCache *cache = container_index_ensure(filepath);
+  return cache ? cache->index : Vector<ContainerFrame>();
+}
+
+bool container_frame_exists(const char *filepath, const int frame)
+{
+  std::lock_guard lock(container_mutex);
+  Span<ContainerFrame> index;
+  if (const ContainerWriter *writer = container_writers.lookup_ptr(filepath)) {
+    index = writer->index;
+  }
+  else if (const ContainerIndexCache *cache = container_index_ensure(filepath)) {
+    index = cache->index;
+  }
+  const ContainerFrame *entry = std::lower_bound(
+      index.begin(), index.end(), frame, [](const ContainerFrame &a, const int b) {
+        return a.frame < b;
+      });
+  return entry != index.end() && entry->frame == frame;
+}
+
+ContainerWriteStatus container_frame_write(const char *filepath,
+                                           const int frame,
+                                           const Span<uint8_t> record)
+{
+  std::lock_guard lock(container_mutex);
+
+  ContainerWriter *writer = container_writers.lookup_ptr(filepath);
+  ContainerWriter local_writer;
+  if (writer == nullptr) {
+    const ContainerWriteStatus status = container_writer_open(filepath, local_writer);
+    if (status != ContainerWriteStatus::Ok) {
+      return status;
+    }
+    if (container_use_writers) {
+      writer = &container_writers.lookup_or_add(filepath, std::move(local_writer));
+    }
+    else {
+      writer = &local_writer;
+    }
+  }
+
+  if (!container_writer_append(*writer, frame, record)) {
+    /* Nothing refers to the partially written record, the index is unchanged. */
+    if (writer == &local_writer) {
+      container_writer_close(filepath, local_writer);
+    }
+    return ContainerWriteStatus::WriteFailed;
+  }
+
+  if (writer == &local_writer) {
+    /* Without #container_write_begin every write leaves a complete container. */
+    return container_writer_close(filepath, local_writer);
+  }
+  return ContainerWriteStatus::Ok;
+}
+
+bool container_frames_remove(const char *filepath, FunctionRef<bool(int frame)> remove_fn)
+{
+  std::lock_guard lock(container_mutex);
+  if (container_close_locked(filepath) == ContainerWriteStatus::WriteFailed) {
+    return false;
+  }
+
+  const ContainerIndexCache *cache = container_index_ensure(filepath);
+  if (cache == nullptr || !cache->is_valid) {
+    return false;
+  }
+  Vector<ContainerFrame> index = cache->index;
+  const int64_t removed = index.remove_if(
+      [&](const ContainerFrame &entry) { return remove_fn(entry.frame); });
+  if (removed == 0) {
+    return true;
+  }
+  if (index.is_empty()) {
+    container_index_cache.remove(filepath);
+    return BLI_delete(filepath, false, false) == 0;
+  }
+
+  ContainerWriter writer;
+  if (container_writer_open(filepath, writer) != ContainerWriteStatus::Ok) {
+    return false;
+  }
+  writer.index = std::move(index);
+  writer.index_changed = true;
+  /* Not compacting only leaves unused space behind. */
+  return container_writer_close(filepath, writer) != ContainerWriteStatus::WriteFailed;
+}
+
+ContainerReader::~ContainerReader()
+{
+  if (mmap_file_) {
+    BLI_mmap_free(mmap_file_);
+  }
+}
+
+bool ContainerReader::open(const char *filepath)
+{
+  std::lock_guard lock(container_mutex);
+  /* Records of a container open for writing are read with its index kept in memory. */
+  const ContainerWriter *writer = container_writers.lookup_ptr(filepath);
+  if (writer && fflush(writer->fp) != 0) {
+    return false;
+  }
+
+  const int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    return false;
+  }
+
+  const int64_t file_size = BLI_lseek(file, 0, SEEK_END);
+  /* The mapping stays valid after the descriptor is closed. */
+  mmap_file_ = (file_size > 0) ? BLI_mmap_open(file) : nullptr;
+  close(file);
+
+  if (mmap_file_ == nullptr) {
+    return false;
+  }
+
+  if (writer) {
+    index_ = writer->index;
+    return true;
+  }
+
+  uint64_t index_offset;
+  if (!container_index_parse(
+          uint64_t(file_size),
+          [&](void *dst, const uint64_t offset, const uint64_t size) {
+            return BLI_mmap_read(mmap_file_, dst, size_t(offset), size_t(size));
+          },
+          index_,
+          index_offset))
+  {
+    index_.clear();
+    return false;
+  }
+  return true;
+}
+
+const ContainerFrame *ContainerReader::find(const int frame) const
+{
+  const ContainerFrame *entry = std::lower_bound(
+      index_.begin(), index_.end(), frame, [](const ContainerFrame &a, const int b) {
+        return a.frame < b;
+      });
+  return (entry != index_.end() && entry->frame == frame) ? entry : nullptr;
+}
+
+bool ContainerReader::read(const ContainerFrame &record,
+                           void *dst,
+                           const uint64_t offset,
+                           const uint64_t size) const
+{
+  if (offset + size > record.size) {
+    return false;
+  }
+  return BLI_mmap_read(mmap_file_, dst, size_t(record.offset + offset), size_t(size));
+}
+
+}  // namespace blender::bke::pointcache
@@ -0,0 +1,113 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ *
+ * Single file point cache storage (#PTCACHE_DISK_CONTAINER).
+ *
+ * All frames of one cache are appended to one file, each frame record holds the same bytes a
+ * `.bphys` frame file would. The file ends with an index of the records followed by a fixed size
+ * trailer pointing to it, so any frame can be found without scanning the cache directory:
+ *
+ * `BPHYSCON | record ... | index (ContainerFrame[frames_num]) | trailer`
+ *
+ * Indices and trailers are appended instead of updated in place, so an interrupted write leaves
+ * the previous state readable. Replaced records, removed frames and old indices stay in the file
+ * until it is compacted, once more than half of it is unused.
+ *
+ * Between #container_write_begin and #container_write_end (while baking) containers stay open
+ * and their index is only kept in memory, it is written once when the container is closed.
+ * Otherwise every write leaves a complete container.
+ *
+ * Container access is serialized, so frames can be written from several threads.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "BLI_function_ref.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+struct BLI_mmap_file;
+
+namespace blender::bke::pointcache {
+
+/** Index entry of one frame record. */
+struct ContainerFrame {
+  int frame;
+  int _pad;
+  /** Start of the record, relative to the start of the file. */
+  uint64_t offset;
+  uint64_t size;
+};
+
+enum class ContainerWriteStatus {
+  Ok,
+  /** The file exists but is not a valid container, it is left untouched. */
+  InvalidFile,
+  /** Writing failed, the container keeps its previous frames. */
+  WriteFailed,
+  /** The frames are written, but replacing the file with its compacted copy failed. */
+  CompactFailed,
+};
+
+/**
+ * Keep containers open after writing frames, until #container_write_end writes their indices
+ * and closes them.
+ */
+void container_write_begin();
+/** Close the containers kept open since #container_write_begin, false if any write failed. */
+bool container_write_end();
+/** Write the index of the container at \a filepath and close it, if it is kept open. */
+ContainerWriteStatus container_close(const char *filepath);
+
+/**
+ * Frame index of the container sorted by frame, empty if the file is missing or invalid.
+ * Indices are cached, the file is only read again when it changed.
+ */
+Vector<ContainerFrame> container_index_read(const char *filepath);
+
+/** Whether the container stores \a frame, using the cached index. */
+bool container_frame_exists(const char *filepath, int frame);
+
+/**
+ * Add the record of \a frame to the container, creating the file if needed.
+ * An existing record of the same frame is replaced.
+ */
+ContainerWriteStatus container_frame_write(const char *filepath, int frame, Span<uint8_t> record);
+
+/**
+ * Drop all frames for which \a remove_fn returns true. The file is deleted when no frame is left.
+ */
+bool container_frames_remove(const char *filepath, FunctionRef<bool(int frame)> remove_fn);
+
+/** Memory mapped read access to the records of a container. */
+class ContainerReader {
+  BLI_mmap_file *mmap_file_ = nullptr;
+  Vector<ContainerFrame> index_;
+
+ public:
+  ContainerReader() = default;
+  ContainerReader(const ContainerReader &other) = delete;
+  ContainerReader &operator=(const ContainerReader &other) = delete;
+  ~ContainerReader();
+
+  bool open(const char *filepath);
+
+  Span<ContainerFrame> index() const
+  {
+    return index_;
+  }
+
+  /** Index entry of \a frame, null if the frame is not stored. */
+  const ContainerFrame *find(int frame) const;
+
+  /** Copy \a size bytes starting at \a offset of \a record to \a dst. */
+  bool read(const ContainerFrame &record, void *dst, uint64_t offset, uint64_t size) const;
+};
+
+}  // namespace blender::bke::pointcache
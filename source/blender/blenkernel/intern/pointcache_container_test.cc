@@ -0,0 +1,142 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <string>
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+
+#include "pointcache_container.hh"
+
+#include BLI_SYSTEM_PID_H
+
+namespace blender::bke::pointcache::tests {
+
+class PointCacheContainerTest : public testing::Test {
+ public:
+  std::string filepath;
+
+  void SetUp() override
+  {
+    char temp_dir[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+    const std::string file_name = "blender_test_" + std::to_string(getpid()) + ".bphyscon";
+    char path[FILE_MAX];
+    BLI_path_join(path, sizeof(path), temp_dir, file_name.c_str());
+    filepath = path;
+  }
+
+  void TearDown() override
+  {
+    container_close(filepath.c_str());
+    BLI_delete(filepath.c_str(), false, false);
+  }
+
+  static Vector<uint8_t> record(const int frame, const int size)
+  {
+    Vector<uint8_t> data(size);
+    for (const int i : data.index_range()) {
+      data[i] = uint8_t(frame * 31 + i);
+    }
+    return data;
+  }
+
+  void expect_record(const int frame, const int size)
+  {
+    ContainerReader reader;
+    ASSERT_TRUE(reader.open(filepath.c_str()));
+    const ContainerFrame *entry = reader.find(frame);
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->size, uint64_t(size));
+    Vector<uint8_t> data(size);
+    ASSERT_TRUE(reader.read(*entry, data.data(), 0, uint64_t(size)));
+    EXPECT_EQ(data.as_span(), record(frame, size).as_span());
+  }
+};
+
+TEST_F(PointCacheContainerTest, WriteAndReplace)
+{
+  for (const int frame : {3, 1, 2}) {
+    EXPECT_EQ(container_frame_write(filepath.c_str(), frame, record(frame, 100)),
+              ContainerWriteStatus::Ok);
+  }
+  EXPECT_EQ(container_frame_write(filepath.c_str(), 2, record(2, 50)), ContainerWriteStatus::Ok);
+
+  const Vector<ContainerFrame> index = container_index_read(filepath.c_str());
+  ASSERT_EQ(index.size(), 3);
+  EXPECT_EQ(index[0].frame, 1);
+  EXPECT_EQ(index[1].frame, 2);
+  EXPECT_EQ(index[2].frame, 3);
+  expect_record(1, 100);
+  expect_record(2, 50);
+  expect_record(3, 100);
+
+  EXPECT_TRUE(
+      container_frames_remove(filepath.c_str(), [](const int frame) { return frame > 1; }));
+  EXPECT_EQ(container_index_read(filepath.c_str()).size(), 1);
+  EXPECT_FALSE(container_frame_exists(filepath.c_str(), 3));
+  expect_record(1, 100);
+
+  EXPECT_TRUE(container_frames_remove(filepath.c_str(), [](const int /*frame*/) { return true; }));
+  EXPECT_FALSE(BLI_exists(filepath.c_str()));
+}
+
+TEST_F(PointCacheContainerTest, BatchWrite)
+{
+  container_write_begin();
+  for (int frame = 1; frame <= 50; frame++) {
+    EXPECT_EQ(container_frame_write(filepath.c_str(), frame, record(frame, 64)),
+              ContainerWriteStatus::Ok);
+  }
+  /* The open container is readable before its index is written. */
+  EXPECT_TRUE(container_frame_exists(filepath.c_str(), 50));
+  expect_record(25, 64);
+  const int64_t size_open = BLI_file_size(filepath.c_str());
+  EXPECT_TRUE(container_write_end());
+
+  /* Only one index is written, at the end. */
+  EXPECT_LT(BLI_file_size(filepath.c_str()) - size_open,
+            2 * 50 * int64_t(sizeof(ContainerFrame)));
+  EXPECT_EQ(container_index_read(filepath.c_str()).size(), 50);
+  expect_record(1, 64);
+  expect_record(50, 64);
+}
+
+TEST_F(PointCacheContainerTest, Compact)
+{
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(container_frame_write(filepath.c_str(), 1, record(1, 1000)),
+              ContainerWriteStatus::Ok);
+  }
+  EXPECT_EQ(container_frame_write(filepath.c_str(), 2, record(2, 1000)),
+            ContainerWriteStatus::Ok);
+
+  /* Replaced records are dropped once they take more than half of the file. */
+  EXPECT_LT(BLI_file_size(filepath.c_str()), 5000);
+  EXPECT_EQ(container_index_read(filepath.c_str()).size(), 2);
+  expect_record(1, 1000);
+  expect_record(2, 1000);
+}
+
+TEST_F(PointCacheContainerTest, InvalidFileUntouched)
+{
+  const char content[] = "not a point cache container";
+  FILE *fp = BLI_fopen(filepath.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  fwrite(content, 1, sizeof(content), fp);
+  fclose(fp);
+
+  EXPECT_EQ(container_frame_write(filepath.c_str(), 1, record(1, 10)),
+            ContainerWriteStatus::InvalidFile);
+  EXPECT_FALSE(
+      container_frames_remove(filepath.c_str(), [](const int /*frame*/) { return true; }));
+  EXPECT_TRUE(container_index_read(filepath.c_str()).is_empty());
+  EXPECT_EQ(BLI_file_size(filepath.c_str()), int64_t(sizeof(content)));
+}
+
+}  // namespace blender::bke::pointcache::tests
@@ -0,0 +1,45 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ *
+ * Delta encoding of point cache channels against a key-frame (#PTCACHE_COMPRESS_ZSTD).
+ *
+ * Every value becomes one 32 bit word. Lossless deltas XOR the float bits with the key-frame,
+ * with a tolerance the difference is quantized to multiples of it and zig-zag encoded, so small
+ * negative differences stay small words too.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "BLI_span.hh"
+
+/* Delta block modes. */
+#define PTCACHE_DELTA_XOR 0
+#define PTCACHE_DELTA_QUANTIZE 1
+
+namespace blender::bke::pointcache {
+
+/**
+ * Encode \a values as \a r_words relative to \a ref_values. The differences are quantized when
+ * \a tolerance is positive, unless a value is too far from its reference to be quantized.
+ *
+ * \return The delta mode the words are encoded with.
+ */
+uint8_t delta_encode(Span<float> values,
+                     Span<float> ref_values,
+                     float tolerance,
+                     MutableSpan<uint32_t> r_words);
+
+/** Inverse of #delta_encode, the \a tolerance has to be the one the words were encoded with. */
+void delta_decode(uint8_t mode,
+                  Span<uint32_t> words,
+                  Span<float> ref_values,
+                  float tolerance,
+                  MutableSpan<float> r_values);
+
+}  // namespace blender::bke::pointcache
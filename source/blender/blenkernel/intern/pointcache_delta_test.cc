@@ -0,0 +1,93 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "BLI_array.hh"
+
+#include "pointcache_delta.hh"
+
+namespace blender::bke::pointcache::tests {
+
+static uint32_t float_bits(const float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+TEST(pointcache_delta, XorRoundTrip)
+{
+  const Array<float> ref_values = {0.0f, 1.0f, -2.5f, 1e-30f, 1e30f, -0.0f, 3.0f, 7.0f};
+  const Array<float> values = {0.0f,
+                               1.0001f,
+                               -2.4999f,
+                               -1e-30f,
+                               std::numeric_limits<float>::infinity(),
+                               std::numeric_limits<float>::quiet_NaN(),
+                               3.0f,
+                               -7.0f};
+
+  Array<uint32_t> words(values.size());
+  EXPECT_EQ(delta_encode(values, ref_values, 0.0f, words), PTCACHE_DELTA_XOR);
+  /* Unchanged values are stored as zero. */
+  EXPECT_EQ(words[0], 0u);
+  EXPECT_EQ(words[6], 0u);
+
+  Array<float> decoded(values.size());
+  delta_decode(PTCACHE_DELTA_XOR, words, ref_values, 0.0f, decoded);
+  /* Lossless, bit for bit, including NaN and the sign of zero. */
+  for (const int64_t i : values.index_range()) {
+    EXPECT_EQ(float_bits(decoded[i]), float_bits(values[i]));
+  }
+}
+
+TEST(pointcache_delta, QuantizeRoundTrip)
+{
+  const float tolerance = 0.001f;
+  const Array<float> ref_values = {0.0f, 1.0f, -2.5f, 10.0f, 10.0f, 100.0f};
+  const Array<float> values = {0.0f, 1.001f, -2.501f, 10.0042f, 9.9958f, 103.1234f};
+
+  Array<uint32_t> words(values.size());
+  EXPECT_EQ(delta_encode(values, ref_values, tolerance, words), PTCACHE_DELTA_QUANTIZE);
+  /* Zig-zag encoding: zero steps are zero, negative steps are odd and as small as positive. */
+  EXPECT_EQ(words[0], 0u);
+  EXPECT_EQ(words[1], 2u);
+  EXPECT_EQ(words[2], 1u);
+  EXPECT_EQ(words[3], 8u);
+  EXPECT_EQ(words[4], 7u);
+
+  Array<float> decoded(values.size());
+  delta_decode(PTCACHE_DELTA_QUANTIZE, words, ref_values, tolerance, decoded);
+  for (const int64_t i : values.index_range()) {
+    EXPECT_NEAR(decoded[i], values[i], tolerance * 0.5f + 1e-5f);
+  }
+}
+
+TEST(pointcache_delta, QuantizeOutOfRange)
+{
+  const Array<float> ref_values = {0.0f, 0.0f, 0.0f};
+
+  /* Values too far from the reference to quantize are stored exactly instead. */
+  const Array<float> far_values = {0.5f, 1e9f, -0.25f};
+  Array<uint32_t> words(far_values.size());
+  EXPECT_EQ(delta_encode(far_values, ref_values, 0.001f, words), PTCACHE_DELTA_XOR);
+  Array<float> decoded(far_values.size());
+  delta_decode(PTCACHE_DELTA_XOR, words, ref_values, 0.001f, decoded);
+  for (const int64_t i : far_values.index_range()) {
+    EXPECT_EQ(float_bits(decoded[i]), float_bits(far_values[i]));
+  }
+
+  /* As are values that aren't finite. */
+  const Array<float> nan_values = {0.5f, std::numeric_limits<float>::quiet_NaN(), -0.25f};
+  EXPECT_EQ(delta_encode(nan_values, ref_values, 0.001f, words), PTCACHE_DELTA_XOR);
+  delta_decode(PTCACHE_DELTA_XOR, words, ref_values, 0.001f, decoded);
+  EXPECT_TRUE(std::isnan(decoded[1]));
+}
+
+}  // namespace blender::bke::pointcache::tests
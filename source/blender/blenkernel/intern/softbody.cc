@@ -23,6 +23,7 @@
  * </pre>
  */
 
+#include <algorithm>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,12 +43,14 @@
 #include "DNA_scene_types.h"
 
 #include "BLI_ghash.h"
+#include "BLI_kdopbvh.h"
 #include "BLI_listbase.h"
 #include "BLI_math_geom.h"
 #include "BLI_math_matrix.h"
 #include "BLI_math_vector.h"
-#include "BLI_threads.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_collection.h"
 #include "BKE_collision.h"
@@ -103,6 +106,12 @@ typedef struct ReferenceState {
 /* Private scratch pad for caching and other data only needed when alive. */
 typedef struct SBScratch {
   GHash *colliderhash;
+  /* Bounds of the deflectors in #colliderhash, rebuilt every step by #ccd_build_deflector_tree.
+   * The tree leaves index the two arrays. */
+  BVHTree *deflector_tree;
+  Object **deflector_objects;
+  struct ccd_Mesh **deflector_meshes;
+  int deflector_num;
   short needstobuildcollider;
   short flag;
   BodyFace *bodyface;
@@ -111,23 +120,11 @@ typedef struct SBScratch {
   ReferenceState Ref;
 } SBScratch;
 
-typedef struct SB_thread_context {
-  Scene *scene;
-  Object *ob;
-  float forcetime;
-  float timenow;
-  int ifirst;
-  int ilast;
-  ListBase *effectors;
-  int do_deflector;
-  float fieldfactor;
-  float windfactor;
-  int nr;
-  int tot;
-} SB_thread_context;
-
 #define MID_PRESERVE 1
 
+/* Number of points or springs handled by a single task. */
+#define SB_PARALLEL_GRAIN 64
+
 #define SOFTGOALSNAP 0.999f
 /* if bp-> goal is above make it a *forced follow original* and skip all ODE stuff for this bp
  * removes *unnecessary* stiffness from ODE system
@@ -566,6 +563,128 @@ static void ccd_update_deflector_hash(Depsgraph *depsgraph,
   BKE_collision_objects_free(objects);
 }
 
+static void ccd_free_deflector_tree(SBScratch *scratch)
+{
+  if (scratch->deflector_tree) {
+    BLI_bvhtree_free(scratch->deflector_tree);
+    scratch->deflector_tree = nullptr;
+  }
+  MEM_SAFE_FREE(scratch->deflector_objects);
+  MEM_SAFE_FREE(scratch->deflector_meshes);
+  scratch->deflector_num = 0;
+}
+
+/**
+ * Index the bounds of the cached deflector meshes, so collision queries only visit the
+ * deflectors near the queried point or box instead of all of them.
+ * Has to run after the deflector meshes are updated for the step.
+ */
+static void ccd_build_deflector_tree(SBScratch *scratch)
+{
+  ccd_free_deflector_tree(scratch);
+
+  const int hash_num = BLI_ghash_len(scratch->colliderhash);
+  if (hash_num == 0) {
+    return;
+  }
+
+  scratch->deflector_objects = static_cast<Object **>(
+      MEM_mallocN(sizeof(Object *) * hash_num, "SB deflector objects"));
+  scratch->deflector_meshes = static_cast<ccd_Mesh **>(
+      MEM_mallocN(sizeof(ccd_Mesh *) * hash_num, "SB deflector meshes"));
+
+  GHashIterator gh_iter;
+  GHASH_ITER (gh_iter, scratch->colliderhash) {
+    Object *ob = static_cast<Object *>(BLI_ghashIterator_getKey(&gh_iter));
+    ccd_Mesh *ccdm = static_cast<ccd_Mesh *>(BLI_ghashIterator_getValue(&gh_iter));
+    /* only with deflecting set */
+    if (!(ob->pd && ob->pd->deflect)) {
+      continue;
+    }
+    if (ccdm == nullptr) {
+      /* Aye that should be cached. */
+      CLOG_ERROR(&LOG, "missing cache error");
+      continue;
+    }
+    scratch->deflector_objects[scratch->deflector_num] = ob;
+    scratch->deflector_meshes[scratch->deflector_num] = ccdm;
+    scratch->deflector_num++;
+  }
+
+  if (scratch->deflector_num == 0) {
+    return;
+  }
+
+  scratch->deflector_tree = BLI_bvhtree_new(scratch->deflector_num, 0.0f, 4, 6);
+  for (int i = 0; i < scratch->deflector_num; i++) {
+    const ccd_Mesh *ccdm = scratch->deflector_meshes[i];
+    float co[2][3];
+    copy_v3_v3(co[0], ccdm->bbmin);
+    copy_v3_v3(co[1], ccdm->bbmax);
+    BLI_bvhtree_insert(scratch->deflector_tree, i, co[0], 2);
+  }
+  BLI_bvhtree_balance(scratch->deflector_tree);
+}
+
+struct DeflectorQueryData {
+  const float *min, *max;
+  blender::Vector<int, 16> *r_deflectors;
+};
+
+static bool ccd_deflector_bounds_overlap(const BVHTreeAxisRange *bounds,
+                                         const DeflectorQueryData *data)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    if ((data->max[axis] < bounds[axis].min) || (data->min[axis] > bounds[axis].max)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ccd_deflector_walk_parent(const BVHTreeAxisRange *bounds, void *userdata)
+{
+  return ccd_deflector_bounds_overlap(bounds, static_cast<const DeflectorQueryData *>(userdata));
+}
+
+static bool ccd_deflector_walk_leaf(const BVHTreeAxisRange *bounds, int index, void *userdata)
+{
+  DeflectorQueryData *data = static_cast<DeflectorQueryData *>(userdata);
+  if (ccd_deflector_bounds_overlap(bounds, data)) {
+    data->r_deflectors->append(index);
+  }
+  return true;
+}
+
+static bool ccd_deflector_walk_order(const BVHTreeAxisRange * /*bounds*/,
+                                     char /*axis*/,
+                                     void * /*userdata*/)
+{
+  return true;
+}
+
+/**
+ * Collect the deflectors whose padded bounds overlap the box from \a min to \a max.
+ * The indices are sorted, so forces of several deflectors add up in a fixed order.
+ */
+static void ccd_find_deflectors(const SBScratch *scratch,
+                                const float min[3],
+                                const float max[3],
+                                blender::Vector<int, 16> &r_deflectors)
+{
+  r_deflectors.clear();
+  if (scratch->deflector_tree == nullptr) {
+    return;
+  }
+  DeflectorQueryData data = {min, max, &r_deflectors};
+  BLI_bvhtree_walk_dfs(scratch->deflector_tree,
+                       ccd_deflector_walk_parent,
+                       ccd_deflector_walk_leaf,
+                       ccd_deflector_walk_order,
+                       &data);
+  std::sort(r_deflectors.begin(), r_deflectors.end());
+}
+
 /*--- collider caching and dicing ---*/
 
 static int count_mesh_quads(Mesh *me)
@@ -892,6 +1011,7 @@ static void free_scratch(SoftBody *sb)
                      (GHashValFreeFP)ccd_mesh_free); /* This hopefully will free all caches. */
       sb->scratch->colliderhash = nullptr;
     }
+    ccd_free_deflector_tree(sb->scratch);
     if (sb->scratch->bodyface) {
       MEM_freeN(sb->scratch->bodyface);
     }
@@ -981,8 +1101,6 @@ static int sb_detect_aabb_collisionCached(float /*force*/[3], Object *vertexowne
 {
   Object *ob;
   SoftBody *sb = vertexowner->soft;
-  GHash *hash;
-  GHashIterator *ihash;
   float aabbmin[3], aabbmax[3];
   int deflected = 0;
 #if 0
@@ -995,12 +1113,12 @@ static int sb_detect_aabb_collisionCached(float /*force*/[3], Object *vertexowne
   copy_v3_v3(aabbmin, sb->scratch->aabbmin);
   copy_v3_v3(aabbmax, sb->scratch->aabbmax);
 
-  hash = vertexowner->soft->scratch->colliderhash;
-  ihash = BLI_ghashIterator_new(hash);
-  while (!BLI_ghashIterator_done(ihash)) {
-
-    ccd_Mesh *ccdm = static_cast<ccd_Mesh *>(BLI_ghashIterator_getValue(ihash));
-    ob = static_cast<Object *>(BLI_ghashIterator_getKey(ihash));
+  const SBScratch *scratch = vertexowner->soft->scratch;
+  blender::Vector<int, 16> deflectors;
+  ccd_find_deflectors(scratch, aabbmin, aabbmax, deflectors);
+  for (const int deflector : deflectors) {
+    ccd_Mesh *ccdm = scratch->deflector_meshes[deflector];
+    ob = scratch->deflector_objects[deflector];
     {
       /* only with deflecting set */
       if (ob->pd && ob->pd->deflect) {
@@ -1010,7 +1128,6 @@ static int sb_detect_aabb_collisionCached(float /*force*/[3], Object *vertexowne
               (aabbmin[1] > ccdm->bbmax[1]) || (aabbmin[2] > ccdm->bbmax[2]))
           {
             /* boxes don't intersect */
-            BLI_ghashIterator_step(ihash);
             continue;
           }
 
@@ -1021,14 +1138,11 @@ static int sb_detect_aabb_collisionCached(float /*force*/[3], Object *vertexowne
         else {
           /* Aye that should be cached. */
           CLOG_ERROR(&LOG, "missing cache error");
-          BLI_ghashIterator_step(ihash);
           continue;
         }
       } /* if (ob->pd && ob->pd->deflect) */
-      BLI_ghashIterator_step(ihash);
     }
-  } /* while () */
-  BLI_ghashIterator_free(ihash);
+  } /* for (deflectors) */
   return deflected;
 }
 /* --- the aabb section. */
@@ -1043,8 +1157,6 @@ static int sb_detect_face_pointCached(const float face_v1[3],
                                       float time)
 {
   Object *ob;
-  GHash *hash;
-  GHashIterator *ihash;
   float nv1[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
   float facedist, outerfacethickness, tune = 10.0f;
   int a, deflected = 0;
@@ -1062,12 +1174,12 @@ static int sb_detect_face_pointCached(const float face_v1[3],
   cross_v3_v3v3(d_nvect, edge2, edge1);
   normalize_v3(d_nvect);
 
-  hash = vertexowner->soft->scratch->colliderhash;
-  ihash = BLI_ghashIterator_new(hash);
-  while (!BLI_ghashIterator_done(ihash)) {
-
-    ccd_Mesh *ccdm = static_cast<ccd_Mesh *>(BLI_ghashIterator_getValue(ihash));
-    ob = static_cast<Object *>(BLI_ghashIterator_getKey(ihash));
+  const SBScratch *scratch = vertexowner->soft->scratch;
+  blender::Vector<int, 16> deflectors;
+  ccd_find_deflectors(scratch, aabbmin, aabbmax, deflectors);
+  for (const int deflector : deflectors) {
+    ccd_Mesh *ccdm = scratch->deflector_meshes[deflector];
+    ob = scratch->deflector_objects[deflector];
     {
       /* only with deflecting set */
       if (ob->pd && ob->pd->deflect) {
@@ -1083,14 +1195,12 @@ static int sb_detect_face_pointCached(const float face_v1[3],
               (aabbmin[1] > ccdm->bbmax[1]) || (aabbmin[2] > ccdm->bbmax[2]))
           {
             /* boxes don't intersect */
-            BLI_ghashIterator_step(ihash);
             continue;
           }
         }
         else {
           /* Aye that should be cached. */
           CLOG_ERROR(&LOG, "missing cache error");
-          BLI_ghashIterator_step(ihash);
           continue;
         }
 
@@ -1126,10 +1236,8 @@ static int sb_detect_face_pointCached(const float face_v1[3],
           } /* while (a) */
         }   /* if (vert_positions) */
       }     /* if (ob->pd && ob->pd->deflect) */
-      BLI_ghashIterator_step(ihash);
     }
-  } /* while () */
-  BLI_ghashIterator_free(ihash);
+  } /* for (deflectors) */
   return deflected;
 }
 
@@ -1142,8 +1250,6 @@ static int sb_detect_face_collisionCached(const float face_v1[3],
                                           float time)
 {
   Object *ob;
-  GHash *hash;
-  GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
   float t, tune = 10.0f;
   int a, deflected = 0;
@@ -1155,12 +1261,12 @@ static int sb_detect_face_collisionCached(const float face_v1[3],
   aabbmax[1] = max_fff(face_v1[1], face_v2[1], face_v3[1]);
   aabbmax[2] = max_fff(face_v1[2], face_v2[2], face_v3[2]);
 
-  hash = vertexowner->soft->scratch->colliderhash;
-  ihash = BLI_ghashIterator_new(hash);
-  while (!BLI_ghashIterator_done(ihash)) {
-
-    ccd_Mesh *ccdm = static_cast<ccd_Mesh *>(BLI_ghashIterator_getValue(ihash));
-    ob = static_cast<Object *>(BLI_ghashIterator_getKey(ihash));
+  const SBScratch *scratch = vertexowner->soft->scratch;
+  blender::Vector<int, 16> deflectors;
+  ccd_find_deflectors(scratch, aabbmin, aabbmax, deflectors);
+  for (const int deflector : deflectors) {
+    ccd_Mesh *ccdm = scratch->deflector_meshes[deflector];
+    ob = scratch->deflector_objects[deflector];
     {
       /* only with deflecting set */
       if (ob->pd && ob->pd->deflect) {
@@ -1181,14 +1287,12 @@ static int sb_detect_face_collisionCached(const float face_v1[3],
               (aabbmin[1] > ccdm->bbmax[1]) || (aabbmin[2] > ccdm->bbmax[2]))
           {
             /* boxes don't intersect */
-            BLI_ghashIterator_step(ihash);
             continue;
           }
         }
         else {
           /* Aye that should be cached. */
           CLOG_ERROR(&LOG, "missing cache error");
-          BLI_ghashIterator_step(ihash);
           continue;
         }
 
@@ -1238,10 +1342,8 @@ static int sb_detect_face_collisionCached(const float face_v1[3],
           vt++;
         } /* while a */
       }   /* if (ob->pd && ob->pd->deflect) */
-      BLI_ghashIterator_step(ihash);
     }
-  } /* while () */
-  BLI_ghashIterator_free(ihash);
+  } /* for (deflectors) */
   return deflected;
 }
 
@@ -1325,23 +1427,22 @@ static int sb_detect_edge_collisionCached(const float edge_v1[3],
                                           float time)
 {
   Object *ob;
-  GHash *hash;
-  GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
   float t, el;
   int a, deflected = 0;
 
+  INIT_MINMAX(aabbmin, aabbmax);
   minmax_v3v3_v3(aabbmin, aabbmax, edge_v1);
   minmax_v3v3_v3(aabbmin, aabbmax, edge_v2);
 
   el = len_v3v3(edge_v1, edge_v2);
 
-  hash = vertexowner->soft->scratch->colliderhash;
-  ihash = BLI_ghashIterator_new(hash);
-  while (!BLI_ghashIterator_done(ihash)) {
-
-    ccd_Mesh *ccdm = static_cast<ccd_Mesh *>(BLI_ghashIterator_getValue(ihash));
-    ob = static_cast<Object *>(BLI_ghashIterator_getKey(ihash));
+  const SBScratch *scratch = vertexowner->soft->scratch;
+  blender::Vector<int, 16> deflectors;
+  ccd_find_deflectors(scratch, aabbmin, aabbmax, deflectors);
+  for (const int deflector : deflectors) {
+    ccd_Mesh *ccdm = scratch->deflector_meshes[deflector];
+    ob = scratch->deflector_objects[deflector];
     {
       /* only with deflecting set */
       if (ob->pd && ob->pd->deflect) {
@@ -1362,14 +1463,12 @@ static int sb_detect_edge_collisionCached(const float edge_v1[3],
               (aabbmin[1] > ccdm->bbmax[1]) || (aabbmin[2] > ccdm->bbmax[2]))
           {
             /* boxes don't intersect */
-            BLI_ghashIterator_step(ihash);
             continue;
           }
         }
         else {
           /* Aye that should be cached. */
           CLOG_ERROR(&LOG, "missing cache error");
-          BLI_ghashIterator_step(ihash);
           continue;
         }
 
@@ -1425,10 +1524,8 @@ static int sb_detect_edge_collisionCached(const float edge_v1[3],
           vt++;
         } /* while a */
       }   /* if (ob->pd && ob->pd->deflect) */
-      BLI_ghashIterator_step(ihash);
     }
-  } /* while () */
-  BLI_ghashIterator_free(ihash);
+  } /* for (deflectors) */
   return deflected;
 }
 
@@ -1507,78 +1604,19 @@ static void _scan_for_ext_spring_forces(
   }
 }
 
-static void *exec_scan_for_ext_spring_forces(void *data)
-{
-  SB_thread_context *pctx = (SB_thread_context *)data;
-  _scan_for_ext_spring_forces(
-      pctx->scene, pctx->ob, pctx->timenow, pctx->ifirst, pctx->ilast, pctx->effectors);
-  return nullptr;
-}
-
-static void sb_sfesf_threads_run(Depsgraph *depsgraph,
-                                 Scene *scene,
-                                 Object *ob,
-                                 float timenow,
-                                 int totsprings,
-                                 int *ptr_to_break_func(void))
+static void sb_sfesf_threads_run(
+    Depsgraph *depsgraph, Scene *scene, Object *ob, float timenow, int totsprings)
 {
-  UNUSED_VARS(ptr_to_break_func);
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
-  /* wild guess .. may increase with better thread management 'above'
-   * or even be UI option sb->spawn_cf_threads_nopts */
-  int lowsprings = 100;
-
   ListBase *effectors = BKE_effectors_create(
       depsgraph, ob, nullptr, ob->soft->effector_weights, false);
 
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* What if we got zillions of CPUs running but less to spread. */
-  while ((totsprings / totthread < lowsprings) && (totthread > 1)) {
-    totthread--;
-  }
-
-  sb_threads = static_cast<SB_thread_context *>(
-      MEM_callocN(sizeof(SB_thread_context) * totthread, "SBSpringsThread"));
-  left = totsprings;
-  dec = totsprings / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = 0.0; /* not used here */
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
-    }
-    else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = false; /* not used here */
-    sb_threads[i].fieldfactor = 0.0f;   /* not used here */
-    sb_threads[i].windfactor = 0.0f;    /* not used here */
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
-  }
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_scan_for_ext_spring_forces, totthread);
-
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
-    }
-
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_scan_for_ext_spring_forces(&sb_threads[0]);
-  }
-  /* clean up */
-  MEM_freeN(sb_threads);
+  /* Springs are independent of each other, the cost per spring varies a lot with the nearby
+   * deflectors, so leave the balancing of small ranges to the task scheduler. */
+  blender::threading::parallel_for(
+      blender::IndexRange(totsprings), SB_PARALLEL_GRAIN, [&](const blender::IndexRange range) {
+        _scan_for_ext_spring_forces(
+            scene, ob, timenow, int(range.first()), int(range.one_after_last()), effectors);
+      });
 
   BKE_effectors_free(effectors);
 }
@@ -1626,8 +1664,6 @@ static int sb_detect_vertex_collisionCached(float opco[3],
                                             float *intrusion)
 {
   Object *ob = nullptr;
-  GHash *hash;
-  GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], dv1[3], ve[3],
       avel[3] = {0.0, 0.0, 0.0}, vv1[3], vv2[3], vv3[3], coledge[3] = {0.0f, 0.0f, 0.0f},
       mindistedge = 1000.0f, outerforceaccu[3], innerforceaccu[3], facedist,
@@ -1636,15 +1672,15 @@ static int sb_detect_vertex_collisionCached(float opco[3],
   int a, deflected = 0, cavel = 0, ci = 0;
   /* init */
   *intrusion = 0.0f;
-  hash = vertexowner->soft->scratch->colliderhash;
-  ihash = BLI_ghashIterator_new(hash);
+  const SBScratch *scratch = vertexowner->soft->scratch;
+  blender::Vector<int, 16> deflectors;
+  ccd_find_deflectors(scratch, opco, opco, deflectors);
   outerforceaccu[0] = outerforceaccu[1] = outerforceaccu[2] = 0.0f;
   innerforceaccu[0] = innerforceaccu[1] = innerforceaccu[2] = 0.0f;
   /* go */
-  while (!BLI_ghashIterator_done(ihash)) {
-
-    ccd_Mesh *ccdm = static_cast<ccd_Mesh *>(BLI_ghashIterator_getValue(ihash));
-    ob = static_cast<Object *>(BLI_ghashIterator_getKey(ihash));
+  for (const int deflector : deflectors) {
+    ccd_Mesh *ccdm = scratch->deflector_meshes[deflector];
+    ob = scratch->deflector_objects[deflector];
     {
       /* only with deflecting set */
       if (ob->pd && ob->pd->deflect) {
@@ -1672,14 +1708,12 @@ static int sb_detect_vertex_collisionCached(float opco[3],
               (opco[1] > maxy) || (opco[2] > maxz))
           {
             /* Outside the padded bound-box -> collision object is too far away. */
-            BLI_ghashIterator_step(ihash);
             continue;
           }
         }
         else {
           /* Aye that should be cached. */
           CLOG_ERROR(&LOG, "missing cache error");
-          BLI_ghashIterator_step(ihash);
           continue;
         }
 
@@ -1772,9 +1806,8 @@ static int sb_detect_vertex_collisionCached(float opco[3],
           vt++;
         } /* while a */
       }   /* if (ob->pd && ob->pd->deflect) */
-      BLI_ghashIterator_step(ihash);
     }
-  } /* while () */
+  } /* for (deflectors) */
 
   if (deflected == 1) { /* no face but 'outer' edge cylinder sees vert */
     force_mag_norm = float(exp(double() - ee * mindistedge));
@@ -1795,7 +1828,6 @@ static int sb_detect_vertex_collisionCached(float opco[3],
     add_v3_v3(force, outerforceaccu);
   }
 
-  BLI_ghashIterator_free(ihash);
   if (cavel) {
     mul_v3_fl(avel, 1.0f / float(cavel));
   }
@@ -2178,91 +2210,31 @@ static int _softbody_calc_forces_slice_in_a_thread(Scene *scene,
   return 0; /* Done fine. */
 }
 
-static void *exec_softbody_calc_forces(void *data)
-{
-  SB_thread_context *pctx = (SB_thread_context *)data;
-  _softbody_calc_forces_slice_in_a_thread(pctx->scene,
-                                          pctx->ob,
-                                          pctx->forcetime,
-                                          pctx->timenow,
-                                          pctx->ifirst,
-                                          pctx->ilast,
-                                          nullptr,
-                                          pctx->effectors,
-                                          pctx->do_deflector,
-                                          pctx->fieldfactor,
-                                          pctx->windfactor);
-  return nullptr;
-}
-
 static void sb_cf_threads_run(Scene *scene,
                               Object *ob,
                               float forcetime,
                               float timenow,
                               int totpoint,
-                              int *ptr_to_break_func(void),
                               ListBase *effectors,
                               int do_deflector,
                               float fieldfactor,
                               float windfactor)
 {
-  UNUSED_VARS(ptr_to_break_func);
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
-  /* wild guess .. may increase with better thread management 'above'
-   * or even be UI option sb->spawn_cf_threads_nopts. */
-  int lowpoints = 100;
-
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* What if we got zillions of CPUs running but less to spread. */
-  while ((totpoint / totthread < lowpoints) && (totthread > 1)) {
-    totthread--;
-  }
-
-  // printf("sb_cf_threads_run spawning %d threads\n", totthread);
-
-  sb_threads = static_cast<SB_thread_context *>(
-      MEM_callocN(sizeof(SB_thread_context) * totthread, "SBThread"));
-  left = totpoint;
-  dec = totpoint / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = forcetime;
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
-    }
-    else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = do_deflector;
-    sb_threads[i].fieldfactor = fieldfactor;
-    sb_threads[i].windfactor = windfactor;
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
-  }
-
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_softbody_calc_forces, totthread);
-
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
-    }
-
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_softbody_calc_forces(&sb_threads[0]);
-  }
-  /* clean up */
-  MEM_freeN(sb_threads);
+  /* Points only write their own forces, see #_softbody_calc_forces_slice_in_a_thread. */
+  blender::threading::parallel_for(
+      blender::IndexRange(totpoint), SB_PARALLEL_GRAIN, [&](const blender::IndexRange range) {
+        _softbody_calc_forces_slice_in_a_thread(scene,
+                                                ob,
+                                                forcetime,
+                                                timenow,
+                                                int(range.first()),
+                                                int(range.one_after_last()),
+                                                nullptr,
+                                                effectors,
+                                                do_deflector,
+                                                fieldfactor,
+                                                windfactor);
+      });
 }
 
 static void softbody_calc_forces(
@@ -2294,7 +2266,7 @@ static void softbody_calc_forces(
   // bproot = sb->bpoint; /* Need this for proper spring addressing. */                /* UNUSED */
 
   if (do_springcollision || do_aero) {
-    sb_sfesf_threads_run(depsgraph, scene, ob, timenow, sb->totspring, nullptr);
+    sb_sfesf_threads_run(depsgraph, scene, ob, timenow, sb->totspring);
   }
 
   /* After spring scan because it uses effectors too. */
@@ -2310,7 +2282,6 @@ static void softbody_calc_forces(
                     forcetime,
                     timenow,
                     sb->totpoint,
-                    nullptr,
                     effectors,
                     do_deflector,
                     fieldfactor,
@@ -3389,6 +3360,8 @@ static void softbody_step(
     sb->scratch->needstobuildcollider = 0;
   }
 
+  ccd_build_deflector_tree(sb->scratch);
+
   if (sb->solver_ID < 2) {
     /* special case of 2nd order Runge-Kutta type AKA Heun */
     int mid_flags = 0;
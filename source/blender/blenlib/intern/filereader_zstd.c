@@ -13,9 +13,26 @@
 #include "BLI_endian_switch.h"
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
+/** Upper bound for the frames decompressed ahead of the reader, one per thread. */
+#define ZSTD_READAHEAD_THREADS_MAX 8
+
+/** Frame decompressed by a readahead thread. */
+typedef struct ZstdReadaheadTask {
+  /** Frame index, -1 when the task is unused. */
+  int frame;
+  bool ok;
+  ZSTD_DCtx *ctx;
+
+  char *compressed_data;
+  size_t compressed_size;
+  char *uncompressed_data;
+  size_t uncompressed_size;
+} ZstdReadaheadTask;
+
 typedef struct {
   FileReader reader;
 
@@ -33,6 +50,18 @@ typedef struct {
     char *cached_content;
     int cached_frame;
   } seek;
+
+  /**
+   * Once frames are read in order, the following frames are decompressed in parallel while the
+   * reader consumes the current one. Only the reader thread accesses the base #FileReader.
+   */
+  struct {
+    ListBase threadpool;
+    ZstdReadaheadTask *tasks;
+    int tasks_num;
+    /** Next frame to hand to a readahead thread. */
+    int next_frame;
+  } readahead;
 } ZstdReader;
 
 static bool zstd_read_u32(FileReader *base, uint32_t *val)
@@ -155,6 +184,141 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
+/* Read the compressed data of the given frame from the base reader. */
+static char *zstd_frame_read_compressed(ZstdReader *zstd, int frame, size_t *r_compressed_size)
+{
+  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
+
+  char *compressed_data = MEM_mallocN(compressed_size, __func__);
+  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
+      zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
+  {
+    MEM_freeN(compressed_data);
+    return NULL;
+  }
+
+  *r_compressed_size = compressed_size;
+  return compressed_data;
+}
+
+static size_t zstd_frame_uncompressed_size(ZstdReader *zstd, int frame)
+{
+  return zstd->seek.uncompressed_ofs[frame + 1] - zstd->seek.uncompressed_ofs[frame];
+}
+
+static void *zstd_readahead_task(void *userdata)
+{
+  ZstdReadaheadTask *task = userdata;
+
+  size_t res = ZSTD_decompressDCtx(task->ctx,
+                                   task->uncompressed_data,
+                                   task->uncompressed_size,
+                                   task->compressed_data,
+                                   task->compressed_size);
+  task->ok = !ZSTD_isError(res) && res == task->uncompressed_size;
+
+  MEM_freeN(task->compressed_data);
+  task->compressed_data = NULL;
+  return NULL;
+}
+
+static void zstd_readahead_init(ZstdReader *zstd)
+{
+  /* Leave one thread for the reader, without a spare thread frames are decompressed in place. */
+  int tasks_num = min_ii(BLI_system_thread_count() - 1, ZSTD_READAHEAD_THREADS_MAX);
+  tasks_num = min_ii(tasks_num, zstd->seek.frames_num - 1);
+  if (tasks_num < 1) {
+    return;
+  }
+
+  BLI_threadpool_init(&zstd->readahead.threadpool, zstd_readahead_task, tasks_num);
+  zstd->readahead.tasks = MEM_calloc_arrayN(tasks_num, sizeof(ZstdReadaheadTask), __func__);
+  zstd->readahead.tasks_num = tasks_num;
+  zstd->readahead.next_frame = zstd->seek.frames_num;
+  for (int i = 0; i < tasks_num; i++) {
+    zstd->readahead.tasks[i].frame = -1;
+    zstd->readahead.tasks[i].ctx = ZSTD_createDCtx();
+  }
+}
+
+/* Wait for and drop all tasks of frames before `keep_frame`. */
+static void zstd_readahead_discard(ZstdReader *zstd, int keep_frame)
+{
+  for (int i = 0; i < zstd->readahead.tasks_num; i++) {
+    ZstdReadaheadTask *task = &zstd->readahead.tasks[i];
+    if (task->frame != -1 && task->frame < keep_frame) {
+      BLI_threadpool_remove(&zstd->readahead.threadpool, task);
+      MEM_SAFE_FREE(task->uncompressed_data);
+      task->frame = -1;
+    }
+  }
+}
+
+/* Hand the frames following the current one to unused tasks. */
+static void zstd_readahead_schedule(ZstdReader *zstd)
+{
+  for (int i = 0; i < zstd->readahead.tasks_num; i++) {
+    ZstdReadaheadTask *task = &zstd->readahead.tasks[i];
+    if (task->frame != -1) {
+      continue;
+    }
+    if (zstd->readahead.next_frame >= zstd->seek.frames_num) {
+      break;
+    }
+
+    const int frame = zstd->readahead.next_frame;
+    task->compressed_data = zstd_frame_read_compressed(zstd, frame, &task->compressed_size);
+    if (task->compressed_data == NULL) {
+      /* Leave the frame to the reader, which reports the error. */
+      zstd->readahead.next_frame = zstd->seek.frames_num;
+      break;
+    }
+    task->uncompressed_size = zstd_frame_uncompressed_size(zstd, frame);
+    task->uncompressed_data = MEM_mallocN(task->uncompressed_size, __func__);
+    task->frame = frame;
+    zstd->readahead.next_frame++;
+
+    BLI_threadpool_insert(&zstd->readahead.threadpool, task);
+  }
+}
+
+/* Take the given frame from the readahead tasks, NULL if it wasn't scheduled (or failed). */
+static char *zstd_readahead_take(ZstdReader *zstd, int frame)
+{
+  for (int i = 0; i < zstd->readahead.tasks_num; i++) {
+    ZstdReadaheadTask *task = &zstd->readahead.tasks[i];
+    if (task->frame != frame) {
+      continue;
+    }
+
+    BLI_threadpool_remove(&zstd->readahead.threadpool, task);
+    char *uncompressed_data = task->uncompressed_data;
+    task->uncompressed_data = NULL;
+    task->frame = -1;
+
+    if (!task->ok) {
+      MEM_freeN(uncompressed_data);
+      return NULL;
+    }
+    return uncompressed_data;
+  }
+  return NULL;
+}
+
+static void zstd_readahead_free(ZstdReader *zstd)
+{
+  if (zstd->readahead.tasks == NULL) {
+    return;
+  }
+
+  zstd_readahead_discard(zstd, INT_MAX);
+  BLI_threadpool_end(&zstd->readahead.threadpool);
+  for (int i = 0; i < zstd->readahead.tasks_num; i++) {
+    ZSTD_freeDCtx(zstd->readahead.tasks[i].ctx);
+  }
+  MEM_freeN(zstd->readahead.tasks);
+}
+
 /* Ensure that the currently loaded frame is the correct one. */
 static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
 {
@@ -164,28 +328,47 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
   }
 
   /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
+  const bool is_sequential = zstd->seek.cached_frame != -1 &&
+                             frame == zstd->seek.cached_frame + 1;
   MEM_SAFE_FREE(zstd->seek.cached_content);
+  zstd->seek.cached_frame = -1;
 
-  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
-  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
-                             zstd->seek.uncompressed_ofs[frame];
+  char *uncompressed_data = NULL;
+  if (zstd->readahead.tasks) {
+    /* Frames before the wanted one won't be needed anymore. */
+    zstd_readahead_discard(zstd, frame);
+    uncompressed_data = zstd_readahead_take(zstd, frame);
+    if (uncompressed_data == NULL) {
+      /* Start reading ahead once frames are read in order, stop on random access. */
+      zstd_readahead_discard(zstd, INT_MAX);
+      zstd->readahead.next_frame = is_sequential ? frame + 1 : zstd->seek.frames_num;
+    }
+  }
 
-  char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
-  char *compressed_data = MEM_mallocN(compressed_size, __func__);
-  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
-      zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
-  {
+  if (uncompressed_data == NULL) {
+    size_t compressed_size;
+    size_t uncompressed_size = zstd_frame_uncompressed_size(zstd, frame);
+    char *compressed_data = zstd_frame_read_compressed(zstd, frame, &compressed_size);
+    if (compressed_data == NULL) {
+      return NULL;
+    }
+    if (zstd->readahead.tasks) {
+      /* Let the following frames decompress while this one does. */
+      zstd_readahead_schedule(zstd);
+    }
+
+    uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
+    size_t res = ZSTD_decompressDCtx(
+        zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
     MEM_freeN(compressed_data);
-    MEM_freeN(uncompressed_data);
-    return NULL;
+    if (ZSTD_isError(res) || res < uncompressed_size) {
+      MEM_freeN(uncompressed_data);
+      return NULL;
+    }
   }
 
-  size_t res = ZSTD_decompressDCtx(
-      zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
-  MEM_freeN(compressed_data);
-  if (ZSTD_isError(res) || res < uncompressed_size) {
-    MEM_freeN(uncompressed_data);
-    return NULL;
+  if (zstd->readahead.tasks) {
+    zstd_readahead_schedule(zstd);
   }
 
   zstd->seek.cached_frame = frame;
@@ -281,6 +464,7 @@ static void zstd_close(FileReader *reader)
 
   ZSTD_freeDCtx(zstd->ctx);
   if (zstd->reader.seek) {
+    zstd_readahead_free(zstd);
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
     /* When an error has occurred this may be NULL, see: #99744. */
@@ -306,6 +490,7 @@ FileReader *BLI_filereader_new_zstd(FileReader *base)
   if (zstd_read_seek_table(zstd)) {
     zstd->reader.read = zstd_read_seekable;
     zstd->reader.seek = zstd_seek;
+    zstd_readahead_init(zstd);
   }
   else {
     zstd->reader.read = zstd_read;
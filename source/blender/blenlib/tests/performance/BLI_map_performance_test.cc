@@ -0,0 +1,127 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_ghash.h"
+#include "BLI_map.hh"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+#include "PIL_time_utildefines.h"
+
+/* Pointer remapping as done when reading `.blend` files: the old addresses of all blocks are
+ * inserted with their new address, then every stored pointer is looked up. The lookups mostly
+ * follow the order the blocks were written in. */
+
+namespace blender::tests {
+
+struct RemapAddress {
+  void *newp;
+  int nr;
+};
+
+struct RemapData {
+  Vector<void *> blocks;
+  /** Old addresses in lookup order. */
+  Vector<const void *> lookups;
+
+  RemapData(const int count)
+  {
+    RandomNumberGenerator rng(0);
+    blocks.reserve(count);
+    for (int i = 0; i < count; i++) {
+      /* Mostly small structs with some large arrays in between, like the blocks of a mesh. */
+      const size_t size = (rng.get_int32(50) == 0) ? 4096 : 16 * (1 + rng.get_int32(8));
+      blocks.append(MEM_mallocN(size, __func__));
+    }
+    lookups.extend(blocks.as_span().cast<const void *>());
+    for (int i = 0; i < count / 10; i++) {
+      std::swap(lookups[rng.get_int32(count)], lookups[rng.get_int32(count)]);
+    }
+  }
+
+  ~RemapData()
+  {
+    for (void *block : blocks) {
+      MEM_freeN(block);
+    }
+  }
+};
+
+static void map_remap_test(const RemapData &data, const bool reserve, const char *id)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  Map<const void *, RemapAddress> map;
+  {
+    TIMEIT_START(ptr_insert);
+    if (reserve) {
+      map.reserve(data.blocks.size());
+    }
+    for (void *block : data.blocks) {
+      map.add_overwrite(block, RemapAddress{block, 0});
+    }
+    TIMEIT_END(ptr_insert);
+  }
+
+  {
+    TIMEIT_START(ptr_lookup);
+    for (const void *old : data.lookups) {
+      RemapAddress *entry = map.lookup_ptr(old);
+      entry->nr++;
+      EXPECT_EQ(entry->newp, old);
+    }
+    TIMEIT_END(ptr_lookup);
+  }
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+static void ghash_remap_test(const RemapData &data, const char *id)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  GHash *ghash = BLI_ghash_ptr_new(__func__);
+  {
+    TIMEIT_START(ptr_insert);
+    BLI_ghash_reserve(ghash, data.blocks.size());
+    for (void *block : data.blocks) {
+      BLI_ghash_insert(ghash, block, block);
+    }
+    TIMEIT_END(ptr_insert);
+  }
+
+  {
+    TIMEIT_START(ptr_lookup);
+    for (const void *old : data.lookups) {
+      EXPECT_EQ(BLI_ghash_lookup(ghash, old), old);
+    }
+    TIMEIT_END(ptr_lookup);
+  }
+
+  BLI_ghash_free(ghash, nullptr, nullptr);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(map, PointerRemap12000)
+{
+  const RemapData data(12000);
+  map_remap_test(data, false, "Map 12000");
+  map_remap_test(data, true, "Map 12000 (reserved)");
+  ghash_remap_test(data, "GHash 12000 (reserved)");
+}
+
+TEST(map, PointerRemap5000000)
+{
+  const RemapData data(5000000);
+  map_remap_test(data, false, "Map 5000000");
+  map_remap_test(data, true, "Map 5000000 (reserved)");
+  ghash_remap_test(data, "GHash 5000000 (reserved)");
+}
+
+}  // namespace blender::tests
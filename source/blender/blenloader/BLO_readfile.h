@@ -97,6 +97,11 @@ typedef struct BlendFileReadReport {
   /** Timing information. */
   struct {
     double whole;
+    /** Reading the blocks of the main file, including direct-linking done while reading. */
+    double read_blocks;
+    /** Direct-linking of IDs deferred while reading the blocks, done in parallel. Zero when no
+     * IDs were deferred. */
+    double direct_link;
     double libraries;
     double lib_overrides;
     double lib_overrides_resync;
@@ -23,6 +23,11 @@ struct MemFileChunk {
   size_t size;
   /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
   bool is_identical;
+  /**
+   * When true, the memory belongs to the global chunk store and is shared by content with other
+   * chunks, freeing it only releases one user (the owning chunk, see #is_identical).
+   */
+  bool is_content_shared;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
    * Defined when writing the next step (i.e. last undo step has those always false). */
@@ -30,6 +35,8 @@ struct MemFileChunk {
   /** Session UUID of the ID being currently written (MAIN_ID_SESSION_UUID_UNSET when not writing
    * ID-related data). Used to find matching chunks in previous memundo step. */
   uint id_session_uuid;
+  /** Hash of the data, only set when #is_content_shared. */
+  uint content_hash;
 };
 
 struct MemFile {
@@ -46,6 +46,12 @@ struct BlendFileWriteParams {
   /** On write, restore paths after editing them (see #BLO_WRITE_PATH_REMAP_RELATIVE). */
   uint use_save_as_copy : 1;
   uint use_userdef : 1;
+  /**
+   * Only append the data that changed since the last save of this file in the current session,
+   * see `blend_delta.hh`. Falls back to writing the full file when that is not possible and every
+   * few saves, to compact it. Version backups are only made by full saves.
+   */
+  uint use_delta : 1;
   const struct BlendThumbnail *thumb;
 };
 
@@ -0,0 +1,303 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup blenloader
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_filereader.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_report.h"
+
+#include "blend_delta.hh"
+
+using blender::Array;
+using blender::Span;
+using blender::Vector;
+
+static_assert(sizeof(BlendDeltaSpan) == 16, "Delta index entries are stored as is");
+static_assert(sizeof(BlendDeltaTrailer) == 40, "Delta trailer is stored as is");
+
+struct DeltaFileReader {
+  FileReader reader;
+
+  FileReader *base;
+  Array<BlendDeltaSpan> spans;
+  /** Stream offset of every span, for looking up spans by offset. */
+  Array<uint64_t> span_starts;
+  uint64_t stream_size;
+  /** Span of the last read, reading is mostly sequential. */
+  int64_t span_index;
+};
+
+static bool base_read_at(FileReader *base, void *buffer, const uint64_t offset, const size_t size)
+{
+  if (base->seek(base, off64_t(offset), SEEK_SET) == -1) {
+    return false;
+  }
+  return base->read(base, buffer, size) == int64_t(size);
+}
+
+void blo_delta_span_append(Vector<BlendDeltaSpan> &spans, const BlendDeltaSpan &span)
+{
+  if (!spans.is_empty() && spans.last().offset + spans.last().size == span.offset) {
+    spans.last().size += span.size;
+  }
+  else {
+    spans.append(span);
+  }
+}
+
+static bool write_all(const int file_handle, const void *buf, const size_t size)
+{
+  return write(file_handle, buf, size) == int64_t(size);
+}
+
+static bool file_sync(const int file_handle)
+{
+#ifdef WIN32
+  return _commit(file_handle) == 0;
+#else
+  return fsync(file_handle) == 0;
+#endif
+}
+
+bool blo_delta_index_write(const int file_handle,
+                           const uint64_t index_offset,
+                           const Span<BlendDeltaSpan> spans,
+                           const uint64_t stream_size,
+                           const uint32_t saves_num)
+{
+  BlendDeltaTrailer trailer{};
+  trailer.index_offset = index_offset;
+  trailer.spans_num = uint64_t(spans.size());
+  trailer.stream_size = stream_size;
+  trailer.saves_num = saves_num;
+  trailer.version = BLEND_DELTA_VERSION;
+  memcpy(trailer.magic, BLEND_DELTA_MAGIC, sizeof(trailer.magic));
+
+  /* The trailer makes the save valid, it's only written once all spans are stored. */
+  return write_all(file_handle, spans.data(), size_t(spans.size_in_bytes())) &&
+         file_sync(file_handle) && write_all(file_handle, &trailer, sizeof(trailer)) &&
+         file_sync(file_handle);
+}
+
+static int64_t delta_span_find(DeltaFileReader *delta, const uint64_t offset)
+{
+  const int64_t index = delta->span_index;
+  if (offset >= delta->span_starts[index] &&
+      offset < delta->span_starts[index] + delta->spans[index].size)
+  {
+    return index;
+  }
+  if (index + 1 < delta->spans.size() && offset >= delta->span_starts[index + 1] &&
+      offset < delta->span_starts[index + 1] + delta->spans[index + 1].size)
+  {
+    return index + 1;
+  }
+  const uint64_t *start = std::upper_bound(
+      delta->span_starts.begin(), delta->span_starts.end(), offset);
+  return int64_t(start - delta->span_starts.begin()) - 1;
+}
+
+static int64_t delta_read(FileReader *reader, void *buffer, size_t size)
+{
+  DeltaFileReader *delta = (DeltaFileReader *)reader;
+  size_t totread = 0;
+
+  while (totread < size && uint64_t(delta->reader.offset) < delta->stream_size) {
+    const uint64_t offset = uint64_t(delta->reader.offset);
+    delta->span_index = delta_span_find(delta, offset);
+
+    const BlendDeltaSpan &span = delta->spans[delta->span_index];
+    const uint64_t span_offset = offset - delta->span_starts[delta->span_index];
+    const size_t readsize = size_t(std::min<uint64_t>(size - totread, span.size - span_offset));
+
+    if (!base_read_at(
+            delta->base, POINTER_OFFSET(buffer, totread), span.offset + span_offset, readsize))
+    {
+      break;
+    }
+    totread += readsize;
+    delta->reader.offset += off64_t(readsize);
+  }
+
+  return int64_t(totread);
+}
+
+static off64_t delta_seek(FileReader *reader, off64_t offset, int whence)
+{
+  DeltaFileReader *delta = (DeltaFileReader *)reader;
+  off64_t new_pos;
+  if (whence == SEEK_CUR) {
+    new_pos = delta->reader.offset + offset;
+  }
+  else if (whence == SEEK_SET) {
+    new_pos = offset;
+  }
+  else if (whence == SEEK_END) {
+    new_pos = off64_t(delta->stream_size) + offset;
+  }
+  else {
+    return -1;
+  }
+  if (new_pos < 0 || uint64_t(new_pos) > delta->stream_size) {
+    return -1;
+  }
+  delta->reader.offset = new_pos;
+  return delta->reader.offset;
+}
+
+static void delta_close(FileReader *reader)
+{
+  DeltaFileReader *delta = (DeltaFileReader *)reader;
+  delta->base->close(delta->base);
+  MEM_delete(delta);
+}
+
+/**
+ * Read the trailer ending at \a trailer_end and the index it refers to.
+ * \return false when there is no valid index.
+ */
+static bool delta_index_read(FileReader *file,
+                             const uint64_t trailer_end,
+                             BlendDeltaTrailer &r_trailer,
+                             Array<BlendDeltaSpan> &r_spans)
+{
+  if (trailer_end < sizeof(BlendDeltaTrailer) ||
+      !base_read_at(
+          file, &r_trailer, trailer_end - sizeof(BlendDeltaTrailer), sizeof(BlendDeltaTrailer)) ||
+      memcmp(r_trailer.magic, BLEND_DELTA_MAGIC, sizeof(r_trailer.magic)) != 0)
+  {
+    return false;
+  }
+  if (r_trailer.version != BLEND_DELTA_VERSION || r_trailer.spans_num == 0 ||
+      r_trailer.spans_num > trailer_end / sizeof(BlendDeltaSpan))
+  {
+    return false;
+  }
+  /* The index is written right before the trailer. */
+  const uint64_t index_size = r_trailer.spans_num * sizeof(BlendDeltaSpan);
+  if (r_trailer.index_offset + index_size + sizeof(BlendDeltaTrailer) != trailer_end) {
+    return false;
+  }
+
+  r_spans.reinitialize(int64_t(r_trailer.spans_num));
+  if (!base_read_at(file, r_spans.data(), r_trailer.index_offset, size_t(index_size))) {
+    return false;
+  }
+  uint64_t stream_size = 0;
+  for (const BlendDeltaSpan &span : r_spans) {
+    if (span.size == 0 || span.offset + span.size > r_trailer.index_offset) {
+      return false;
+    }
+    stream_size += span.size;
+  }
+  return stream_size == r_trailer.stream_size;
+}
+
+/**
+ * Find the last complete delta save in a file with an incomplete one at the end, by searching
+ * backwards for a valid trailer.
+ */
+static bool delta_index_find_last(FileReader *file,
+                                  const uint64_t file_size,
+                                  BlendDeltaTrailer &r_trailer,
+                                  Array<BlendDeltaSpan> &r_spans)
+{
+  const uint64_t magic_size = sizeof(r_trailer.magic);
+  const uint64_t block_size = 1 << 20;
+  Array<char> block(int64_t(block_size + magic_size));
+
+  uint64_t block_end = file_size;
+  while (block_end > 0) {
+    const uint64_t block_start = block_end > block_size ? block_end - block_size : 0;
+    /* Read a bit more than the block, to find a magic crossing the end of the block too. */
+    const uint64_t read_size = std::min(file_size, block_end + magic_size - 1) - block_start;
+    if (read_size < magic_size || !base_read_at(file, block.data(), block_start, read_size)) {
+      return false;
+    }
+    for (uint64_t i = std::min(block_end - block_start, read_size - magic_size + 1); i-- > 0;) {
+      if (memcmp(&block[int64_t(i)], BLEND_DELTA_MAGIC, magic_size) == 0 &&
+          delta_index_read(file, block_start + i + magic_size, r_trailer, r_spans))
+      {
+        return true;
+      }
+    }
+    block_end = block_start;
+  }
+  return false;
+}
+
+/** Regular `.blend` files end with the #BLO_CODE_ENDB block header. */
+static bool file_ends_with_endb(FileReader *file, const uint64_t file_size)
+{
+  /* Block headers of 64 bit files are 24 bytes, of 32 bit files 20 bytes. */
+  char tail[24];
+  if (file_size < sizeof(tail) ||
+      !base_read_at(file, tail, file_size - sizeof(tail), sizeof(tail)))
+  {
+    return false;
+  }
+  return memcmp(tail, "ENDB", 4) == 0 || memcmp(tail + 4, "ENDB", 4) == 0;
+}
+
+FileReader *blo_delta_filereader_ensure(FileReader *file,
+                                        const char *filepath,
+                                        ReportList *reports)
+{
+  const off64_t file_size = file->seek(file, 0, SEEK_END);
+  if (file_size <= 0) {
+    file->seek(file, 0, SEEK_SET);
+    return file;
+  }
+
+  BlendDeltaTrailer trailer;
+  Array<BlendDeltaSpan> spans;
+  bool is_delta = delta_index_read(file, uint64_t(file_size), trailer, spans);
+  if (!is_delta && !file_ends_with_endb(file, uint64_t(file_size))) {
+    /* Neither a regular file nor a valid index at the end, the last delta save was interrupted.
+     * Without a complete delta save before it, the full save is the last complete one. */
+    is_delta = delta_index_find_last(file, uint64_t(file_size), trailer, spans);
+    BKE_reportf(reports,
+                RPT_WARNING,
+                "File '%s' ends with an incomplete save, the last complete save is read instead",
+                filepath);
+  }
+  file->seek(file, 0, SEEK_SET);
+
+  if (!is_delta) {
+    return file;
+  }
+
+  DeltaFileReader *delta = MEM_new<DeltaFileReader>(__func__);
+  delta->span_starts.reinitialize(spans.size());
+  uint64_t stream_size = 0;
+  for (const int64_t i : spans.index_range()) {
+    delta->span_starts[i] = stream_size;
+    stream_size += spans[i].size;
+  }
+  delta->spans = std::move(spans);
+  delta->base = file;
+  delta->stream_size = stream_size;
+  delta->span_index = 0;
+  delta->reader.read = delta_read;
+  delta->reader.seek = delta_seek;
+  delta->reader.close = delta_close;
+  delta->reader.offset = 0;
+  return (FileReader *)delta;
+}
@@ -0,0 +1,76 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup blenloader
+ *
+ * Delta saved `.blend` files (see #BlendFileWriteParams.use_delta).
+ *
+ * A delta save only appends the chunks of the file stream that are not stored in the file yet,
+ * followed by an index of spans that make up the stream and a trailer:
+ *
+ * `BLENDER... (full save) | new chunks | index (BlendDeltaSpan[spans_num]) | trailer | ...`
+ *
+ * Reading the spans in order gives the same bytes a full save would have written. Files without
+ * trailer are regular `.blend` files, every full save (compaction) writes one of these.
+ *
+ * Appending is not atomic, a crash while appending leaves a file that ends neither with a trailer
+ * nor with the end of a regular `.blend` file. Such a file is read from the last complete trailer
+ * in it (or as the last full save if there is none), with a warning.
+ */
+
+#include <cstdint>
+
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+struct FileReader;
+struct ReportList;
+
+/** Part of the file stream, stored at #offset in the file. */
+struct BlendDeltaSpan {
+  uint64_t offset;
+  uint64_t size;
+};
+
+/** Last bytes of a delta saved file. */
+struct BlendDeltaTrailer {
+  uint64_t index_offset;
+  uint64_t spans_num;
+  /** Size of the file stream (sum of all spans). */
+  uint64_t stream_size;
+  /** Number of delta saves since the last full save. */
+  uint32_t saves_num;
+  uint32_t version;
+  char magic[8];
+};
+
+#define BLEND_DELTA_VERSION 1
+#define BLEND_DELTA_MAGIC "BLENDDLT"
+
+/** Add \a span to the end of the stream, merging it with the last span when they are adjacent. */
+void blo_delta_span_append(blender::Vector<BlendDeltaSpan> &spans, const BlendDeltaSpan &span);
+
+/**
+ * Write the index of \a spans and the trailer at \a index_offset, the current end of the file.
+ * Everything written before is synced to disk first, so the trailer can't end up in the file
+ * without the data it refers to.
+ */
+bool blo_delta_index_write(int file_handle,
+                           uint64_t index_offset,
+                           blender::Span<BlendDeltaSpan> spans,
+                           uint64_t stream_size,
+                           uint32_t saves_num);
+
+/**
+ * Wrap \a file in a reader of the stream stored by delta saves, when the file has a delta trailer.
+ * Files with an interrupted delta save are reported to \a reports.
+ *
+ * \return the new reader taking ownership of \a file, or \a file itself for regular files.
+ */
+FileReader *blo_delta_filereader_ensure(FileReader *file,
+                                        const char *filepath,
+                                        ReportList *reports);
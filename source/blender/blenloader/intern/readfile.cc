@@ -55,7 +55,9 @@
 #include "BLI_map.hh"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "PIL_time.h"
 
@@ -105,6 +107,7 @@
 #include "SEQ_sequencer.h"
 #include "SEQ_utils.h"
 
+#include "blend_delta.hh"
 #include "readfile.hh"
 
 /* Make preferences read-only. */
@@ -169,6 +172,13 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Direct-link meshes, images and node trees in parallel once all blocks of the file are read.
+ * Reading the blocks stays single threaded, each of these IDs keeps its own data map so the
+ * linking tasks don't share any lookups. Not used for undo, which restores IDs in place.
+ */
+#define USE_PARALLEL_DIRECT_LINK
+
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
@@ -264,6 +274,15 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
   onm->map.add_overwrite(oldaddr, NewAddress{newaddr, nr});
 }
 
+/**
+ * Make room for \a count more entries, so filling a map with the data of large IDs (meshes with
+ * many layers, node trees) does not grow and re-hash it over and over.
+ */
+static void oldnewmap_reserve(OldNewMap *onm, const int64_t count)
+{
+  onm->map.reserve(onm->map.size() + count);
+}
+
 static void oldnewmap_lib_insert(FileData *fd, const void *oldaddr, ID *newaddr, int id_code)
 {
   oldnewmap_insert(fd->libmap, oldaddr, newaddr, id_code);
@@ -319,6 +338,23 @@ static void oldnewmap_free(OldNewMap *onm)
   MEM_delete(onm);
 }
 
+/** ID read by #read_libblock whose direct-linking is left to #read_direct_link_queue_end. */
+struct DirectLinkTask {
+  Main *main;
+  ID *id;
+  int id_tag;
+  /** Data of the ID by old address, owned by the task. */
+  OldNewMap *datamap;
+  bool success;
+  bool file_ok;
+  /** Reports of the task, added to the file reports in the order the IDs were read. */
+  ReportList reports;
+};
+
+struct DirectLinkQueue {
+  blender::Vector<DirectLinkTask> tasks;
+};
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1195,6 +1231,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
       file = rawfile;
       rawfile = nullptr;
     }
+    /* Files written by delta saves have their latest state indexed at the end. */
+    file = blo_delta_filereader_ensure(file, filepath, reports->reports);
   }
   else if (BLI_file_magic_is_gzip(header)) {
     file = BLI_filereader_new_gzip(rawfile);
@@ -1362,6 +1400,7 @@ void blo_filedata_free(FileData *fd)
     if (fd->new_idmap_uuid != nullptr) {
       BKE_main_idmap_destroy(fd->new_idmap_uuid);
     }
+    BLI_assert(fd->direct_link_queue == nullptr);
     blo_cache_storage_end(fd);
     if (fd->bheadmap) {
       MEM_freeN(fd->bheadmap);
@@ -2059,9 +2098,10 @@ static int direct_link_id_restore_recalc(const FileData *fd,
 static void direct_link_id_common(
     BlendDataReader *reader, Library *current_library, ID *id, ID *id_old, const int id_tag)
 {
-  if (!BLO_read_data_is_undo(reader)) {
+  if (!BLO_read_data_is_undo(reader) && !reader->fd->is_direct_link_task) {
     /* When actually reading a file, we do want to reset/re-generate session UUIDS.
-     * In undo case, we want to re-use existing ones. */
+     * In undo case, we want to re-use existing ones. IDs linked in parallel got theirs while
+     * reading already. */
     id->session_uuid = MAIN_ID_SESSION_UUID_UNSET;
   }
 
@@ -2527,6 +2567,14 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
 {
   bhead = blo_bhead_next(fd, bhead);
 
+  int64_t data_num = 0;
+  for (BHead *bhead_iter = bhead; bhead_iter && bhead_iter->code == BLO_CODE_DATA;
+       bhead_iter = blo_bhead_next(fd, bhead_iter))
+  {
+    data_num++;
+  }
+  oldnewmap_reserve(fd->datamap, data_num);
+
   while (bhead && bhead->code == BLO_CODE_DATA) {
     /* The code below is useful for debugging leaks in data read from the blend file.
      * Without this the messages only tell us what ID-type the memory came from,
@@ -2925,6 +2973,69 @@ static bool read_libblock_undo_restore(
   return false;
 }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+
+static void read_direct_link_queue_begin(FileData *fd)
+{
+  BLI_assert(fd->direct_link_queue == nullptr);
+  fd->direct_link_queue = MEM_new<DirectLinkQueue>(__func__);
+}
+
+/**
+ * Direct-link all IDs queued by #read_libblock in parallel.
+ * \return Whether any IDs were queued.
+ */
+static bool read_direct_link_queue_end(FileData *fd)
+{
+  DirectLinkQueue *queue = fd->direct_link_queue;
+  if (queue == nullptr) {
+    return false;
+  }
+  const bool has_tasks = !queue->tasks.is_empty();
+
+  /* Only the packed data of undo steps is shared between IDs, and undo does not queue IDs. */
+  BLI_assert(fd->packedmap == nullptr);
+
+  blender::threading::parallel_for(
+      queue->tasks.index_range(), 1, [&](const blender::IndexRange range) {
+        for (DirectLinkTask &task : queue->tasks.as_mutable_span().slice(range)) {
+          /* Each task gets its own file data with the members that are written while linking
+           * replaced: the data map, the flags and the reports. The others are only read. */
+          FileData task_fd = *fd;
+          task_fd.datamap = task.datamap;
+          task_fd.is_direct_link_task = true;
+          BlendFileReadReport task_reports = *fd->reports;
+          task_reports.reports = &task.reports;
+          task_fd.reports = &task_reports;
+
+          task.success = direct_link_id(&task_fd, task.main, task.id_tag, task.id, nullptr);
+          task.file_ok = (task_fd.flags & FD_FLAGS_FILE_OK) != 0;
+          oldnewmap_clear(task.datamap);
+        }
+      });
+
+  for (DirectLinkTask &task : queue->tasks) {
+    oldnewmap_free(task.datamap);
+    LISTBASE_FOREACH (const Report *, report, &task.reports.list) {
+      BKE_report(fd->reports->reports, eReportType(report->type), report->message);
+    }
+    BKE_reports_clear(&task.reports);
+    if (!task.file_ok) {
+      fd->flags &= ~FD_FLAGS_FILE_OK;
+    }
+    if (!task.success) {
+      /* See the comment about the failure case in #read_libblock. */
+      BKE_id_free(task.main, task.id);
+    }
+  }
+
+  MEM_delete(queue);
+  fd->direct_link_queue = nullptr;
+  return has_tasks;
+}
+
+#endif
+
 /* This routine reads a datablock and its direct data, and advances bhead to
  * the next datablock. For library linked datablocks, only a placeholder will
  * be generated, to be replaced in read_library_linked_ids.
@@ -3024,6 +3135,32 @@ static BHead *read_libblock(FileData *fd,
    * Use convenient malloc name for debugging and better memory link prints. */
   const char *allocname = dataname(idcode);
   bhead = read_data_into_datamap(fd, bhead, allocname);
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+  if (fd->direct_link_queue && id_old == nullptr && main->id_map == nullptr &&
+      ELEM(idcode, ID_ME, ID_IM, ID_NT))
+  {
+    /* Assign the session UUID now, so it does not depend on the order the tasks run in. */
+    id->session_uuid = MAIN_ID_SESSION_UUID_UNSET;
+    if ((id_tag & LIB_TAG_TEMP_MAIN) == 0) {
+      BKE_lib_libblock_session_uuid_ensure(id);
+    }
+    /* The task takes over the data map. */
+    fd->direct_link_queue->tasks.append_as();
+    DirectLinkTask &task = fd->direct_link_queue->tasks.last();
+    task.main = main;
+    task.id = id;
+    task.id_tag = id_tag;
+    task.datamap = fd->datamap;
+    task.success = false;
+    task.file_ok = true;
+    BKE_reports_init(&task.reports, RPT_STORE);
+    task.reports.storelevel = RPT_DEBUG;
+    fd->datamap = oldnewmap_new();
+    return bhead;
+  }
+#endif
+
   const bool success = direct_link_id(fd, main, id_tag, id, id_old);
   oldnewmap_clear(fd->datamap);
 
@@ -3618,6 +3755,13 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     read_undo_reuse_noundo_local_ids(fd);
   }
 
+  fd->reports->duration.read_blocks = PIL_check_seconds_timer();
+#ifdef USE_PARALLEL_DIRECT_LINK
+  if (!is_undo && (fd->skip_flags & BLO_READ_SKIP_DATA) == 0) {
+    read_direct_link_queue_begin(fd);
+  }
+#endif
+
   while (bhead) {
     switch (bhead->code) {
       case BLO_CODE_DATA:
@@ -3669,10 +3813,22 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     }
 
     if (bfd->main->is_read_invalid) {
+#ifdef USE_PARALLEL_DIRECT_LINK
+      read_direct_link_queue_end(fd);
+#endif
       return bfd;
     }
   }
 
+  fd->reports->duration.read_blocks = PIL_check_seconds_timer() -
+                                      fd->reports->duration.read_blocks;
+#ifdef USE_PARALLEL_DIRECT_LINK
+  const double direct_link_start = PIL_check_seconds_timer();
+  if (read_direct_link_queue_end(fd)) {
+    fd->reports->duration.direct_link = PIL_check_seconds_timer() - direct_link_start;
+  }
+#endif
+
   if (is_undo) {
     /* Move the remaining Library IDs and their linked data to the new main.
      *
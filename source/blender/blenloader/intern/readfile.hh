@@ -28,6 +28,7 @@ struct BlendFileReadReport;
 struct BLOCacheStorage;
 struct BHeadSort;
 struct DNA_ReconstructInfo;
+struct DirectLinkQueue;
 struct IDNameLib_Map;
 struct Key;
 struct Main;
@@ -108,6 +109,11 @@ struct FileData {
   OldNewMap *packedmap;
   BLOCacheStorage *cache_storage;
 
+  /** IDs to direct-link in parallel once the file is read, see #USE_PARALLEL_DIRECT_LINK. */
+  DirectLinkQueue *direct_link_queue;
+  /** Set on the copies of the file data used by the parallel direct-linking tasks. */
+  bool is_direct_link_task;
+
   BHeadSort *bheadmap;
   int tot_bheadmap;
 
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <mutex>
 
 /* open/close */
 #ifndef _WIN32
@@ -26,6 +27,9 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_map.hh"
+#include "BLI_vector.hh"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.hh"
@@ -37,13 +41,100 @@
 /* keep last */
 #include "BLI_strict_flags.h"
 
+/**
+ * Share chunk memory between undo steps by content, not only by position in the file. Data that
+ * did not change but was written from a new allocation (e.g. mesh arrays after an operator
+ * re-allocated them) would otherwise be stored again in every step.
+ */
+#define USE_MEMFILE_CHUNK_CONTENT_SHARING
+
+/** Smaller chunks are mostly structs holding pointers, which rarely match by content. */
+#define MEMFILE_CHUNK_CONTENT_SIZE_MIN 4096
+
 /* **************** support for memory-write, for undo buffers *************** */
 
+#ifdef USE_MEMFILE_CHUNK_CONTENT_SHARING
+
+/** Chunk buffer in the global store, shared by all chunks with the same content. */
+struct MemFileSharedBuffer {
+  char *buf;
+  size_t size;
+  /** Number of owning chunks (chunks with #MemFileChunk.is_identical unset). */
+  int users;
+};
+
+/** All shared chunk buffers of all memfiles, by the hash of their content. */
+static struct {
+  blender::Map<uint, blender::Vector<MemFileSharedBuffer>> buffers;
+  std::mutex mutex;
+} memfile_chunk_store;
+
+/**
+ * Find a buffer with the same content as \a buf in the store and add a user to it, or add a copy
+ * of \a buf.
+ *
+ * \return the buffer and true when existing data is shared.
+ */
+static std::pair<const char *, bool> memfile_chunk_store_add(const char *buf,
+                                                             const size_t size,
+                                                             const uint hash)
+{
+  std::lock_guard lock(memfile_chunk_store.mutex);
+  blender::Vector<MemFileSharedBuffer> &buffers =
+      memfile_chunk_store.buffers.lookup_or_add_default(hash);
+  for (MemFileSharedBuffer &shared : buffers) {
+    if (shared.size == size && memcmp(shared.buf, buf, size) == 0) {
+      shared.users++;
+      return {shared.buf, true};
+    }
+  }
+
+  char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer (shared)"));
+  memcpy(buf_new, buf, size);
+  buffers.append({buf_new, size, 1});
+  return {buf_new, false};
+}
+
+static void memfile_chunk_store_release(const char *buf, const uint hash)
+{
+  std::lock_guard lock(memfile_chunk_store.mutex);
+  blender::Vector<MemFileSharedBuffer> *buffers = memfile_chunk_store.buffers.lookup_ptr(hash);
+  BLI_assert(buffers != nullptr);
+  for (const int64_t i : buffers->index_range()) {
+    MemFileSharedBuffer &shared = (*buffers)[i];
+    if (shared.buf != buf) {
+      continue;
+    }
+    if (--shared.users == 0) {
+      MEM_freeN(shared.buf);
+      buffers->remove_and_reorder(i);
+      if (buffers->is_empty()) {
+        memfile_chunk_store.buffers.remove(hash);
+      }
+    }
+    return;
+  }
+  BLI_assert_unreachable();
+}
+
+#endif /* USE_MEMFILE_CHUNK_CONTENT_SHARING */
+
+static void memfile_chunk_buf_free(MemFileChunk *chunk)
+{
+#ifdef USE_MEMFILE_CHUNK_CONTENT_SHARING
+  if (chunk->is_content_shared) {
+    memfile_chunk_store_release(chunk->buf, chunk->content_hash);
+    return;
+  }
+#endif
+  MEM_freeN((void *)chunk->buf);
+}
+
 void BLO_memfile_free(MemFile *memfile)
 {
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
     if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
+      memfile_chunk_buf_free(chunk);
     }
     MEM_freeN(chunk);
   }
@@ -53,40 +144,39 @@ void BLO_memfile_free(MemFile *memfile)
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
   /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
-  GHash *buffer_to_second_memchunk = BLI_ghash_new(
-      BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, __func__);
+   * by it (i.e. shared with some previous memory steps). Chunks shared by content can use the same
+   * buffer several times in one memfile, so every buffer maps to all chunks using it. */
+  blender::Map<const char *, blender::Vector<MemFileChunk *>> buffer_to_second_memchunks;
 
   /* First, detect all memchunks in second memfile that are not owned by it. */
-  for (MemFileChunk *sc = static_cast<MemFileChunk *>(second->chunks.first); sc != nullptr;
-       sc = static_cast<MemFileChunk *>(sc->next))
-  {
+  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
     if (sc->is_identical) {
-      BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
+      buffer_to_second_memchunks.lookup_or_add_default(sc->buf).append(sc);
     }
   }
 
   /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
    * it is also used by the second memfile, transfer the ownership. */
-  for (MemFileChunk *fc = static_cast<MemFileChunk *>(first->chunks.first); fc != nullptr;
-       fc = static_cast<MemFileChunk *>(fc->next))
-  {
+  LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
     if (!fc->is_identical) {
-      MemFileChunk *sc = static_cast<MemFileChunk *>(
-          BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf));
-      if (sc != nullptr) {
+      /* Every owning chunk holds one user of a buffer shared by content, so ownership is handed
+       * over to one chunk of the second memfile for each owning chunk of the first. */
+      blender::Vector<MemFileChunk *> *second_chunks = buffer_to_second_memchunks.lookup_ptr(
+          fc->buf);
+      if (second_chunks != nullptr && !second_chunks->is_empty()) {
+        MemFileChunk *sc = second_chunks->pop_last();
         BLI_assert(sc->is_identical);
+        BLI_assert(sc->is_content_shared == fc->is_content_shared);
         sc->is_identical = false;
         fc->is_identical = true;
       }
       /* Note that if the second memfile does not use that chunk, we assume that the first one
        * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
+       * it. Buffers shared by content are released through the chunk store instead, so other
+       * users keep them. */
     }
   }
 
-  BLI_ghash_free(buffer_to_second_memchunk, nullptr, nullptr);
-
   BLO_memfile_free(first);
 }
 
@@ -151,6 +241,8 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->size = size;
   curchunk->buf = nullptr;
   curchunk->is_identical = false;
+  curchunk->is_content_shared = false;
+  curchunk->content_hash = 0;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
    * will then not be undo. Though it's not entirely clear that is wrong behavior. */
@@ -165,12 +257,28 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
       if (memcmp(compchunk->buf, buf, size) == 0) {
         curchunk->buf = compchunk->buf;
         curchunk->is_identical = true;
+        curchunk->is_content_shared = compchunk->is_content_shared;
+        curchunk->content_hash = compchunk->content_hash;
         compchunk->is_identical_future = true;
       }
     }
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
+#ifdef USE_MEMFILE_CHUNK_CONTENT_SHARING
+  /* Not equal to the chunk at the same position, but the same data may be stored already. */
+  if (curchunk->buf == nullptr && size >= MEMFILE_CHUNK_CONTENT_SIZE_MIN) {
+    curchunk->content_hash = BLI_hash_mm2((const uchar *)buf, size, 0);
+    curchunk->is_content_shared = true;
+    const std::pair<const char *, bool> shared = memfile_chunk_store_add(
+        buf, size, curchunk->content_hash);
+    curchunk->buf = shared.first;
+    if (!shared.second) {
+      memfile->size += size;
+    }
+  }
+#endif
+
   /* not equal... */
   if (curchunk->buf == nullptr) {
     char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
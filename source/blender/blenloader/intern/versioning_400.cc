@@ -18,6 +18,7 @@
 
 #include "DNA_brush_types.h"
 #include "DNA_camera_types.h"
+#include "DNA_cloth_types.h"
 #include "DNA_curve_types.h"
 #include "DNA_defaults.h"
 #include "DNA_light_types.h"
@@ -1942,5 +1943,30 @@ void blo_do_versions_400(FileData *fd, Library * /*lib*/, Main *bmain)
    */
   {
     /* Keep this block, even when empty. */
+
+    if (!DNA_struct_member_exists(fd->filesdna, "ClothSimSettings", "short", "adaptive_steps_min"))
+    {
+      const ClothSimSettings *default_settings = DNA_struct_default_get(ClothSimSettings);
+      auto version_cloth_settings = [&](ClothSimSettings *settings) {
+        settings->adaptive_steps_min = default_settings->adaptive_steps_min;
+        settings->adaptive_steps_max = default_settings->adaptive_steps_max;
+        settings->adaptive_cfl = default_settings->adaptive_cfl;
+      };
+      LISTBASE_FOREACH (Object *, ob, &bmain->objects) {
+        LISTBASE_FOREACH (ModifierData *, md, &ob->modifiers) {
+          if (md->type == eModifierType_Cloth) {
+            ClothModifierData *clmd = (ClothModifierData *)md;
+            if (clmd->sim_parms) {
+              version_cloth_settings(clmd->sim_parms);
+            }
+          }
+        }
+        LISTBASE_FOREACH (ParticleSystem *, psys, &ob->particlesystem) {
+          if (psys->clmd && psys->clmd->sim_parms) {
+            version_cloth_settings(psys->clmd->sim_parms);
+          }
+        }
+      }
+    }
   }
 }
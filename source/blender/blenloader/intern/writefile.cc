@@ -65,6 +65,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 #ifdef WIN32
 #  include "BLI_winstuff.h"
@@ -91,6 +94,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
+#include "BLI_hash_md5.h"
 #include "BLI_link_utils.h"
 #include "BLI_linklist.h"
 #include "BLI_math_base.h"
@@ -122,6 +126,7 @@
 #include "BLO_undofile.hh"
 #include "BLO_writefile.hh"
 
+#include "blend_delta.hh"
 #include "readfile.hh"
 
 #include <zstd.h>
@@ -152,8 +157,11 @@ static CLG_LogRef LOG = {"blo.writefile"};
 enum eWriteWrapType {
   WW_WRAP_NONE = 1,
   WW_WRAP_ZSTD,
+  WW_WRAP_DELTA,
 };
 
+struct DeltaWrite;
+
 struct ZstdFrame {
   ZstdFrame *next, *prev;
 
@@ -169,6 +177,11 @@ struct WriteWrap {
 
   /* Buffer output (we only want when output isn't already buffered). */
   bool use_buf;
+  /**
+   * Flush the buffer at the end of every ID (as for undo), so IDs that did not change produce the
+   * same chunks in every save.
+   */
+  bool use_id_chunks;
 
   /* internal */
   int file_handle;
@@ -185,6 +198,8 @@ struct WriteWrap {
 
     bool write_error;
   } zstd;
+
+  DeltaWrite *delta;
 };
 
 /* none */
@@ -370,6 +385,200 @@ static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
   return buf_len;
 }
 
+/* delta, see #blend_delta.hh */
+
+/** Number of delta saves after which the next save writes the full file again. */
+#define BLEND_DELTA_SAVES_MAX 16
+
+struct DeltaDigest {
+  uint8_t md5[16];
+
+  friend bool operator==(const DeltaDigest &a, const DeltaDigest &b)
+  {
+    return memcmp(a.md5, b.md5, sizeof(a.md5)) == 0;
+  }
+};
+
+struct DeltaDigestHash {
+  size_t operator()(const DeltaDigest &digest) const
+  {
+    size_t hash;
+    memcpy(&hash, digest.md5, sizeof(hash));
+    return hash;
+  }
+};
+
+/**
+ * Chunks stored in the file written by the last delta enabled save. Kept for the whole session,
+ * a file that was changed since (different size or modification time) is written in full again.
+ */
+struct DeltaState {
+  std::string filepath;
+  int64_t file_size = 0;
+  int64_t file_mtime = 0;
+  /** Size of the file stream of the last save. */
+  uint64_t stream_size = 0;
+  uint32_t saves_num = 0;
+  /** Where each chunk is stored by its content, also chunks only used by earlier saves. */
+  std::unordered_map<DeltaDigest, BlendDeltaSpan, DeltaDigestHash> chunks;
+};
+
+static std::unique_ptr<DeltaState> delta_state;
+
+struct DeltaWrite {
+  std::unique_ptr<DeltaState> state;
+  /** Append to the existing file, otherwise write the full file. */
+  bool append;
+  uint64_t file_end;
+  /** File size before appending, restored on failure. */
+  uint64_t file_end_orig;
+  blender::Vector<BlendDeltaSpan> spans;
+  bool write_error;
+};
+
+static bool delta_state_matches_file(const DeltaState &state, const char *filepath)
+{
+  BLI_stat_t st;
+  if (state.filepath != filepath || BLI_stat(filepath, &st) == -1) {
+    return false;
+  }
+  return int64_t(st.st_size) == state.file_size && int64_t(st.st_mtime) == state.file_mtime;
+}
+
+/** True when the next save of \a filepath can append to the file instead of rewriting it. */
+static bool delta_can_append(const char *filepath)
+{
+  if (!delta_state || !delta_state_matches_file(*delta_state, filepath)) {
+    return false;
+  }
+  /* Compact when unused data takes up more than half of the file. */
+  return delta_state->saves_num < BLEND_DELTA_SAVES_MAX &&
+         uint64_t(delta_state->file_size) <= delta_state->stream_size * 2;
+}
+
+static bool ww_open_delta(WriteWrap *ww, const char *filepath)
+{
+  DeltaWrite *delta = ww->delta;
+  if (!delta->append) {
+    return ww_open_none(ww, filepath);
+  }
+
+  const int file = BLI_open(filepath, O_BINARY | O_WRONLY, 0);
+  if (file == -1) {
+    return false;
+  }
+  const int64_t file_end = BLI_lseek(file, 0, SEEK_END);
+  if (file_end != delta->state->file_size) {
+    close(file);
+    return false;
+  }
+  ww->file_handle = file;
+  delta->file_end = uint64_t(file_end);
+  delta->file_end_orig = uint64_t(file_end);
+  return true;
+}
+
+static size_t ww_write_delta(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+  DeltaWrite *delta = ww->delta;
+  if (delta->write_error) {
+    return 0;
+  }
+
+  DeltaDigest digest;
+  BLI_hash_md5_buffer(buf, buf_len, digest.md5);
+
+  BlendDeltaSpan span;
+  auto stored = delta->state->chunks.find(digest);
+  if (delta->append && stored != delta->state->chunks.end() && stored->second.size == buf_len) {
+    span = stored->second;
+  }
+  else {
+    /* A full save writes every chunk, it has to be a regular `.blend` file. */
+    if (ww_write_none(ww, buf, buf_len) != buf_len) {
+      delta->write_error = true;
+      return 0;
+    }
+    span = {delta->file_end, buf_len};
+    delta->file_end += buf_len;
+    delta->state->chunks.emplace(digest, span);
+  }
+
+  blo_delta_span_append(delta->spans, span);
+  delta->state->stream_size += buf_len;
+  return buf_len;
+}
+
+static bool delta_index_write(WriteWrap *ww)
+{
+  DeltaWrite *delta = ww->delta;
+  if (!blo_delta_index_write(ww->file_handle,
+                             delta->file_end,
+                             delta->spans,
+                             delta->state->stream_size,
+                             delta->state->saves_num))
+  {
+    return false;
+  }
+  delta->file_end += uint64_t(delta->spans.as_span().size_in_bytes()) + sizeof(BlendDeltaTrailer);
+  return true;
+}
+
+static bool ww_close_delta(WriteWrap *ww)
+{
+  DeltaWrite *delta = ww->delta;
+  if (delta->append) {
+    if (!delta->write_error && !delta_index_write(ww)) {
+      delta->write_error = true;
+    }
+    if (delta->write_error) {
+      /* Drop the partial delta, the index of the previous save ends the file again. */
+#ifdef WIN32
+      _chsize_s(ww->file_handle, int64_t(delta->file_end_orig));
+#else
+      UNUSED_VARS(ftruncate(ww->file_handle, int64_t(delta->file_end_orig)));
+#endif
+    }
+  }
+  return ww_close_none(ww) && !delta->write_error;
+}
+
+/**
+ * Start a save with #WW_WRAP_DELTA, \a ww has to be initialized already.
+ * \return true when the save appends to the existing file at \a filepath.
+ */
+static bool delta_write_begin(WriteWrap *ww, const char *filepath)
+{
+  DeltaWrite *delta = MEM_new<DeltaWrite>(__func__);
+  delta->append = delta_can_append(filepath);
+  if (delta->append) {
+    delta->state = std::move(delta_state);
+    delta->state->stream_size = 0;
+    delta->state->saves_num++;
+  }
+  else {
+    delta->state = std::make_unique<DeltaState>();
+  }
+  ww->delta = delta;
+  return delta->append;
+}
+
+/** Keep the chunks of a successful save for the next one. */
+static void delta_write_end(WriteWrap *ww, const char *filepath, const bool success)
+{
+  DeltaWrite *delta = ww->delta;
+  BLI_stat_t st;
+  delta_state.reset();
+  if (success && BLI_stat(filepath, &st) != -1) {
+    delta->state->filepath = filepath;
+    delta->state->file_size = int64_t(st.st_size);
+    delta->state->file_mtime = int64_t(st.st_mtime);
+    delta_state = std::move(delta->state);
+  }
+  MEM_delete(delta);
+  ww->delta = nullptr;
+}
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -384,6 +593,14 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
       r_ww->use_buf = true;
       break;
     }
+    case WW_WRAP_DELTA: {
+      r_ww->open = ww_open_delta;
+      r_ww->close = ww_close_delta;
+      r_ww->write = ww_write_delta;
+      r_ww->use_buf = true;
+      r_ww->use_id_chunks = true;
+      break;
+    }
     default: {
       r_ww->open = ww_open_none;
       r_ww->close = ww_close_none;
@@ -449,7 +666,7 @@ static WriteData *writedata_new(WriteWrap *ww)
   wd->ww = ww;
 
   if ((ww == nullptr) || (ww->use_buf)) {
-    if (ww == nullptr) {
+    if ((ww == nullptr) || (ww->use_id_chunks)) {
       wd->buffer.max_size = MEM_BUFFER_SIZE;
       wd->buffer.chunk_size = MEM_CHUNK_SIZE;
     }
@@ -645,9 +862,9 @@ static void mywrite_id_begin(WriteData *wd, ID *id)
 }
 
 /**
- * Start writing of data related to a single ID.
+ * End writing of data related to a single ID.
  *
- * Only does something when storing an undo step.
+ * Only does something when storing an undo step or for delta saves.
  */
 static void mywrite_id_end(WriteData *wd, ID * /*id*/)
 {
@@ -657,6 +874,9 @@ static void mywrite_id_end(WriteData *wd, ID * /*id*/)
     mywrite_flush(wd);
     wd->mem.current_id_session_uuid = MAIN_ID_SESSION_UUID_UNSET;
   }
+  else if (wd->ww->use_id_chunks) {
+    mywrite_flush(wd);
+  }
 }
 
 /** \} */
@@ -1487,6 +1707,10 @@ bool BLO_write_file(Main *mainvar,
   const bool use_userdef = params->use_userdef;
   const BlendThumbnail *thumb = params->thumb;
   const bool relbase_valid = (mainvar->filepath[0] != '\0');
+  /* Delta saves write uncompressed data only, copies are always written in full. */
+  const bool use_delta = params->use_delta && !use_save_as_copy &&
+                         (write_flags & G_FILE_COMPRESS) == 0;
+  bool use_delta_append = false;
 
   /* path backup/restore */
   void *path_list_backup = nullptr;
@@ -1498,11 +1722,27 @@ bool BLO_write_file(Main *mainvar,
   /* open temporary file, so we preserve the original in case we crash */
   SNPRINTF(tempname, "%s@", filepath);
 
-  ww_handle_init((write_flags & G_FILE_COMPRESS) ? WW_WRAP_ZSTD : WW_WRAP_NONE, &ww);
+  if (use_delta) {
+    ww_handle_init(WW_WRAP_DELTA, &ww);
+    use_delta_append = delta_write_begin(&ww, filepath);
+  }
+  else {
+    ww_handle_init((write_flags & G_FILE_COMPRESS) ? WW_WRAP_ZSTD : WW_WRAP_NONE, &ww);
+  }
 
-  if (ww.open(&ww, tempname) == false) {
-    BKE_reportf(
-        reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
+  /* A delta is appended to the file in place, on failure it is truncated again. When the append
+   * is interrupted altogether, reading falls back to the last complete save (see #blend_delta.hh).
+   */
+  const char *filepath_write = use_delta_append ? filepath : tempname;
+  if (ww.open(&ww, filepath_write) == false) {
+    BKE_reportf(reports,
+                RPT_ERROR,
+                "Cannot open file %s for writing: %s",
+                filepath_write,
+                strerror(errno));
+    if (use_delta) {
+      delta_write_end(&ww, filepath, false);
+    }
     return false;
   }
 
@@ -1602,25 +1842,47 @@ bool BLO_write_file(Main *mainvar,
 
   if (err) {
     BKE_report(reports, RPT_ERROR, strerror(errno));
-    remove(tempname);
+    if (use_delta) {
+      delta_write_end(&ww, filepath, false);
+    }
+    if (!use_delta_append) {
+      remove(tempname);
+    }
 
     return false;
   }
 
+  if (use_delta_append) {
+    /* Written in place, there is no previous file to keep as version backup. */
+    delta_write_end(&ww, filepath, true);
+    write_file_main_validate_post(mainvar, reports);
+    return true;
+  }
+
   /* file save to temporary file was successful */
   /* now do reverse file history (move .blend1 -> .blend2, .blend -> .blend1) */
   if (use_save_versions) {
     if (!do_history(filepath, reports)) {
       BKE_report(reports, RPT_ERROR, "Version backup failed (file saved with @)");
+      if (use_delta) {
+        delta_write_end(&ww, filepath, false);
+      }
       return false;
     }
   }
 
   if (BLI_rename_overwrite(tempname, filepath) != 0) {
     BKE_report(reports, RPT_ERROR, "Cannot change old file (file saved with @)");
+    if (use_delta) {
+      delta_write_end(&ww, filepath, false);
+    }
     return false;
   }
 
+  if (use_delta) {
+    delta_write_end(&ww, filepath, true);
+  }
+
   write_file_main_validate_post(mainvar, reports);
 
   return true;
@@ -0,0 +1,236 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <string>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "BLI_fileops.h"
+#include "BLI_filereader.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+#include "BLI_vector.hh"
+
+#include "BKE_report.h"
+
+#include "../intern/blend_delta.hh"
+
+#include BLI_SYSTEM_PID_H
+
+namespace blender::blenloader::tests {
+
+/** Writes files the way delta saves do, keeping the expected file stream of the last save. */
+class BlendDeltaTest : public testing::Test {
+ public:
+  std::string filepath;
+  /** The bytes a full save would have written for the last save. */
+  Vector<char> stream;
+  /** Where the stream of the last save is stored in the file. */
+  Vector<BlendDeltaSpan> stream_spans;
+  uint32_t saves_num = 0;
+  ReportList reports;
+
+  void SetUp() override
+  {
+    char temp_dir[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+    char path[FILE_MAX];
+    const std::string filename = "blend_delta_test_" + std::to_string(getpid()) + ".blend";
+    BLI_path_join(path, sizeof(path), temp_dir, filename.c_str());
+    filepath = path;
+    BKE_reports_init(&reports, RPT_STORE);
+  }
+
+  void TearDown() override
+  {
+    BLI_delete(filepath.c_str(), false, false);
+    BKE_reports_clear(&reports);
+  }
+
+  /** Stream of a regular file with \a chunks blocks, ending with the end of file block. */
+  static Vector<char> stream_create(const int chunks, const char fill)
+  {
+    Vector<char> data;
+    data.extend(Span<char>("BLENDER-v400", 12));
+    for (int i = 0; i < chunks; i++) {
+      data.append_n_times(char(fill + i), 1000 + i);
+    }
+    char endb[24] = {'E', 'N', 'D', 'B'};
+    data.extend(Span<char>(endb, sizeof(endb)));
+    return data;
+  }
+
+  void save_full(const Span<char> new_stream)
+  {
+    const int file = BLI_open(filepath.c_str(), O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    ASSERT_NE(file, -1);
+    EXPECT_EQ(write(file, new_stream.data(), size_t(new_stream.size())), new_stream.size());
+    close(file);
+    stream = new_stream;
+    stream_spans = {{0, uint64_t(new_stream.size())}};
+    saves_num = 0;
+  }
+
+  /** Add the spans of the last save storing \a size bytes starting at \a start of the stream. */
+  void spans_append_unchanged(Vector<BlendDeltaSpan> &spans,
+                              const int64_t start,
+                              const int64_t size)
+  {
+    int64_t stream_offset = 0;
+    for (const BlendDeltaSpan &span : stream_spans) {
+      const int64_t begin = std::max(start, stream_offset);
+      const int64_t end = std::min(start + size, stream_offset + int64_t(span.size));
+      if (begin < end) {
+        blo_delta_span_append(
+            spans, {span.offset + uint64_t(begin - stream_offset), uint64_t(end - begin)});
+      }
+      stream_offset += int64_t(span.size);
+    }
+  }
+
+  /**
+   * Append a delta save changing \a changed bytes starting at \a offset of the stream, the other
+   * bytes are referenced from the file. With \a torn, the save is interrupted before the index is
+   * complete.
+   */
+  void save_delta(const int64_t offset, const Span<char> changed, const bool torn = false)
+  {
+    const int file = BLI_open(filepath.c_str(), O_BINARY | O_WRONLY, 0);
+    ASSERT_NE(file, -1);
+    const uint64_t file_end = uint64_t(lseek(file, 0, SEEK_END));
+
+    /* Only the changed bytes are appended, the rest is referenced from earlier saves. */
+    Vector<BlendDeltaSpan> spans;
+    spans_append_unchanged(spans, 0, offset);
+    EXPECT_EQ(write(file, changed.data(), size_t(changed.size())), changed.size());
+    blo_delta_span_append(spans, {file_end, uint64_t(changed.size())});
+    const int64_t tail = offset + changed.size();
+    spans_append_unchanged(spans, tail, stream.size() - tail);
+
+    if (torn) {
+      /* Part of the index, but no trailer. */
+      EXPECT_EQ(write(file, spans.data(), sizeof(BlendDeltaSpan)),
+                int64_t(sizeof(BlendDeltaSpan)));
+    }
+    else {
+      saves_num++;
+      EXPECT_TRUE(blo_delta_index_write(
+          file, file_end + uint64_t(changed.size()), spans, uint64_t(stream.size()), saves_num));
+      stream.as_mutable_span().slice(offset, changed.size()).copy_from(changed);
+      stream_spans = spans;
+    }
+    close(file);
+  }
+
+  /** Read the whole file stream through the delta reader. */
+  Vector<char> read_stream()
+  {
+    const int file_handle = BLI_open(filepath.c_str(), O_BINARY | O_RDONLY, 0);
+    EXPECT_NE(file_handle, -1);
+    FileReader *file = blo_delta_filereader_ensure(
+        BLI_filereader_new_file(file_handle), filepath.c_str(), &reports);
+    Vector<char> data;
+    char buffer[700];
+    int64_t read;
+    while ((read = file->read(file, buffer, sizeof(buffer))) > 0) {
+      data.extend(Span<char>(buffer, read));
+    }
+    file->close(file);
+    return data;
+  }
+
+  int reports_num() const
+  {
+    return BLI_listbase_count(&reports.list);
+  }
+};
+
+TEST_F(BlendDeltaTest, RegularFile)
+{
+  save_full(stream_create(4, 'a'));
+  EXPECT_EQ(read_stream(), stream);
+  EXPECT_EQ(reports_num(), 0);
+}
+
+TEST_F(BlendDeltaTest, RoundTrip)
+{
+  save_full(stream_create(8, 'a'));
+
+  const Vector<char> changed_1(500, 'x');
+  save_delta(100, changed_1);
+  EXPECT_EQ(read_stream(), stream);
+
+  const Vector<char> changed_2(3000, 'y');
+  save_delta(2000, changed_2);
+  EXPECT_EQ(read_stream(), stream);
+
+  /* Overlapping with both previous changes, reading uses the bytes of the last save only. */
+  const Vector<char> changed_3(4000, 'z');
+  save_delta(50, changed_3);
+  const Vector<char> result = read_stream();
+  EXPECT_EQ(result, stream);
+  EXPECT_EQ(result[50], 'z');
+  EXPECT_EQ(reports_num(), 0);
+
+  /* Seeking reads the same bytes. */
+  const int file_handle = BLI_open(filepath.c_str(), O_BINARY | O_RDONLY, 0);
+  FileReader *file = blo_delta_filereader_ensure(
+      BLI_filereader_new_file(file_handle), filepath.c_str(), &reports);
+  char buffer[16];
+  EXPECT_EQ(file->seek(file, 4040, SEEK_SET), 4040);
+  EXPECT_EQ(file->read(file, buffer, sizeof(buffer)), int64_t(sizeof(buffer)));
+  EXPECT_EQ(Span<char>(buffer, sizeof(buffer)), stream.as_span().slice(4040, sizeof(buffer)));
+  file->close(file);
+}
+
+TEST_F(BlendDeltaTest, TornDelta)
+{
+  save_full(stream_create(8, 'a'));
+  save_delta(100, Vector<char>(500, 'x'));
+  save_delta(2000, Vector<char>(3000, 'y'));
+  const Vector<char> last_complete = stream;
+
+  /* An interrupted save is reported, the last complete one is read. */
+  save_delta(0, Vector<char>(200, 'z'), true);
+  EXPECT_EQ(read_stream(), last_complete);
+  EXPECT_EQ(reports_num(), 1);
+}
+
+TEST_F(BlendDeltaTest, TornLargeDelta)
+{
+  save_full(stream_create(8, 'a'));
+  save_delta(100, Vector<char>(500, 'x'));
+  const Vector<char> last_complete = stream;
+
+  /* The last complete save is found behind more data than is searched at once. */
+  save_delta(0, Vector<char>(3 << 20, 'z'), true);
+  EXPECT_EQ(read_stream(), last_complete);
+  EXPECT_EQ(reports_num(), 1);
+}
+
+TEST_F(BlendDeltaTest, TornFirstDelta)
+{
+  save_full(stream_create(8, 'a'));
+  const Vector<char> full = stream;
+
+  /* Without a complete delta the full save is read, still the interrupted save is reported. */
+  save_delta(100, Vector<char>(500, 'x'), true);
+  const Vector<char> result = read_stream();
+  /* Reading the full save stops at its end block, the incomplete data behind it is not used. */
+  ASSERT_GE(result.size(), full.size());
+  EXPECT_EQ(result.as_span().take_front(full.size()), full.as_span());
+  EXPECT_EQ(reports_num(), 1);
+}
+
+}  // namespace blender::blenloader::tests
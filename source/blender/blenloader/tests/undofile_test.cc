@@ -0,0 +1,88 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+
+#include "BKE_lib_id.h"
+
+#include "BLO_undofile.hh"
+
+namespace blender::blenloader::tests {
+
+/* Large enough to be shared by content. */
+static constexpr int64_t chunk_size = 8192;
+
+static void memfile_write(MemFile *memfile, MemFile *reference, const Span<Span<char>> chunks)
+{
+  MemFileWriteData mem_data{};
+  BLO_memfile_write_init(&mem_data, memfile, reference);
+  mem_data.current_id_session_uuid = MAIN_ID_SESSION_UUID_UNSET;
+  for (const Span<char> chunk : chunks) {
+    BLO_memfile_chunk_add(&mem_data, chunk.data(), size_t(chunk.size()));
+  }
+  BLO_memfile_write_finalize(&mem_data);
+}
+
+TEST(undofile, MergeDuplicateChunks)
+{
+  Array<char> zeros(chunk_size, 0);
+  Array<char> data(chunk_size);
+  for (const int64_t i : data.index_range()) {
+    data[i] = char(i * 7);
+  }
+
+  /* Two identical large chunks in one step are stored once. */
+  MemFile first{};
+  memfile_write(&first, nullptr, {zeros, data, zeros});
+  EXPECT_EQ(first.size, size_t(chunk_size * 2));
+
+  MemFile second{};
+  memfile_write(&second, &first, {zeros, data, zeros});
+  EXPECT_EQ(second.size, 0);
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &second.chunks) {
+    EXPECT_TRUE(chunk->is_identical);
+  }
+
+  /* Every chunk of the second step has to take over the ownership of the first step. */
+  BLO_memfile_merge(&first, &second);
+  EXPECT_TRUE(BLI_listbase_is_empty(&first.chunks));
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &second.chunks) {
+    EXPECT_FALSE(chunk->is_identical);
+  }
+  BLO_memfile_free(&second);
+
+  /* All users are released, so the data is not shared with anything anymore. */
+  MemFile third{};
+  memfile_write(&third, nullptr, {zeros, data});
+  EXPECT_EQ(third.size, size_t(chunk_size * 2));
+  BLO_memfile_free(&third);
+}
+
+TEST(undofile, MergeKeepsBuffersOfLaterSteps)
+{
+  Array<char> zeros(chunk_size, 0);
+
+  MemFile first{};
+  memfile_write(&first, nullptr, {zeros, zeros});
+
+  /* The second step only uses one of the buffer users of the first. */
+  MemFile second{};
+  memfile_write(&second, &first, {zeros});
+  EXPECT_EQ(second.size, 0);
+
+  BLO_memfile_merge(&first, &second);
+  const MemFileChunk *chunk = static_cast<const MemFileChunk *>(second.chunks.first);
+  EXPECT_FALSE(chunk->is_identical);
+  /* The buffer is still valid after the first step is freed. */
+  EXPECT_EQ(memcmp(chunk->buf, zeros.data(), chunk_size), 0);
+
+  BLO_memfile_free(&second);
+}
+
+}  // namespace blender::blenloader::tests
@@ -55,6 +55,9 @@ enum {
   /* A shrinkwrap modifier or constraint targeting this mesh needs information
    * about non-manifold boundary edges for the Target Normal Project mode. */
   DAG_EVAL_NEED_SHRINKWRAP_BOUNDARY = (1 << 1),
+  /* The final geometry of this object is used by another ID (modifiers, constraints, instancing,
+   * ...), so the modifiers can not be deferred while the object is hidden. */
+  DAG_EVAL_NEED_FINAL_GEOMETRY = (1 << 2),
 };
 
 /* ************************************************ */
@@ -177,6 +180,19 @@ void DEG_evaluate_on_framechange(Depsgraph *graph, float frame);
  */
 void DEG_evaluate_on_refresh(Depsgraph *graph);
 
+/**
+ * Evaluate the modifiers which were deferred for hidden objects, so that all objects have their
+ * final geometry. Used by exporters working on the active dependency graph, and by the Python API
+ * when scripts access evaluated objects.
+ */
+void DEG_evaluate_deferred_geometry(Depsgraph *graph);
+
+/**
+ * Tag objects with deferred modifiers which can't defer them anymore (for example after changing
+ * the preference), without resetting their simulation caches like a user edit would.
+ */
+void DEG_tag_deferred_geometry(Main *bmain);
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -219,6 +235,12 @@ void DEG_make_inactive(Depsgraph *depsgraph);
  * whether the object is hidden or the modifier is disabled. */
 void DEG_disable_visibility_optimization(Depsgraph *depsgraph);
 
+/**
+ * Whether hidden objects can skip the modifiers after their simulation modifiers. Only the active
+ * viewport dependency graph defers them, so that render and export graphs are always complete.
+ */
+bool DEG_use_deferred_geometry(const Depsgraph *depsgraph);
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -12,6 +12,7 @@
 
 #include "DEG_depsgraph.hh"
 
+struct ColliderStateCache;
 struct Collection;
 struct DepsNodeHandle;
 struct Depsgraph;
@@ -35,6 +36,9 @@ ListBase *DEG_get_effector_relations(const Depsgraph *depsgraph, Collection *col
 ListBase *DEG_get_collision_relations(const Depsgraph *depsgraph,
                                       Collection *collection,
                                       unsigned int modifier_type);
+/* Get the persistent state of the colliders in any of the collision relations. Created along with
+ * the relations, the state itself is updated during evaluation. */
+ColliderStateCache *DEG_get_collider_state_cache(const Depsgraph *depsgraph);
 
 /* Build collision/effector relations for depsgraph. */
 using DEG_CollobjFilterFunction = bool (*)(Object *obj, ModifierData *md);
@@ -175,6 +175,27 @@ const char *DepsgraphBuilder::get_rna_path_relative_to_scene_camera(const Scene
 /** \name Builder Finalizer.
  * \{ */
 
+/* Whether the geometry of the object is read by operations of another ID. */
+static bool deg_object_geometry_has_external_users(const IDNode *id_node)
+{
+  const ComponentNode *geometry_node = id_node->find_component(NodeType::GEOMETRY);
+  if (geometry_node == nullptr) {
+    return false;
+  }
+  for (const OperationNode *op_node : geometry_node->operations) {
+    for (const Relation *rel : op_node->outlinks) {
+      if (rel->to->type != NodeType::OPERATION) {
+        continue;
+      }
+      const OperationNode *op_to = static_cast<const OperationNode *>(rel->to);
+      if (op_to->owner->owner != id_node) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
 {
   deg_graph_flush_visibility_flags(graph);
@@ -185,6 +206,9 @@ void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
   for (IDNode *id_node : graph->id_nodes) {
     ID *id_orig = id_node->id_orig;
     id_node->finalize_build(graph);
+    if (id_node->id_type == ID_OB && deg_object_geometry_has_external_users(id_node)) {
+      id_node->eval_flags |= DAG_EVAL_NEED_FINAL_GEOMETRY;
+    }
     int flag = 0;
     /* Tag rebuild if special evaluation flags changed. */
     if (id_node->eval_flags != id_node->previous_eval_flags) {
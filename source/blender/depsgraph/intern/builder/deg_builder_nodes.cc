@@ -57,6 +57,7 @@
 #include "BKE_armature.h"
 #include "BKE_bake_geometry_nodes_modifier.hh"
 #include "BKE_cachefile.h"
+#include "BKE_cloth.hh"
 #include "BKE_collection.h"
 #include "BKE_constraint.h"
 #include "BKE_curve.h"
@@ -108,6 +109,7 @@
 #include "intern/builder/deg_builder_key.h"
 #include "intern/builder/deg_builder_rna.h"
 #include "intern/depsgraph.hh"
+#include "intern/depsgraph_physics.hh"
 #include "intern/depsgraph_light_linking.hh"
 #include "intern/depsgraph_tag.hh"
 #include "intern/depsgraph_type.hh"
@@ -1505,6 +1507,28 @@ void DepsgraphNodeBuilder::build_rigidbody(Scene *scene)
   }
 }
 
+/* Physics Groups - Scene Level */
+void DepsgraphNodeBuilder::build_physics_groups(Scene *scene)
+{
+  calculate_physics_groups(graph_);
+
+  Scene *scene_cow = get_cow_datablock(scene);
+  for (const int group_index : graph_->physics_groups.index_range()) {
+    Vector<Object *> objects_cow;
+    for (Object *object : graph_->physics_groups[group_index]) {
+      objects_cow.append(get_cow_datablock(object));
+    }
+    add_operation_node(&scene->id,
+                       NodeType::TRANSFORM,
+                       OperationCode::PHYSICS_GROUP_STEP,
+                       [scene_cow, objects_cow](::Depsgraph *depsgraph) {
+                         cloth_group_step(depsgraph, scene_cow, objects_cow);
+                       },
+                       "",
+                       group_index);
+  }
+}
+
 void DepsgraphNodeBuilder::build_particle_systems(Object *object, bool is_object_visible)
 {
   /**
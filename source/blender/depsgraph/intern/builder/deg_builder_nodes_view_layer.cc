@@ -167,6 +167,10 @@ void DepsgraphNodeBuilder::build_view_layer(Scene *scene,
     ViewLayer *set_view_layer = BKE_view_layer_default_render(scene->set);
     build_view_layer(scene->set, set_view_layer, DEG_ID_LINKED_VIA_SET);
   }
+  /* Cloth objects colliding with each other, including the objects of set scenes. */
+  if (linked_state == DEG_ID_LINKED_DIRECTLY) {
+    build_physics_groups(scene);
+  }
 }
 
 }  // namespace blender::deg
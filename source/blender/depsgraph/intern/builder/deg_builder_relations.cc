@@ -918,9 +918,11 @@ void DepsgraphRelationBuilder::build_object_modifiers(Object *object)
   ctx.object = object;
 
   OperationKey previous_key = eval_init_key;
+  bool has_simulation_modifier = false;
   LISTBASE_FOREACH (ModifierData *, modifier, &object->modifiers) {
     const OperationKey modifier_key(
         &object->id, NodeType::GEOMETRY, OperationCode::MODIFIER, modifier->name);
+    has_simulation_modifier |= BKE_modifier_is_simulation(modifier);
 
     /* Relation for the modifier stack chain. */
     add_relation(previous_key, modifier_key, "Modifier");
@@ -944,6 +946,17 @@ void DepsgraphRelationBuilder::build_object_modifiers(Object *object)
   }
   add_relation(previous_key, eval_key, "modifier stack order");
 
+  /* Hidden objects can skip the modifiers after their simulation modifiers, which is decided from
+   * the evaluated base flags. Changed flags alone do not need the geometry to be evaluated again,
+   * the skipped modifiers are caught up on after evaluation. */
+  if (has_simulation_modifier) {
+    const ComponentKey object_from_layer_key(&object->id, NodeType::OBJECT_FROM_LAYER);
+    add_relation(object_from_layer_key,
+                 eval_key,
+                 "Object from Layer -> geometry eval",
+                 RELATION_FLAG_NO_FLUSH | RELATION_NO_VISIBILITY_CHANGE);
+  }
+
   /* Build IDs referenced by the modifiers. */
   BuilderWalkUserData data;
   data.builder = this;
@@ -2237,6 +2250,72 @@ void DepsgraphRelationBuilder::build_rigidbody(Scene *scene)
   }
 }
 
+void DepsgraphRelationBuilder::build_physics_groups(Scene *scene)
+{
+  /* The group step replaces the collision relations between the objects of the group, which
+   * would form dependency cycles. It uses the input mesh and transform of each object, and the
+   * modifier stack of each object uses the result of the step. */
+  for (const int group_index : graph_->physics_groups.index_range()) {
+    Span<Object *> objects = graph_->physics_groups[group_index];
+    OperationKey group_key(
+        &scene->id, NodeType::TRANSFORM, OperationCode::PHYSICS_GROUP_STEP, "", group_index);
+
+    TimeSourceKey time_src_key;
+    add_relation(time_src_key, group_key, "TimeSrc -> Physics Group");
+
+    for (Object *object : objects) {
+      ComponentKey transform_key(&object->id, NodeType::TRANSFORM);
+      add_relation(transform_key, group_key, "Physics Group Transform");
+      ComponentKey obdata_key((ID *)object->data, NodeType::GEOMETRY);
+      add_relation(obdata_key, group_key, "Physics Group Input Geometry");
+      /* Point cache reset frees the simulation data. */
+      ComponentKey point_cache_key(&object->id, NodeType::POINT_CACHE);
+      add_relation(point_cache_key, group_key, "Point Cache -> Physics Group");
+      OperationKey geometry_key(&object->id, NodeType::GEOMETRY, OperationCode::GEOMETRY_EVAL);
+      add_relation(group_key, geometry_key, "Physics Group -> Geometry");
+
+      /* Manual changes to the other objects of the group invalidate the simulation. */
+      for (Object *other : objects) {
+        if (other != object) {
+          ComponentKey other_transform_key(&other->id, NodeType::TRANSFORM);
+          add_relation(other_transform_key,
+                       point_cache_key,
+                       "Physics Group -> Point Cache",
+                       RELATION_FLAG_FLUSH_USER_EDIT_ONLY);
+        }
+      }
+
+      /* Colliders outside of the group and effectors are used during the step. */
+      const ClothModifierData *clmd = reinterpret_cast<const ClothModifierData *>(
+          object->modifiers.first);
+      ListBase *relations = build_collision_relations(
+          graph_, clmd->coll_parms->group, eModifierType_Collision);
+      LISTBASE_FOREACH (CollisionRelation *, relation, relations) {
+        if (physics_group_index(graph_, relation->ob) != group_index) {
+          ComponentKey trf_key(&relation->ob->id, NodeType::TRANSFORM);
+          add_relation(trf_key, group_key, "Physics Group Collision");
+          ComponentKey coll_key(&relation->ob->id, NodeType::GEOMETRY);
+          add_relation(coll_key, group_key, "Physics Group Collision");
+        }
+      }
+      relations = build_effector_relations(graph_, clmd->sim_parms->effector_weights->group);
+      LISTBASE_FOREACH (EffectorRelation *, relation, relations) {
+        ComponentKey eff_key(&relation->ob->id, NodeType::TRANSFORM);
+        add_relation(eff_key, group_key, "Physics Group Field");
+        /* Geometry of the objects of the group is only known after the step. */
+        if (physics_group_index(graph_, relation->ob) != group_index &&
+            (relation->psys ||
+             ELEM(relation->pd->shape, PFIELD_SHAPE_SURFACE, PFIELD_SHAPE_POINTS) ||
+             relation->pd->forcefield == PFIELD_GUIDE))
+        {
+          ComponentKey mod_key(&relation->ob->id, NodeType::GEOMETRY);
+          add_relation(mod_key, group_key, "Physics Group Field");
+        }
+      }
+    }
+  }
+}
+
 void DepsgraphRelationBuilder::build_particle_systems(Object *object)
 {
   OperationKey obdata_ubereval_key(&object->id, NodeType::GEOMETRY, OperationCode::GEOMETRY_EVAL);
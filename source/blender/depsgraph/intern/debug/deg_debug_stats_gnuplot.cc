@@ -36,6 +36,8 @@ struct DebugContext {
 struct StatsEntry {
   const IDNode *id_node;
   double time;
+  /* Part of #time spent on the copy-on-write update. */
+  double cow_time;
 };
 
 /* TODO(sergey): De-duplicate with graphviz relation debugger. */
@@ -92,6 +94,7 @@ void write_stats_data(const DebugContext &ctx)
     StatsEntry entry;
     entry.id_node = id_node;
     entry.time = time;
+    entry.cow_time = id_node->stats.cow_time;
     stats.append(entry);
   }
   /* Sort the data. */
@@ -103,10 +106,11 @@ void write_stats_data(const DebugContext &ctx)
   deg_debug_fprintf(ctx, "$data << EOD" NL);
   for (const StatsEntry &entry : stats) {
     deg_debug_fprintf(ctx,
-                      "\"[%s] %s\",%f" NL,
+                      "\"[%s] %s\",%f,%f" NL,
                       gnuplotify_id_code(entry.id_node->id_orig->name).c_str(),
                       gnuplotify_name(entry.id_node->id_orig->name + 2).c_str(),
-                      entry.time);
+                      entry.time,
+                      entry.cow_time);
   }
   deg_debug_fprintf(ctx, "EOD" NL);
 }
@@ -129,7 +133,9 @@ void deg_debug_stats_gnuplot(const DebugContext &ctx)
   deg_debug_fprintf(ctx,
                     "plot \"$data\" using "
                     "($2*0.5):0:($2*0.5):(0.2):yticlabels(1) "
-                    "with boxxyerrorbars t '' lt rgb \"#406090\"" NL);
+                    "with boxxyerrorbars t 'Evaluation' lt rgb \"#406090\", "
+                    "\"$data\" using ($3*0.5):0:($3*0.5):(0.2) "
+                    "with boxxyerrorbars t 'Copy-on-write' lt rgb \"#c07030\"" NL);
 }
 
 }  // namespace
@@ -60,9 +60,11 @@ Depsgraph::Depsgraph(Main *bmain, Scene *scene, ViewLayer *view_layer, eEvaluati
       scene_cow(nullptr),
       is_active(false),
       use_visibility_optimization(true),
+      use_deferred_geometry(true),
       is_evaluating(false),
       is_render_pipeline_depsgraph(false),
-      use_editors_update(false)
+      use_editors_update(false),
+      collider_state_cache(nullptr)
 {
   BLI_spin_init(&lock);
   memset(id_type_updated, 0, sizeof(id_type_updated));
@@ -344,3 +346,10 @@ void DEG_disable_visibility_optimization(Depsgraph *depsgraph)
   deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(depsgraph);
   deg_graph->use_visibility_optimization = false;
 }
+
+bool DEG_use_deferred_geometry(const Depsgraph *depsgraph)
+{
+  const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(depsgraph);
+  return deg_graph->is_active && deg_graph->mode == DAG_EVAL_VIEWPORT &&
+         deg_graph->use_visibility_optimization && deg_graph->use_deferred_geometry;
+}
@@ -29,7 +29,9 @@
 #include "intern/depsgraph_light_linking.hh"
 #include "intern/depsgraph_type.hh"
 
+struct ColliderStateCache;
 struct ID;
+struct Object;
 struct Scene;
 struct ViewLayer;
 
@@ -152,6 +154,10 @@ struct Depsgraph {
   /* Optimize out evaluation of operations which affect hidden objects or disabled modifiers. */
   bool use_visibility_optimization;
 
+  /* Allow hidden objects to skip the modifiers after their simulation modifiers, is disabled while
+   * the deferred modifiers are evaluated on request. */
+  bool use_deferred_geometry;
+
   DepsgraphDebug debug;
 
   bool is_evaluating;
@@ -169,6 +175,17 @@ struct Depsgraph {
    * created along with relations, for fast lookup during evaluation. */
   Map<const ID *, ListBase *> *physics_relations[DEG_PHYSICS_RELATIONS_NUM];
 
+  /* Persistent state of the colliders in any of the collision relations above, one per collider
+   * object. Kept across frames. */
+  ColliderStateCache *collider_state_cache;
+
+  /* Cloth objects which collide with each other, stepped together by one operation per group
+   * instead of depending on each other's geometry. Original objects, see
+   * #calculate_physics_groups. */
+  Vector<Vector<Object *>> physics_groups;
+  /* Index in #physics_groups of every grouped object. */
+  Map<const Object *, int> physics_group_index;
+
   light_linking::Cache light_linking_cache;
 
   MEM_CXX_CLASS_ALLOC_FUNCS("Depsgraph");
@@ -23,12 +23,14 @@
 
 #include "intern/eval/deg_eval.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_visibility.h"
 
 #include "intern/node/deg_node.hh"
 #include "intern/node/deg_node_operation.hh"
 #include "intern/node/deg_node_time.hh"
 
 #include "intern/depsgraph.hh"
+#include "intern/depsgraph_registry.hh"
 #include "intern/depsgraph_tag.hh"
 
 namespace deg = blender::deg;
@@ -43,6 +45,12 @@ static void deg_flush_updates_and_refresh(deg::Depsgraph *deg_graph)
   deg::graph_tag_ids_for_visible_update(deg_graph);
   deg::deg_graph_flush_updates(deg_graph);
   deg::deg_evaluate_on_refresh(deg_graph);
+
+  /* Catch up on the modifiers skipped for objects which became visible. */
+  if (deg::deg_graph_tag_deferred_geometry(deg_graph)) {
+    deg::deg_graph_flush_updates(deg_graph);
+    deg::deg_evaluate_on_refresh(deg_graph);
+  }
 }
 
 void DEG_evaluate_on_refresh(Depsgraph *graph)
@@ -79,3 +87,21 @@ void DEG_evaluate_on_framechange(Depsgraph *graph, float frame)
   deg_graph->ctime = BKE_scene_frame_to_ctime(scene, frame);
   deg_flush_updates_and_refresh(deg_graph);
 }
+
+void DEG_evaluate_deferred_geometry(Depsgraph *graph)
+{
+  deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(graph);
+  deg_graph->use_deferred_geometry = false;
+  if (deg::deg_graph_tag_deferred_geometry(deg_graph)) {
+    deg::deg_graph_flush_updates(deg_graph);
+    deg::deg_evaluate_on_refresh(deg_graph);
+  }
+  deg_graph->use_deferred_geometry = true;
+}
+
+void DEG_tag_deferred_geometry(Main *bmain)
+{
+  for (deg::Depsgraph *deg_graph : deg::get_all_registered_graphs(bmain)) {
+    deg::deg_graph_tag_deferred_geometry(deg_graph);
+  }
+}
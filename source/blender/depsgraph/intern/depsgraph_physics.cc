@@ -12,14 +12,20 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_compiler_compat.h"
+#include "BLI_disjoint_set.hh"
 #include "BLI_listbase.h"
+#include "BLI_set.hh"
 
+#include "BKE_cloth.hh"
 #include "BKE_collision.h"
 #include "BKE_effect.h"
 #include "BKE_modifier.h"
 
+#include "DNA_cloth_types.h"
 #include "DNA_collection_types.h"
+#include "DNA_modifier_types.h"
 #include "DNA_object_force_types.h"
 #include "DNA_object_types.h"
 
@@ -28,6 +34,7 @@
 #include "DEG_depsgraph_query.hh"
 
 #include "depsgraph.hh"
+#include "intern/node/deg_node_id.hh"
 
 namespace deg = blender::deg;
 
@@ -87,6 +94,12 @@ ListBase *DEG_get_collision_relations(const Depsgraph *graph,
   return hash->lookup_default(collection_orig, nullptr);
 }
 
+ColliderStateCache *DEG_get_collider_state_cache(const Depsgraph *graph)
+{
+  const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(graph);
+  return deg_graph->collider_state_cache;
+}
+
 /********************** Depsgraph Building API ************************/
 
 void DEG_add_collision_relations(DepsNodeHandle *handle,
@@ -99,11 +112,18 @@ void DEG_add_collision_relations(DepsNodeHandle *handle,
   Depsgraph *depsgraph = DEG_get_graph_from_handle(handle);
   deg::Depsgraph *deg_graph = (deg::Depsgraph *)depsgraph;
   ListBase *relations = build_collision_relations(deg_graph, collection, modifier_type);
+  const int group_index = deg::physics_group_index(deg_graph, object);
   LISTBASE_FOREACH (CollisionRelation *, relation, relations) {
     Object *ob1 = relation->ob;
     if (ob1 == object) {
       continue;
     }
+    if (group_index != -1 && modifier_type == eModifierType_Collision &&
+        deg::physics_group_index(deg_graph, ob1) == group_index)
+    {
+      /* Collisions within the group are handled by the group step. */
+      continue;
+    }
     if (filter_function == nullptr ||
         filter_function(ob1, BKE_modifiers_findby_type(ob1, (ModifierType)modifier_type)))
     {
@@ -194,10 +214,17 @@ ListBase *build_collision_relations(Depsgraph *graph, Collection *collection, ui
    * view layer.
    */
   ID *collection_id = object_id_safe(collection);
-  return hash->lookup_or_add_cb(collection_id, [&]() {
+  ListBase *relations = hash->lookup_or_add_cb(collection_id, [&]() {
     ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(graph);
     return BKE_collision_relations_create(depsgraph, collection, modifier_type);
   });
+  if (type == DEG_PHYSICS_COLLISION) {
+    if (graph->collider_state_cache == nullptr) {
+      graph->collider_state_cache = BKE_collider_state_cache_create();
+    }
+    BKE_collider_state_cache_add(graph->collider_state_cache, relations);
+  }
+  return relations;
 }
 
 void clear_physics_relations(Depsgraph *graph)
@@ -227,6 +254,75 @@ void clear_physics_relations(Depsgraph *graph)
       graph->physics_relations[i] = nullptr;
     }
   }
+
+  if (graph->collider_state_cache) {
+    BKE_collider_state_cache_free(graph->collider_state_cache);
+    graph->collider_state_cache = nullptr;
+  }
+
+  graph->physics_groups.clear();
+  graph->physics_group_index.clear();
+}
+
+void calculate_physics_groups(Depsgraph *graph)
+{
+  BLI_assert(graph->physics_groups.is_empty());
+
+  Vector<Object *> candidates;
+  for (IDNode *id_node : graph->id_nodes) {
+    if (GS(id_node->id_orig->name) != ID_OB) {
+      continue;
+    }
+    Object *object = reinterpret_cast<Object *>(id_node->id_orig);
+    if (cloth_group_object_supported(object)) {
+      candidates.append(object);
+    }
+  }
+  if (candidates.size() < 2) {
+    return;
+  }
+
+  /* Colliders of every candidate. */
+  Array<Set<const Object *>> colliders(candidates.size());
+  for (const int64_t i : candidates.index_range()) {
+    const ClothModifierData *clmd = reinterpret_cast<const ClothModifierData *>(
+        candidates[i]->modifiers.first);
+    ListBase *relations = build_collision_relations(
+        graph, clmd->coll_parms->group, eModifierType_Collision);
+    LISTBASE_FOREACH (CollisionRelation *, relation, relations) {
+      colliders[i].add(relation->ob);
+    }
+  }
+
+  /* Objects colliding with each other, directly or through other objects, form a group. */
+  DisjointSet<int64_t> sets(candidates.size());
+  for (const int64_t i : candidates.index_range()) {
+    for (const int64_t j : candidates.index_range().drop_front(i + 1)) {
+      if (colliders[i].contains(candidates[j]) && colliders[j].contains(candidates[i])) {
+        sets.join(i, j);
+      }
+    }
+  }
+
+  Map<int64_t, Vector<Object *>> groups;
+  for (const int64_t i : candidates.index_range()) {
+    groups.lookup_or_add_default(sets.find_root(i)).append(candidates[i]);
+  }
+  for (Vector<Object *> &objects : groups.values()) {
+    if (objects.size() < 2) {
+      continue;
+    }
+    const int group_index = int(graph->physics_groups.size());
+    for (const Object *object : objects) {
+      graph->physics_group_index.add(object, group_index);
+    }
+    graph->physics_groups.append(std::move(objects));
+  }
+}
+
+int physics_group_index(const Depsgraph *graph, const Object *object)
+{
+  return graph->physics_group_index.lookup_default(object, -1);
 }
 
 }  // namespace blender::deg
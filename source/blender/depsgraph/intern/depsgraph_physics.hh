@@ -10,6 +10,7 @@
 
 struct Collection;
 struct ListBase;
+struct Object;
 
 namespace blender::deg {
 
@@ -21,4 +22,10 @@ ListBase *build_collision_relations(Depsgraph *graph,
                                     unsigned int modifier_type);
 void clear_physics_relations(Depsgraph *graph);
 
+/* Find the cloth objects of the graph which collide with each other, see
+ * #Depsgraph::physics_groups. */
+void calculate_physics_groups(Depsgraph *graph);
+/* Group index of the object, -1 if it is not part of a physics group. */
+int physics_group_index(const Depsgraph *graph, const Object *object);
+
 }  // namespace blender::deg
@@ -10,6 +10,9 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+#include <mutex>
+
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
@@ -17,6 +20,7 @@
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.h"
 
@@ -53,6 +57,7 @@ namespace {
 struct DepsgraphEvalState;
 
 void deg_task_run_func(TaskPool *pool, void *taskdata);
+void deg_task_run_prioritized_func(TaskPool *pool, void *taskdata);
 
 void schedule_children(DepsgraphEvalState *state,
                        OperationNode *node,
@@ -78,22 +83,44 @@ enum class EvaluationStage {
   SINGLE_THREADED_WORKAROUND,
 };
 
+/* Operations which are ready to be evaluated, ordered by their critical path time. */
+struct ReadyOperationsQueue {
+  std::mutex mutex;
+  /* Max-heap on #OperationNode.critical_path_time. */
+  Vector<OperationNode *> heap;
+};
+
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
   EvaluationStage stage;
   bool need_update_pending_parents = true;
   bool need_single_thread_pass = false;
+  /* Time operations and keep their average cost, for scheduling by critical path. Only used when
+   * enough operations are to be evaluated, see #COST_MODEL_OPERATIONS_MIN. */
+  bool use_cost_model = false;
+  /* Evaluate operations holding up the longest chain of work first, see
+   * #calculate_critical_path_times. */
+  bool use_critical_path = false;
+  ReadyOperationsQueue ready_queue;
 };
 
+/* Critical path scheduling only pays off for its locking when there are expensive chains of
+ * operations, light graphs are scheduled in the order operations become ready. */
+#define CRITICAL_PATH_TIME_MIN 0.001
+
+/* Updates of a few operations (e.g. moving a single object) can't gain from scheduling, these
+ * don't pay for timing every operation and traversing the graph for its critical paths. */
+#define COST_MODEL_OPERATIONS_MIN 64
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
-  if (state->do_stats) {
+  /* Perform operation. The timing is also the cost estimate for scheduling. */
+  if (state->do_stats || state->use_cost_model) {
     const double start_time = PIL_check_seconds_timer();
     operation_node->evaluate(depsgraph);
     operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
@@ -124,6 +151,45 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   });
 }
 
+bool critical_path_time_less(const OperationNode *a, const OperationNode *b)
+{
+  return a->critical_path_time < b->critical_path_time;
+}
+
+void ready_queue_push(DepsgraphEvalState *state, TaskPool *pool, OperationNode *node)
+{
+  ReadyOperationsQueue &queue = state->ready_queue;
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.heap.append(node);
+    std::push_heap(queue.heap.begin(), queue.heap.end(), critical_path_time_less);
+  }
+  /* Every task evaluates whichever ready operation is the most critical once it runs. */
+  BLI_task_pool_push(pool, deg_task_run_prioritized_func, nullptr, false, nullptr);
+}
+
+OperationNode *ready_queue_pop(DepsgraphEvalState *state)
+{
+  ReadyOperationsQueue &queue = state->ready_queue;
+  std::lock_guard lock(queue.mutex);
+  BLI_assert(!queue.heap.is_empty());
+  std::pop_heap(queue.heap.begin(), queue.heap.end(), critical_path_time_less);
+  return queue.heap.pop_last();
+}
+
+void deg_task_run_prioritized_func(TaskPool *pool, void * /*taskdata*/)
+{
+  void *userdata_v = BLI_task_pool_user_data(pool);
+  DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
+
+  OperationNode *operation_node = ready_queue_pop(state);
+  evaluate_node(state, operation_node);
+
+  schedule_children(state, operation_node, [&](OperationNode *node) {
+    ready_queue_push(state, pool, node);
+  });
+}
+
 bool check_operation_node_visible(const DepsgraphEvalState *state, OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
@@ -187,14 +253,76 @@ void calculate_pending_parents_if_needed(DepsgraphEvalState *state)
   state->need_update_pending_parents = false;
 }
 
+bool need_evaluate_operation(const DepsgraphEvalState *state, OperationNode *node)
+{
+  return (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) && check_operation_node_visible(state, node);
+}
+
+/* Calculate the critical path time of every operation which is to be evaluated: its own average
+ * evaluation time plus the longest critical path time of the operations depending on it.
+ *
+ * The graph is traversed depth first with an explicit stack, chains of operations can be too long
+ * for recursion. Cyclic relations are ignored, same as for the pending parents. */
+void calculate_critical_path_times(DepsgraphEvalState *state)
+{
+  enum { NODE_VISITING = 1, NODE_DONE = 2 };
+
+  for (OperationNode *node : state->graph->operations) {
+    node->custom_flags = 0;
+    node->critical_path_time = 0.0;
+  }
+
+  double max_critical_path_time = 0.0;
+  /* Operation and index of its next outgoing relation to visit. */
+  Vector<std::pair<OperationNode *, int64_t>> stack;
+  for (OperationNode *root : state->graph->operations) {
+    if (root->custom_flags != 0 || !need_evaluate_operation(state, root)) {
+      continue;
+    }
+    root->custom_flags = NODE_VISITING;
+    stack.append({root, 0});
+    while (!stack.is_empty()) {
+      OperationNode *node = stack.last().first;
+      const int64_t rel_index = stack.last().second++;
+      if (rel_index < node->outlinks.size()) {
+        const Relation *rel = node->outlinks[rel_index];
+        OperationNode *child = (OperationNode *)rel->to;
+        if ((rel->flag & RELATION_FLAG_CYCLIC) == 0 && child->custom_flags == 0 &&
+            need_evaluate_operation(state, child))
+        {
+          child->custom_flags = NODE_VISITING;
+          stack.append({child, 0});
+        }
+        continue;
+      }
+      double children_time = 0.0;
+      for (const Relation *rel : node->outlinks) {
+        const OperationNode *child = (const OperationNode *)rel->to;
+        if ((rel->flag & RELATION_FLAG_CYCLIC) == 0 && child->custom_flags == NODE_DONE) {
+          children_time = std::max(children_time, child->critical_path_time);
+        }
+      }
+      node->critical_path_time = node->stats.average_time + children_time;
+      max_critical_path_time = std::max(max_critical_path_time, node->critical_path_time);
+      node->custom_flags = NODE_DONE;
+      stack.remove_last();
+    }
+  }
+
+  state->use_critical_path = max_critical_path_time >= CRITICAL_PATH_TIME_MIN;
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   /* Clear tags and other things which needs to be clear. */
-  if (state->do_stats) {
-    for (OperationNode *node : graph->operations) {
-      node->stats.reset_current();
+  int64_t pending_operations_num = 0;
+  for (OperationNode *node : graph->operations) {
+    node->stats.reset_current();
+    if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+      pending_operations_num++;
     }
   }
+  state->use_cost_model = pending_operations_num >= COST_MODEL_OPERATIONS_MIN;
 }
 
 bool is_metaball_object_operation(const OperationNode *operation_node)
@@ -318,9 +446,21 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
-  schedule_graph(state, [&](OperationNode *node) {
-    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
-  });
+  state->use_critical_path = false;
+  if (state->use_cost_model && stage == EvaluationStage::THREADED_EVALUATION &&
+      (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0)
+  {
+    calculate_critical_path_times(state);
+  }
+
+  if (state->use_critical_path) {
+    schedule_graph(state, [&](OperationNode *node) { ready_queue_push(state, task_pool, node); });
+  }
+  else {
+    schedule_graph(state, [&](OperationNode *node) {
+      BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
+    });
+  }
   BLI_task_pool_work_and_wait(task_pool);
 }
 
@@ -454,6 +594,10 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
    * synchronization. */
   if (state.do_stats) {
     deg_eval_stats_aggregate(graph);
+    deg_eval_stats_print_copy_on_write(graph);
+  }
+  if (state.use_cost_model) {
+    deg_eval_stats_update_average(graph);
   }
 
   /* Clear any uncleared tags. */
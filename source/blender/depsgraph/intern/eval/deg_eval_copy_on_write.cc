@@ -490,6 +490,10 @@ inline bool check_datablock_expanded(const ID *id_cow)
 struct RemapCallbackUserData {
   /* Dependency graph for which remapping is happening. */
   const Depsgraph *depsgraph;
+  /* Last remapped pair of IDs. The same ID is often referenced many times in a row (for example
+   * materials of a mesh), this avoids looking it up in the graph every time. */
+  const ID *last_id_orig = nullptr;
+  ID *last_id_cow = nullptr;
 };
 
 int foreach_libblock_remap_callback(LibraryIDLinkCallbackData *cb_data)
@@ -502,9 +506,15 @@ int foreach_libblock_remap_callback(LibraryIDLinkCallbackData *cb_data)
   RemapCallbackUserData *user_data = (RemapCallbackUserData *)cb_data->user_data;
   const Depsgraph *depsgraph = user_data->depsgraph;
   ID *id_orig = *id_p;
+  if (id_orig == user_data->last_id_orig) {
+    *id_p = user_data->last_id_cow;
+    return IDWALK_RET_NOP;
+  }
   if (deg_copy_on_write_is_needed(id_orig)) {
     ID *id_cow = depsgraph->get_cow_id(id_orig);
     BLI_assert(id_cow != nullptr);
+    user_data->last_id_orig = id_orig;
+    user_data->last_id_cow = id_cow;
     DEG_COW_PRINT(
         "    Remapping datablock for %s: id_orig=%p id_cow=%p\n", id_orig->name, id_orig, id_cow);
     *id_p = id_cow;
@@ -833,7 +843,7 @@ ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph, const IDNode
    * is not to be remapped again. */
   deg_tag_copy_on_write_id(id_cow, id_orig);
   /* Perform remapping of the nodes. */
-  RemapCallbackUserData user_data = {nullptr};
+  RemapCallbackUserData user_data;
   user_data.depsgraph = depsgraph;
   BKE_library_foreach_ID_link(nullptr,
                               id_cow,
@@ -8,7 +8,13 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <algorithm>
+#include <cstdio>
+
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+#include "DNA_ID.h"
 
 #include "intern/depsgraph.hh"
 
@@ -36,6 +42,54 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
     IDNode *id_node = comp_node->owner;
     id_node->stats.current_time += op_node->stats.current_time;
     comp_node->stats.current_time += op_node->stats.current_time;
+    if (comp_node->type == NodeType::COPY_ON_WRITE) {
+      id_node->stats.cow_time += op_node->stats.current_time;
+    }
+  }
+}
+
+void deg_eval_stats_print_copy_on_write(const Depsgraph *graph)
+{
+  /* Only print the slowest IDs, a big scene easily has thousands of them. */
+  const int64_t max_ids_num = 8;
+
+  Vector<const IDNode *> id_nodes;
+  double cow_time = 0.0;
+  for (const IDNode *id_node : graph->id_nodes) {
+    if (id_node->stats.cow_time == 0.0) {
+      continue;
+    }
+    id_nodes.append(id_node);
+    cow_time += id_node->stats.cow_time;
+  }
+  if (id_nodes.is_empty()) {
+    return;
+  }
+  std::sort(id_nodes.begin(), id_nodes.end(), [](const IDNode *a, const IDNode *b) {
+    return a->stats.cow_time > b->stats.cow_time;
+  });
+
+  printf("Depsgraph copy-on-write of %d IDs in %f seconds.\n", int(id_nodes.size()), cow_time);
+  for (const IDNode *id_node : id_nodes.as_span().take_front(max_ids_num)) {
+    printf("  %s: %f seconds\n", id_node->id_orig->name, id_node->stats.cow_time);
+  }
+}
+
+void deg_eval_stats_update_average(Depsgraph *graph)
+{
+  /* Weight of the latest evaluation, high enough to follow changes in the scene (e.g. a
+   * simulation that gets to collide) within a few frames. */
+  const double factor = 0.25;
+  for (OperationNode *op_node : graph->operations) {
+    const double time = op_node->stats.current_time;
+    if (time == 0.0) {
+      /* Not evaluated. */
+      continue;
+    }
+    Node::Stats &stats = op_node->stats;
+    stats.average_time = (stats.average_time == 0.0) ?
+                             time :
+                             stats.average_time + (time - stats.average_time) * factor;
   }
 }
 
@@ -15,4 +15,11 @@ struct Depsgraph;
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Print time spent on copy-on-write updates, for the IDs which took the longest to update.
+ * Requires aggregated stats. */
+void deg_eval_stats_print_copy_on_write(const Depsgraph *graph);
+
+/* Update the moving average evaluation time of operations evaluated by the last evaluation. */
+void deg_eval_stats_update_average(Depsgraph *graph);
+
 }  // namespace blender::deg
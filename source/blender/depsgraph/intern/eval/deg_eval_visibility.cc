@@ -16,10 +16,14 @@
 #include "BLI_listbase.h"
 #include "BLI_stack.h"
 
+#include "BKE_object.hh"
+
 #include "DEG_depsgraph.hh"
 
 #include "intern/depsgraph.hh"
 #include "intern/depsgraph_relation.hh"
+#include "intern/depsgraph_tag.hh"
+#include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/node/deg_node.hh"
 #include "intern/node/deg_node_component.hh"
 #include "intern/node/deg_node_id.hh"
@@ -233,4 +237,25 @@ void deg_graph_flush_visibility_flags_if_needed(Depsgraph *graph)
   deg_graph_flush_visibility_flags(graph);
 }
 
+bool deg_graph_tag_deferred_geometry(Depsgraph *graph)
+{
+  ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(graph);
+  bool need_update = false;
+  for (IDNode *id_node : graph->id_nodes) {
+    if (id_node->id_type != ID_OB || !deg_copy_on_write_is_expanded(id_node->id_cow)) {
+      continue;
+    }
+    const Object *object = reinterpret_cast<const Object *>(id_node->id_cow);
+    if (!object->runtime.is_geometry_deferred ||
+        BKE_object_eval_can_defer_modifiers(depsgraph, object))
+    {
+      continue;
+    }
+    graph_id_tag_update(
+        graph->bmain, graph, id_node->id_orig, ID_RECALC_GEOMETRY, DEG_UPDATE_SOURCE_VISIBILITY);
+    need_update = true;
+  }
+  return need_update;
+}
+
 }  // namespace blender::deg
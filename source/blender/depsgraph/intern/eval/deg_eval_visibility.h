@@ -27,4 +27,9 @@ void deg_evaluate_object_modifiers_mode_node_visibility(::Depsgraph *depsgraph,
 void deg_graph_flush_visibility_flags(Depsgraph *graph);
 void deg_graph_flush_visibility_flags_if_needed(Depsgraph *graph);
 
+/* Tag geometry of objects which skipped modifiers while hidden, and which can not do so anymore
+ * (they became visible, or their final geometry is requested). Returns true if anything got
+ * tagged, in which case the graph is to be flushed and evaluated again. */
+bool deg_graph_tag_deferred_geometry(Depsgraph *graph);
+
 }  // namespace blender::deg
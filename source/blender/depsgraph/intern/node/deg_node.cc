@@ -270,11 +270,14 @@ Node::Stats::Stats()
 void Node::Stats::reset()
 {
   current_time = 0.0;
+  average_time = 0.0;
+  cow_time = 0.0;
 }
 
 void Node::Stats::reset_current()
 {
   current_time = 0.0;
+  cow_time = 0.0;
 }
 
 /*******************************************************************************
@@ -164,6 +164,12 @@ struct Node {
     void reset_current();
     /* Time spent on this node during current graph evaluation. */
     double current_time;
+    /* Exponential moving average of #current_time over the evaluations this node was part of,
+     * used as cost estimate when scheduling operations. */
+    double average_time;
+    /* Part of #current_time spent on the copy-on-write update of the ID.
+     * Only aggregated for ID nodes. */
+    double cow_time;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
@@ -85,6 +85,9 @@ const char *operationCodeAsString(OperationCode opcode)
       return "RIGIDBODY_SIM";
     case OperationCode::RIGIDBODY_TRANSFORM_COPY:
       return "RIGIDBODY_TRANSFORM_COPY";
+    /* Physics group. */
+    case OperationCode::PHYSICS_GROUP_STEP:
+      return "PHYSICS_GROUP_STEP";
     /* Geometry. */
     case OperationCode::GEOMETRY_EVAL_INIT:
       return "GEOMETRY_EVAL_INIT";
@@ -205,7 +208,7 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0) {}
+OperationNode::OperationNode() : critical_path_time(0.0), name_tag(-1), flag(0) {}
 
 string OperationNode::identifier() const
 {
@@ -83,6 +83,10 @@ enum class OperationCode {
   /* Copy results to object */
   RIGIDBODY_TRANSFORM_COPY,
 
+  /* Physics group. ------------------------------------------------------- */
+  /* Step cloth objects colliding with each other together. */
+  PHYSICS_GROUP_STEP,
+
   /* Geometry. ------------------------------------------------------------ */
 
   /* Initialize evaluation of the geometry. Is an entry operation of geometry
@@ -275,6 +279,10 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Estimated time of the longest chain of operations which are to be evaluated after this one,
+   * including this one. Operations holding up the most work are evaluated first. */
+  double critical_path_time;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
@@ -615,7 +615,7 @@ static ListBase *cloth_brush_collider_cache_create(Object *object, Depsgraph *de
     ColliderCache *col = MEM_cnew<ColliderCache>(__func__);
     col->ob = ob;
     col->collmd = cmd;
-    collision_move_object(cmd, 1.0, 0.0, true);
+    BKE_collider_move(depsgraph, ob, cmd, 1.0, 0.0, true);
     BLI_addtail(cache, col);
   }
   DEG_OBJECT_ITER_END;
@@ -13,6 +13,7 @@
 
 #include "BKE_context.h"
 #include "BLI_memory_utils.hh"
+#include "DEG_depsgraph.hh"
 #include "IO_ply.hh"
 
 #include "ply_data.hh"
@@ -28,7 +29,10 @@ namespace blender::io::ply {
 void exporter_main(bContext *C, const PLYExportParams &export_params)
 {
   std::unique_ptr<blender::io::ply::PlyData> plyData = std::make_unique<PlyData>();
-  load_plydata(*plyData, CTX_data_ensure_evaluated_depsgraph(C), export_params);
+  Depsgraph *depsgraph = CTX_data_ensure_evaluated_depsgraph(C);
+  /* Hidden objects might have skipped the modifiers after their simulations. */
+  DEG_evaluate_deferred_geometry(depsgraph);
+  load_plydata(*plyData, depsgraph, export_params);
 
   std::unique_ptr<FileBuffer> buffer;
 
@@ -17,6 +17,7 @@
 #include "BLI_task.hh"
 #include "BLI_vector.hh"
 
+#include "DEG_depsgraph.hh"
 #include "DEG_depsgraph_query.hh"
 
 #include "DNA_scene_types.h"
@@ -280,6 +281,9 @@ void export_frame(Depsgraph *depsgraph, const OBJExportParams &export_params, co
 
   frame_writer->write_header();
 
+  /* Hidden objects might have skipped the modifiers after their simulations. */
+  DEG_evaluate_deferred_geometry(depsgraph);
+
   auto [exportable_as_mesh, exportable_as_nurbs] = filter_supported_objects(depsgraph,
                                                                             export_params);
 
@@ -160,6 +160,15 @@ typedef struct ClothSimSettings {
   float internal_compression;
   float max_internal_tension;
   float max_internal_compression;
+
+  /** Bounds of the adaptive time step, in steps per frame. */
+  short adaptive_steps_min;
+  short adaptive_steps_max;
+  /**
+   * Largest distance a vertex may travel in one adaptive step,
+   * as a fraction of the average spring length.
+   */
+  float adaptive_cfl;
   char _pad0[4];
 
 } ClothSimSettings;
@@ -191,6 +200,8 @@ typedef enum {
   CLOTH_SIMSETTINGS_FLAG_SEW = (1 << 14),
   /** Make simulation respect deformations in the base object. */
   CLOTH_SIMSETTINGS_FLAG_DYNAMIC_BASEMESH = (1 << 15),
+  /** Choose the time step in each step instead of using a fixed number of steps per frame. */
+  CLOTH_SIMSETTINGS_FLAG_ADAPTIVE_STEPS = (1 << 16),
 } CLOTH_SIMSETTINGS_FLAGS;
 
 /* ClothSimSettings.bending_model. */
@@ -153,6 +153,9 @@
     .internal_compression = 15.0f, \
     .max_internal_tension = 15.0f, \
     .max_internal_compression = 15.0f, \
+    .adaptive_steps_min = 2, \
+    .adaptive_steps_max = 40, \
+    .adaptive_cfl = 0.5f, \
   }
 
 #define _DNA_DEFAULT_ClothCollSettings \
@@ -887,7 +887,9 @@ typedef struct CollisionModifierData {
   float time_x, time_xnew;
   /** Collider doesn't move this frame, i.e. x[].co==xnew[].co. */
   char is_static;
-  char _pad[7];
+  char _pad[3];
+  /** Unique stamp of the last position update, used by the collider state cache. */
+  int update_count;
 
   /** Bounding volume hierarchy for this cloth object. */
   struct BVHTree *bvhtree;
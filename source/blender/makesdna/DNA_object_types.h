@@ -123,7 +123,13 @@ typedef struct Object_Runtime {
   /** Did last modifier stack generation need mapping support? */
   char last_need_mapping;
 
-  char _pad0[3];
+  /**
+   * The modifiers following the simulation modifiers were skipped, because the object was hidden
+   * (see #BKE_object_eval_can_defer_modifiers).
+   */
+  char is_geometry_deferred;
+
+  char _pad0[2];
 
   /** Only used for drawing the parent/child help-line. */
   float parent_display_origin[3];
@@ -37,6 +37,7 @@ enum {
 enum {
   BPHYS_EXTRA_FLUID_SPRINGS = 1,
   BPHYS_EXTRA_CLOTH_ACCELERATION = 2,
+  BPHYS_EXTRA_CLOTH_ADAPTIVE_STEPS = 3,
 };
 
 typedef struct PTCacheExtra {
@@ -88,7 +89,11 @@ typedef struct PointCache {
   int last_exact;
   /** Used for editing cache - what is the last baked frame. */
   int last_valid;
-  char _pad[4];
+  /**
+   * Quantization step for #PTCACHE_COMPRESS_ZSTD delta encoding of locations and velocities,
+   * zero for lossless.
+   */
+  float compression_tolerance;
 
   /* for external cache files */
   /** Number of cached points. */
@@ -144,13 +149,18 @@ enum {
   PTCACHE_IGNORE_CLEAR = 1 << 13,
 
   PTCACHE_FLAG_INFO_DIRTY = 1 << 14,
+  /** Store all frames of a disk cache in one file with a frame index. */
+  PTCACHE_DISK_CONTAINER = 1 << 15,
 
   PTCACHE_REDO_NEEDED = PTCACHE_OUTDATED | PTCACHE_FRAMES_SKIPPED,
-  PTCACHE_FLAGS_COPY = PTCACHE_DISK_CACHE | PTCACHE_EXTERNAL | PTCACHE_IGNORE_LIBPATH,
+  PTCACHE_FLAGS_COPY = PTCACHE_DISK_CACHE | PTCACHE_EXTERNAL | PTCACHE_IGNORE_LIBPATH |
+                       PTCACHE_DISK_CONTAINER,
 };
 
 enum {
   PTCACHE_COMPRESS_NO = 0,
   PTCACHE_COMPRESS_LZO = 1,
   PTCACHE_COMPRESS_LZMA = 2,
+  /** Zstd, locations and velocities are delta encoded against the previous key-frame. */
+  PTCACHE_COMPRESS_ZSTD = 3,
 };
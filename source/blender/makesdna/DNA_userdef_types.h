@@ -711,8 +711,10 @@ typedef struct UserDef_Experimental {
   char use_new_volume_nodes;
   char use_shader_node_previews;
   char use_extension_repos;
+  char use_blend_delta_save;
+  char use_deferred_hidden_modifiers;
 
-  char _pad[2];
+  char _pad[8];
   /** `makesdna` does not allow empty structs. */
 } UserDef_Experimental;
 
@@ -676,7 +676,14 @@ StructRNA *rna_PropertyGroup_refine(PointerRNA *ptr)
 
 static ID *rna_ID_evaluated_get(ID *id, Depsgraph *depsgraph)
 {
-  return DEG_get_evaluated_id(depsgraph, id);
+  ID *id_eval = DEG_get_evaluated_id(depsgraph, id);
+  if (GS(id_eval->name) == ID_OB &&
+      reinterpret_cast<Object *>(id_eval)->runtime.is_geometry_deferred)
+  {
+    /* Scripts expect the final geometry, also for hidden objects. */
+    rna_Depsgraph_deferred_geometry_ensure(depsgraph);
+  }
+  return id_eval;
 }
 
 static ID *rna_ID_copy(ID *id, Main *bmain)
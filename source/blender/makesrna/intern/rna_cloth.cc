@@ -548,6 +548,21 @@ static void rna_def_cloth_solver_result(BlenderRNA *brna)
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
   RNA_def_property_ui_text(prop, "Average Iterations", "Average iterations during substeps");
 
+  prop = RNA_def_property(srna, "collision_pairs", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "collision_pairs");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Collision Pairs",
+                           "Number of cloth and collider pairs checked during substeps");
+
+  prop = RNA_def_property(srna, "collision_pairs_culled", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "collision_pairs_culled");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Culled Collision Pairs",
+      "Number of cloth and collider pairs skipped by the bounding box test during substeps");
+
   RNA_define_verify_sdna(true);
 }
 
@@ -685,6 +700,42 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
       "Quality of the simulation in steps per frame (higher is better quality but slower)");
   RNA_def_property_update(prop, 0, "rna_cloth_update");
 
+  prop = RNA_def_property(srna, "use_adaptive_steps", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "flags", CLOTH_SIMSETTINGS_FLAG_ADAPTIVE_STEPS);
+  RNA_def_property_ui_text(prop,
+                           "Adaptive Steps",
+                           "Choose the size of each step from the vertex speeds, the solver "
+                           "convergence and the collision response, instead of using a fixed "
+                           "number of steps per frame");
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+
+  prop = RNA_def_property(srna, "adaptive_steps_min", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "adaptive_steps_min");
+  RNA_def_property_range(prop, 1, SHRT_MAX);
+  RNA_def_property_ui_range(prop, 1, 80, 1, -1);
+  RNA_def_property_ui_text(
+      prop, "Minimum Steps", "Minimum number of steps per frame of the adaptive time step");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+
+  prop = RNA_def_property(srna, "adaptive_steps_max", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "adaptive_steps_max");
+  RNA_def_property_range(prop, 1, SHRT_MAX);
+  RNA_def_property_ui_range(prop, 1, 200, 1, -1);
+  RNA_def_property_ui_text(
+      prop, "Maximum Steps", "Maximum number of steps per frame of the adaptive time step");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+
+  prop = RNA_def_property(srna, "adaptive_cfl", PROP_FLOAT, PROP_FACTOR);
+  RNA_def_property_float_sdna(prop, nullptr, "adaptive_cfl");
+  RNA_def_property_range(prop, 0.0f, 10.0f);
+  RNA_def_property_ui_range(prop, 0.0f, 2.0f, 1, 3);
+  RNA_def_property_ui_text(prop,
+                           "Travel Limit",
+                           "Largest distance a vertex may travel in one adaptive step, relative "
+                           "to the average edge length (zero to disable)");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+
   prop = RNA_def_property(srna, "time_scale", PROP_FLOAT, PROP_NONE);
   RNA_def_property_float_sdna(prop, nullptr, "time_scale");
   RNA_def_property_range(prop, 0.0f, FLT_MAX);
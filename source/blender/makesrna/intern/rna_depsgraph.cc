@@ -288,6 +288,33 @@ static void rna_Depsgraph_debug_stats(Depsgraph *depsgraph, char *result)
                outer);
 }
 
+void rna_Depsgraph_deferred_geometry_ensure(Depsgraph *depsgraph)
+{
+  if (DEG_is_evaluating(depsgraph)) {
+    return;
+  }
+
+#  ifdef WITH_PYTHON
+  /* Allow drivers to be evaluated */
+  BPy_BEGIN_ALLOW_THREADS;
+#  endif
+
+  DEG_evaluate_deferred_geometry(depsgraph);
+
+#  ifdef WITH_PYTHON
+  BPy_END_ALLOW_THREADS;
+#  endif
+}
+
+static void rna_Depsgraph_evaluate_deferred_geometry(Depsgraph *depsgraph, ReportList *reports)
+{
+  if (DEG_is_evaluating(depsgraph)) {
+    BKE_report(reports, RPT_ERROR, "Dependency graph update requested during evaluation");
+    return;
+  }
+  rna_Depsgraph_deferred_geometry_ensure(depsgraph);
+}
+
 static void rna_Depsgraph_update(Depsgraph *depsgraph, Main *bmain, ReportList *reports)
 {
   if (DEG_is_evaluating(depsgraph)) {
@@ -311,6 +338,8 @@ static void rna_Depsgraph_update(Depsgraph *depsgraph, Main *bmain, ReportList *
 
 static void rna_Depsgraph_objects_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
+  rna_Depsgraph_deferred_geometry_ensure((Depsgraph *)ptr->data);
+
   iter->internal.custom = MEM_callocN(sizeof(BLI_Iterator), __func__);
   DEGObjectIterData *data = static_cast<DEGObjectIterData *>(
       MEM_callocN(sizeof(DEGObjectIterData), __func__));
@@ -368,6 +397,8 @@ struct RNA_Depsgraph_Instances_Iterator {
 
 static void rna_Depsgraph_object_instances_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
+  rna_Depsgraph_deferred_geometry_ensure((Depsgraph *)ptr->data);
+
   RNA_Depsgraph_Instances_Iterator *di_it = static_cast<RNA_Depsgraph_Instances_Iterator *>(
       MEM_callocN(sizeof(*di_it), __func__));
   iter->internal.custom = di_it;
@@ -738,6 +769,16 @@ static void rna_def_depsgraph(BlenderRNA *brna)
       "This invalidates all references to evaluated data-blocks from this dependency graph.");
   RNA_def_function_flag(func, FUNC_USE_MAIN | FUNC_USE_REPORTS);
 
+  func = RNA_def_function(
+      srna, "evaluate_deferred_geometry", "rna_Depsgraph_evaluate_deferred_geometry");
+  RNA_def_function_ui_description(
+      func,
+      "Evaluate the modifiers which were skipped for hidden objects (see the Deferred Hidden "
+      "Modifiers preference), so all objects have their final geometry. This is done "
+      "automatically when iterating the objects of the dependency graph or getting evaluated "
+      "objects");
+  RNA_def_function_flag(func, FUNC_USE_REPORTS);
+
   /* Queries for original data-blocks (the ones depsgraph is built for). */
 
   prop = RNA_def_property(srna, "scene", PROP_POINTER, PROP_NONE);
@@ -22,6 +22,7 @@ extern "C" {
 
 #define RNA_MAGIC ((int)~0)
 
+struct Depsgraph;
 struct FreestyleSettings;
 struct ID;
 struct IDOverrideLibrary;
@@ -382,6 +383,11 @@ void rna_Object_internal_update_data(struct Main *bmain,
                                      struct Scene *scene,
                                      struct PointerRNA *ptr);
 void rna_Mesh_update_draw(struct Main *bmain, struct Scene *scene, struct PointerRNA *ptr);
+/**
+ * Evaluate the modifiers deferred for hidden objects (see #DEG_evaluate_deferred_geometry), so
+ * that evaluated geometry accessed from Python is complete.
+ */
+void rna_Depsgraph_deferred_geometry_ensure(struct Depsgraph *depsgraph);
 void rna_TextureSlot_update(struct bContext *C, struct PointerRNA *ptr);
 
 /* basic poll functions for object types */
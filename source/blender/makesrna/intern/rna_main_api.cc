@@ -333,6 +333,12 @@ static Mesh *rna_Main_meshes_new_from_object(Main *bmain,
       return nullptr;
   }
 
+  if (depsgraph != nullptr &&
+      DEG_get_evaluated_object(depsgraph, object)->runtime.is_geometry_deferred)
+  {
+    rna_Depsgraph_deferred_geometry_ensure(depsgraph);
+  }
+
   Mesh *mesh = BKE_mesh_new_from_object_to_bmain(
       bmain, depsgraph, object, preserve_all_data_layers);
 
@@ -408,6 +408,26 @@ static void rna_Object_crazyspace_eval_clear(Object *object)
   BKE_crazyspace_api_eval_clear(object);
 }
 
+/** Make sure the evaluated geometry of \a object includes the modifiers deferred while hidden. */
+static void rna_Object_deferred_geometry_ensure(Object *object,
+                                                Depsgraph *depsgraph,
+                                                ReportList *reports)
+{
+  if (depsgraph == nullptr) {
+    if (object->runtime.is_geometry_deferred) {
+      BKE_report(reports,
+                 RPT_WARNING,
+                 "Object is hidden and its modifiers are not evaluated, pass the dependency graph "
+                 "to get the final geometry");
+    }
+    return;
+  }
+  const Object *object_eval = DEG_get_evaluated_object(depsgraph, object);
+  if (object_eval->runtime.is_geometry_deferred) {
+    rna_Depsgraph_deferred_geometry_ensure(depsgraph);
+  }
+}
+
 /* copied from Mesh_getFromObject and adapted to RNA interface */
 static Mesh *rna_Object_to_mesh(Object *object,
                                 ReportList *reports,
@@ -428,6 +448,8 @@ static Mesh *rna_Object_to_mesh(Object *object,
       return nullptr;
   }
 
+  rna_Object_deferred_geometry_ensure(object, depsgraph, reports);
+
   return BKE_object_to_mesh(depsgraph, object, preserve_all_data_layers);
 }
 
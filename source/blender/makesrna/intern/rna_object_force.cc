@@ -246,6 +246,24 @@ static void rna_Cache_toggle_disk_cache(Main * /*bmain*/, Scene * /*scene*/, Poi
   }
 }
 
+static void rna_Cache_toggle_disk_container(Main * /*bmain*/, Scene * /*scene*/, PointerRNA *ptr)
+{
+  Object *ob = nullptr;
+  Scene *scene = nullptr;
+
+  if (!rna_Cache_get_valid_owner_ID(ptr, &ob, &scene)) {
+    return;
+  }
+
+  PointCache *cache = (PointCache *)ptr->data;
+
+  PTCacheID pid = BKE_ptcache_id_find(ob, scene, cache);
+
+  if (pid.cache) {
+    BKE_ptcache_toggle_disk_container(&pid);
+  }
+}
+
 bool rna_Cache_use_disk_cache_override_apply(Main * /*bmain*/,
                                              RNAPropertyOverrideApplyContext &rnaapply_ctx)
 {
@@ -958,6 +976,11 @@ static void rna_def_pointcache_common(StructRNA *srna)
       {PTCACHE_COMPRESS_NO, "NO", 0, "None", "No compression"},
       {PTCACHE_COMPRESS_LZO, "LIGHT", 0, "Lite", "Fast but not so effective compression"},
       {PTCACHE_COMPRESS_LZMA, "HEAVY", 0, "Heavy", "Effective but slow compression"},
+      {PTCACHE_COMPRESS_ZSTD,
+       "ZSTD",
+       0,
+       "Zstd Delta",
+       "Fast compression that stores locations and velocities relative to earlier frames"},
       {0, nullptr, 0, nullptr, nullptr},
   };
 
@@ -993,6 +1016,15 @@ static void rna_def_pointcache_common(StructRNA *srna)
   RNA_def_property_enum_items(prop, point_cache_compress_items);
   RNA_def_property_ui_text(prop, "Cache Compression", "Compression method to be used");
 
+  prop = RNA_def_property(srna, "compression_tolerance", PROP_FLOAT, PROP_DISTANCE);
+  RNA_def_property_float_sdna(prop, nullptr, "compression_tolerance");
+  RNA_def_property_range(prop, 0.0f, FLT_MAX);
+  RNA_def_property_ui_range(prop, 0.0f, 0.01f, 0.01, 5);
+  RNA_def_property_ui_text(prop,
+                           "Compression Tolerance",
+                           "Precision of stored locations and velocities for Zstd Delta "
+                           "compression, zero stores them exactly");
+
   /* flags */
   prop = RNA_def_property(srna, "is_baked", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, nullptr, "flag", PTCACHE_BAKED);
@@ -1012,6 +1044,14 @@ static void rna_def_pointcache_common(StructRNA *srna)
   RNA_def_property_override_funcs(
       prop, nullptr, nullptr, "rna_Cache_use_disk_cache_override_apply");
 
+  prop = RNA_def_property(srna, "use_disk_container", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "flag", PTCACHE_DISK_CONTAINER);
+  RNA_def_property_ui_text(prop,
+                           "Single File",
+                           "Store all frames of the disk cache in one indexed file instead of a "
+                           "file per frame");
+  RNA_def_property_update(prop, NC_OBJECT, "rna_Cache_toggle_disk_container");
+
   prop = RNA_def_property(srna, "is_outdated", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, nullptr, "flag", PTCACHE_OUTDATED);
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
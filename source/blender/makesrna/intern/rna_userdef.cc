@@ -688,6 +688,16 @@ static void rna_UserDef_subdivision_update(Main *bmain, Scene *scene, PointerRNA
   rna_userdef_update(bmain, scene, ptr);
 }
 
+/* Catch up on the modifiers skipped while hidden. Not tagged as user edit, which would reset the
+ * simulation caches. */
+static void rna_UserDef_deferred_hidden_modifiers_update(Main *bmain,
+                                                         Scene *scene,
+                                                         PointerRNA *ptr)
+{
+  DEG_tag_deferred_geometry(bmain);
+  rna_userdef_update(bmain, scene, ptr);
+}
+
 static void rna_UserDef_audio_update(Main *bmain, Scene * /*scene*/, PointerRNA * /*ptr*/)
 {
   BKE_sound_init(bmain);
@@ -7094,6 +7104,19 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
       "These paths are exposed as add-ons, package management is not yet integrated");
   RNA_def_property_boolean_funcs(
       prop, nullptr, "rna_PreferencesExperimental_use_extension_repos_set");
+
+  prop = RNA_def_property(srna, "use_blend_delta_save", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Delta Saves",
+                           "Only append data-blocks that changed to the file when saving it again, "
+                           "the file is written in full every few saves. Uncompressed files only");
+
+  prop = RNA_def_property(srna, "use_deferred_hidden_modifiers", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Deferred Hidden Modifiers",
+                           "Only evaluate the simulation modifiers of hidden objects, the "
+                           "modifiers after them are evaluated when the object becomes visible");
+  RNA_def_property_update(prop, 0, "rna_UserDef_deferred_hidden_modifiers_update");
 }
 
 static void rna_def_userdef_addon_collection(BlenderRNA *brna, PropertyRNA *cprop)
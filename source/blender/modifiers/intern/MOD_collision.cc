@@ -120,6 +120,9 @@ static void deform_verts(ModifierData *md,
 
     mvert_num = mesh->totvert;
 
+    /* Positions and BVH tree move on below, invalidate cached collider states. */
+    BKE_collision_update_tag(collmd);
+
     if (current_time < collmd->time_xnew) {
       free_data((ModifierData *)collmd);
     }
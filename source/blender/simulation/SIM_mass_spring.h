@@ -38,6 +38,27 @@ int SIM_cloth_solve(struct Depsgraph *depsgraph,
                     float frame,
                     struct ClothModifierData *clmd,
                     struct ListBase *effectors);
+
+/** A cloth object stepped by #SIM_cloth_solve_group. */
+typedef struct ClothGroupItem {
+  struct Object *ob;
+  struct ClothModifierData *clmd;
+  struct ListBase *effectors;
+  /** Return value of #SIM_cloth_solve for this object. */
+  int result;
+} ClothGroupItem;
+
+/**
+ * Step cloth objects which collide with each other to the same frame in lock-step: every step is
+ * solved for all objects first, then the collisions of each object are resolved against the other
+ * objects at the end of the same step (see #cloth_group_collider_update).
+ * Uses fixed steps, the finest of the objects. All objects have to simulate the same time span
+ * (#ClothSimSettings.timescale).
+ */
+void SIM_cloth_solve_group(struct Depsgraph *depsgraph,
+                           float frame,
+                           ClothGroupItem *items,
+                           int items_num);
 void SIM_cloth_solver_set_positions(struct ClothModifierData *clmd);
 void SIM_cloth_solver_set_volume(struct ClothModifierData *clmd);
 
@@ -6,6 +6,8 @@
  * \ingroup sim
  */
 
+#include <algorithm>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_cloth_types.h"
@@ -15,10 +17,14 @@
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_linklist.h"
 #include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_cloth.hh"
 #include "BKE_collision.h"
@@ -80,6 +86,47 @@ static bool cloth_get_pressure_weights(ClothModifierData *clmd,
   return true;
 }
 
+/* Number of elements summed serially in the pressure reductions. */
+#define CLOTH_PRESSURE_BLOCK_SIZE 1024
+
+/**
+ * Sum of `fn(i)` for all indices below `size`. Fixed size blocks are summed in parallel and
+ * their sums are then added in order, so that the result does not depend on threading.
+ */
+template<typename T, typename Function>
+static T cloth_deterministic_sum(const uint size, const T &identity, const Function &fn)
+{
+  const int64_t blocks_num = (int64_t(size) + CLOTH_PRESSURE_BLOCK_SIZE - 1) /
+                             CLOTH_PRESSURE_BLOCK_SIZE;
+  auto block_sum = [&](const int64_t block) {
+    const uint start = uint(block * CLOTH_PRESSURE_BLOCK_SIZE);
+    const uint end = std::min(start + CLOTH_PRESSURE_BLOCK_SIZE, size);
+    T sum = identity;
+    for (uint i = start; i < end; i++) {
+      sum += fn(i);
+    }
+    return sum;
+  };
+
+  if (blocks_num <= 1) {
+    return block_sum(0);
+  }
+
+  blender::Array<T> block_sums(blocks_num);
+  blender::threading::parallel_for(
+      blender::IndexRange(blocks_num), 1, [&](const blender::IndexRange range) {
+        for (const int64_t block : range) {
+          block_sums[block] = block_sum(block);
+        }
+      });
+
+  T sum = identity;
+  for (const T &block : block_sums) {
+    sum += block;
+  }
+  return sum;
+}
+
 static void cloth_calc_pressure_gradient(ClothModifierData *clmd,
                                          const float gradient_vector[3],
                                          float *r_vertex_pressure)
@@ -87,12 +134,17 @@ static void cloth_calc_pressure_gradient(ClothModifierData *clmd,
   Cloth *cloth = clmd->clothObject;
   Implicit_Data *data = cloth->implicit;
   uint mvert_num = cloth->mvert_num;
-  float pt[3];
 
-  for (uint i = 0; i < mvert_num; i++) {
-    SIM_mass_spring_get_position(data, i, pt);
-    r_vertex_pressure[i] = dot_v3v3(pt, gradient_vector);
-  }
+  blender::threading::parallel_for(
+      blender::IndexRange(mvert_num),
+      CLOTH_PRESSURE_BLOCK_SIZE,
+      [&](const blender::IndexRange range) {
+        float pt[3];
+        for (const int64_t i : range) {
+          SIM_mass_spring_get_position(data, int(i), pt);
+          r_vertex_pressure[i] = dot_v3v3(pt, gradient_vector);
+        }
+      });
 }
 
 static float cloth_calc_volume(ClothModifierData *clmd)
@@ -101,7 +153,6 @@ static float cloth_calc_volume(ClothModifierData *clmd)
   Cloth *cloth = clmd->clothObject;
   const MVertTri *tri = cloth->tri;
   Implicit_Data *data = cloth->implicit;
-  float weights[3] = {1.0f, 1.0f, 1.0f};
   float vol = 0;
 
   /* Early exit for hair, as it never has volume. */
@@ -109,13 +160,15 @@ static float cloth_calc_volume(ClothModifierData *clmd)
     return 0.0f;
   }
 
-  for (uint i = 0; i < cloth->primitive_num; i++) {
+  vol = cloth_deterministic_sum(cloth->primitive_num, 0.0f, [&](const uint i) {
     const MVertTri *vt = &tri[i];
+    float weights[3];
 
     if (cloth_get_pressure_weights(clmd, vt, weights)) {
-      vol += SIM_tri_tetra_volume_signed_6x(data, vt->tri[0], vt->tri[1], vt->tri[2]);
+      return SIM_tri_tetra_volume_signed_6x(data, vt->tri[0], vt->tri[1], vt->tri[2]);
     }
-  }
+    return 0.0f;
+  });
 
   /* We need to divide by 6 to get the actual volume. */
   vol = vol / 6.0f;
@@ -129,7 +182,6 @@ static float cloth_calc_rest_volume(ClothModifierData *clmd)
   Cloth *cloth = clmd->clothObject;
   const MVertTri *tri = cloth->tri;
   const ClothVertex *v = cloth->verts;
-  float weights[3] = {1.0f, 1.0f, 1.0f};
   float vol = 0;
 
   /* Early exit for hair, as it never has volume. */
@@ -137,14 +189,16 @@ static float cloth_calc_rest_volume(ClothModifierData *clmd)
     return 0.0f;
   }
 
-  for (uint i = 0; i < cloth->primitive_num; i++) {
+  vol = cloth_deterministic_sum(cloth->primitive_num, 0.0f, [&](const uint i) {
     const MVertTri *vt = &tri[i];
+    float weights[3];
 
     if (cloth_get_pressure_weights(clmd, vt, weights)) {
-      vol += volume_tri_tetrahedron_signed_v3_6x(
+      return volume_tri_tetrahedron_signed_v3_6x(
           v[vt->tri[0]].xrest, v[vt->tri[1]].xrest, v[vt->tri[2]].xrest);
     }
-  }
+    return 0.0f;
+  });
 
   /* We need to divide by 6 to get the actual volume. */
   vol = vol / 6.0f;
@@ -157,24 +211,66 @@ static float cloth_calc_average_pressure(ClothModifierData *clmd, const float *v
   Cloth *cloth = clmd->clothObject;
   const MVertTri *tri = cloth->tri;
   Implicit_Data *data = cloth->implicit;
-  float weights[3] = {1.0f, 1.0f, 1.0f};
-  float total_force = 0;
-  float total_area = 0;
 
-  for (uint i = 0; i < cloth->primitive_num; i++) {
-    const MVertTri *vt = &tri[i];
+  /* Total force and total area. */
+  const blender::float2 total = cloth_deterministic_sum(
+      cloth->primitive_num, blender::float2(0.0f), [&](const uint i) {
+        const MVertTri *vt = &tri[i];
+        float weights[3];
 
-    if (cloth_get_pressure_weights(clmd, vt, weights)) {
-      float area = SIM_tri_area(data, vt->tri[0], vt->tri[1], vt->tri[2]);
+        if (cloth_get_pressure_weights(clmd, vt, weights)) {
+          float area = SIM_tri_area(data, vt->tri[0], vt->tri[1], vt->tri[2]);
 
-      total_force += (vertex_pressure[vt->tri[0]] + vertex_pressure[vt->tri[1]] +
-                      vertex_pressure[vt->tri[2]]) *
-                     area / 3.0f;
-      total_area += area;
-    }
+          return blender::float2((vertex_pressure[vt->tri[0]] + vertex_pressure[vt->tri[1]] +
+                                  vertex_pressure[vt->tri[2]]) *
+                                     area / 3.0f,
+                                 area);
+        }
+        return blender::float2(0.0f);
+      });
+
+  return total.x / total.y;
+}
+
+/* Lay out the springs for the solver, sorted by their first vertex so that consecutive springs
+ * read and write nearby vertices. The order of springs sharing a vertex is kept. */
+static void cloth_spring_arrays_build(Cloth *cloth)
+{
+  ClothSpringArrays &springs = cloth->spring_arrays;
+  const int springs_num = BLI_linklist_count(cloth->springs);
+
+  blender::Array<ClothSpring *> list_order(springs_num);
+  int index = 0;
+  for (LinkNode *link = cloth->springs; link; link = link->next) {
+    list_order[index++] = (ClothSpring *)link->link;
   }
+  std::stable_sort(list_order.begin(),
+                   list_order.end(),
+                   [](const ClothSpring *a, const ClothSpring *b) { return a->ij < b->ij; });
+
+  springs.springs = std::move(list_order);
+  springs.verts.reinitialize(springs_num);
+  springs.types.reinitialize(springs_num);
+  springs.restlen.reinitialize(springs_num);
+  springs.lin_stiffness.reinitialize(springs_num);
+  springs.active.reinitialize(springs_num);
+  for (const int i : springs.springs.index_range()) {
+    const ClothSpring *spring = springs.springs[i];
+    springs.verts[i] = blender::int2(spring->ij, spring->kl);
+    springs.types[i] = spring->type;
+  }
+}
 
-  return total_force / total_area;
+/* Copy the spring values that can change from frame to frame, see #cloth_update_springs. */
+static void cloth_spring_arrays_update(Cloth *cloth)
+{
+  ClothSpringArrays &springs = cloth->spring_arrays;
+  for (const int i : springs.springs.index_range()) {
+    const ClothSpring *spring = springs.springs[i];
+    springs.restlen[i] = spring->restlen;
+    springs.lin_stiffness[i] = spring->lin_stiffness;
+    springs.active[i] = !(spring->flags & CLOTH_SPRING_FLAG_DEACTIVATE);
+  }
 }
 
 int SIM_cloth_solver_init(Object * /*ob*/, ClothModifierData *clmd)
@@ -187,6 +283,7 @@ int SIM_cloth_solver_init(Object * /*ob*/, ClothModifierData *clmd)
 
   nondiag = cloth_count_nondiag_blocks(cloth);
   cloth->implicit = id = SIM_mass_spring_solver_create(cloth->mvert_num, nondiag);
+  cloth_spring_arrays_build(cloth);
 
   for (i = 0; i < cloth->mvert_num; i++) {
     SIM_mass_spring_set_implicit_vertex_mass(id, i, verts[i].mass);
@@ -212,6 +309,7 @@ void SIM_cloth_solver_free(ClothModifierData *clmd)
     SIM_mass_spring_solver_free(cloth->implicit);
     cloth->implicit = nullptr;
   }
+  cloth->spring_arrays = {};
 }
 
 void SIM_cloth_solver_set_positions(ClothModifierData *clmd)
@@ -233,6 +331,8 @@ void SIM_cloth_solver_set_positions(ClothModifierData *clmd)
 
     SIM_mass_spring_set_motion_state(id, i, verts[i].x, verts[i].v);
   }
+
+  SIM_mass_spring_clear_warm_start(id);
 }
 
 void SIM_cloth_solver_set_volume(ClothModifierData *clmd)
@@ -354,7 +454,9 @@ static int UNUSED_FUNCTION(cloth_calc_helper_forces)(
   return 1;
 }
 
-BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
+BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd,
+                                        const ClothSpringArrays &springs,
+                                        const int index)
 {
   Cloth *cloth = clmd->clothObject;
   ClothSimSettings *parms = clmd->sim_parms;
@@ -363,45 +465,46 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
   bool resist_compress = (parms->flags & CLOTH_SIMSETTINGS_FLAG_RESIST_SPRING_COMPRESS) &&
                          !using_angular;
 
-  s->flags &= ~CLOTH_SPRING_FLAG_NEEDED;
+  const int ij = springs.verts[index][0];
+  const int kl = springs.verts[index][1];
+  const int type = springs.types[index];
+  const float restlen = springs.restlen[index];
+  const float lin_stiffness = springs.lin_stiffness[index];
+  /* Only angular bending and hair bending need the rest of the spring. */
+  const ClothSpring *s = springs.springs[index];
 
   /* Calculate force of bending springs. */
-  if ((s->type & CLOTH_SPRING_TYPE_BENDING) && using_angular) {
+  if ((type & CLOTH_SPRING_TYPE_BENDING) && using_angular) {
 #ifdef CLOTH_FORCE_SPRING_BEND
     float k, scaling;
 
-    s->flags |= CLOTH_SPRING_FLAG_NEEDED;
-
     scaling = parms->bending + s->ang_stiffness * fabsf(parms->max_bend - parms->bending);
     /* Multiplying by 0.1, just to scale the forces to more reasonable values. */
-    k = scaling * s->restlen * 0.1f;
+    k = scaling * restlen * 0.1f;
 
     SIM_mass_spring_force_spring_angular(
-        data, s->ij, s->kl, s->pa, s->pb, s->la, s->lb, s->restang, k, parms->bending_damping);
+        data, ij, kl, s->pa, s->pb, s->la, s->lb, s->restang, k, parms->bending_damping);
 #endif
   }
 
   /* Calculate force of structural + shear springs. */
-  if (s->type &
+  if (type &
       (CLOTH_SPRING_TYPE_STRUCTURAL | CLOTH_SPRING_TYPE_SEWING | CLOTH_SPRING_TYPE_INTERNAL))
   {
 #ifdef CLOTH_FORCE_SPRING_STRUCTURAL
     float k_tension, scaling_tension;
 
-    s->flags |= CLOTH_SPRING_FLAG_NEEDED;
-
-    scaling_tension = parms->tension +
-                      s->lin_stiffness * fabsf(parms->max_tension - parms->tension);
+    scaling_tension = parms->tension + lin_stiffness * fabsf(parms->max_tension - parms->tension);
     k_tension = scaling_tension / (parms->avg_spring_len + FLT_EPSILON);
 
-    if (s->type & CLOTH_SPRING_TYPE_SEWING) {
+    if (type & CLOTH_SPRING_TYPE_SEWING) {
       /* TODO: verify, half verified (couldn't see error)
        * sewing springs usually have a large distance at first so clamp the force so we don't get
        * tunneling through collision objects. */
       SIM_mass_spring_force_spring_linear(data,
-                                          s->ij,
-                                          s->kl,
-                                          s->restlen,
+                                          ij,
+                                          kl,
+                                          restlen,
                                           k_tension,
                                           parms->tension_damp,
                                           0.0f,
@@ -410,16 +513,16 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
                                           false,
                                           parms->max_sewing);
     }
-    else if (s->type & CLOTH_SPRING_TYPE_STRUCTURAL) {
+    else if (type & CLOTH_SPRING_TYPE_STRUCTURAL) {
       float k_compression, scaling_compression;
       scaling_compression = parms->compression +
-                            s->lin_stiffness * fabsf(parms->max_compression - parms->compression);
+                            lin_stiffness * fabsf(parms->max_compression - parms->compression);
       k_compression = scaling_compression / (parms->avg_spring_len + FLT_EPSILON);
 
       SIM_mass_spring_force_spring_linear(data,
-                                          s->ij,
-                                          s->kl,
-                                          s->restlen,
+                                          ij,
+                                          kl,
+                                          restlen,
                                           k_tension,
                                           parms->tension_damp,
                                           k_compression,
@@ -430,15 +533,15 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
     }
     else {
       /* CLOTH_SPRING_TYPE_INTERNAL */
-      BLI_assert(s->type & CLOTH_SPRING_TYPE_INTERNAL);
+      BLI_assert(type & CLOTH_SPRING_TYPE_INTERNAL);
 
       scaling_tension = parms->internal_tension +
-                        s->lin_stiffness *
+                        lin_stiffness *
                             fabsf(parms->max_internal_tension - parms->internal_tension);
       k_tension = scaling_tension / (parms->avg_spring_len + FLT_EPSILON);
       float scaling_compression = parms->internal_compression +
-                                  s->lin_stiffness * fabsf(parms->max_internal_compression -
-                                                           parms->internal_compression);
+                                  lin_stiffness * fabsf(parms->max_internal_compression -
+                                                        parms->internal_compression);
       float k_compression = scaling_compression / (parms->avg_spring_len + FLT_EPSILON);
 
       float k_tension_damp = parms->tension_damp;
@@ -455,9 +558,9 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
       }
 
       SIM_mass_spring_force_spring_linear(data,
-                                          s->ij,
-                                          s->kl,
-                                          s->restlen,
+                                          ij,
+                                          kl,
+                                          restlen,
                                           k_tension,
                                           k_tension_damp,
                                           k_compression,
@@ -468,19 +571,17 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
     }
 #endif
   }
-  else if (s->type & CLOTH_SPRING_TYPE_SHEAR) {
+  else if (type & CLOTH_SPRING_TYPE_SHEAR) {
 #ifdef CLOTH_FORCE_SPRING_SHEAR
     float k, scaling;
 
-    s->flags |= CLOTH_SPRING_FLAG_NEEDED;
-
-    scaling = parms->shear + s->lin_stiffness * fabsf(parms->max_shear - parms->shear);
+    scaling = parms->shear + lin_stiffness * fabsf(parms->max_shear - parms->shear);
     k = scaling / (parms->avg_spring_len + FLT_EPSILON);
 
     SIM_mass_spring_force_spring_linear(data,
-                                        s->ij,
-                                        s->kl,
-                                        s->restlen,
+                                        ij,
+                                        kl,
+                                        restlen,
                                         k,
                                         parms->shear_damp,
                                         0.0f,
@@ -490,32 +591,28 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
                                         0.0f);
 #endif
   }
-  else if (s->type & CLOTH_SPRING_TYPE_BENDING) { /* calculate force of bending springs */
+  else if (type & CLOTH_SPRING_TYPE_BENDING) { /* calculate force of bending springs */
 #ifdef CLOTH_FORCE_SPRING_BEND
     float kb, cb, scaling;
 
-    s->flags |= CLOTH_SPRING_FLAG_NEEDED;
-
-    scaling = parms->bending + s->lin_stiffness * fabsf(parms->max_bend - parms->bending);
+    scaling = parms->bending + lin_stiffness * fabsf(parms->max_bend - parms->bending);
     kb = scaling / (20.0f * (parms->avg_spring_len + FLT_EPSILON));
 
     /* Fix for #45084 for cloth stiffness must have cb proportional to kb */
     cb = kb * parms->bending_damping;
 
-    SIM_mass_spring_force_spring_bending(data, s->ij, s->kl, s->restlen, kb, cb);
+    SIM_mass_spring_force_spring_bending(data, ij, kl, restlen, kb, cb);
 #endif
   }
-  else if (s->type & CLOTH_SPRING_TYPE_BENDING_HAIR) {
+  else if (type & CLOTH_SPRING_TYPE_BENDING_HAIR) {
 #ifdef CLOTH_FORCE_SPRING_BEND
     float kb, cb, scaling;
 
-    s->flags |= CLOTH_SPRING_FLAG_NEEDED;
-
     /* XXX WARNING: angular bending springs for hair apply stiffness factor as an overall factor,
      * unlike cloth springs! this is crap, but needed due to cloth/hair mixing ... max_bend factor
      * is not even used for hair, so ...
      */
-    scaling = s->lin_stiffness * parms->bending;
+    scaling = lin_stiffness * parms->bending;
     kb = scaling / (20.0f * (parms->avg_spring_len + FLT_EPSILON));
 
     /* Fix for #45084 for cloth stiffness must have cb proportional to kb */
@@ -523,7 +620,7 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
 
     /* XXX assuming same restlen for ij and jk segments here,
      * this can be done correctly for hair later. */
-    SIM_mass_spring_force_spring_bending_hair(data, s->ij, s->kl, s->mn, s->target, kb, cb);
+    SIM_mass_spring_force_spring_bending_hair(data, ij, kl, s->mn, s->target, kb, cb);
 
 #  if 0
     {
@@ -709,20 +806,28 @@ static void cloth_calc_force(
                                                  "effector forces");
     float(*forcevec)[3] = is_not_hair ? winvec + mvert_num : winvec;
 
-    for (i = 0; i < cloth->mvert_num; i++) {
-      float x[3], v[3];
-      EffectedPoint epoint;
-
-      SIM_mass_spring_get_motion_state(data, i, x, v);
-      pd_point_from_loc(scene, x, v, i, &epoint);
-      BKE_effectors_apply(effectors,
-                          nullptr,
-                          clmd->sim_parms->effector_weights,
-                          &epoint,
-                          forcevec[i],
-                          winvec[i],
-                          nullptr);
+    blender::Array<blender::float3> positions(mvert_num), velocities(mvert_num);
+    for (i = 0; i < mvert_num; i++) {
+      SIM_mass_spring_get_motion_state(data, i, positions[i], velocities[i]);
+    }
 
+    /* Hair accumulates wind and other forces together. */
+    blender::MutableSpan<blender::float3> forces(reinterpret_cast<blender::float3 *>(forcevec),
+                                                 mvert_num);
+    blender::MutableSpan<blender::float3> wind_forces;
+    if (is_not_hair) {
+      wind_forces = {reinterpret_cast<blender::float3 *>(winvec), mvert_num};
+    }
+    blender::bke::effectors_apply_batch(effectors,
+                                        nullptr,
+                                        clmd->sim_parms->effector_weights,
+                                        scene,
+                                        positions,
+                                        velocities,
+                                        forces,
+                                        wind_forces);
+
+    for (i = 0; i < mvert_num; i++) {
       has_wind = has_wind || !is_zero_v3(winvec[i]);
       has_force = has_force || !is_zero_v3(forcevec[i]);
     }
@@ -778,11 +883,11 @@ static void cloth_calc_force(
   }
 
   /* calculate spring forces */
-  for (LinkNode *link = cloth->springs; link; link = link->next) {
-    ClothSpring *spring = (ClothSpring *)link->link;
+  const ClothSpringArrays &springs = cloth->spring_arrays;
+  for (const int64_t index : springs.springs.index_range()) {
     /* only handle active springs */
-    if (!(spring->flags & CLOTH_SPRING_FLAG_DEACTIVATE)) {
-      cloth_calc_spring_force(clmd, spring);
+    if (springs.active[index]) {
+      cloth_calc_spring_force(clmd, springs, int(index));
     }
   }
 }
@@ -1173,37 +1278,57 @@ static void cloth_calc_average_acceleration(ClothModifierData *clmd, float dt)
   interp_v3_v3v3(cloth->average_acceleration, total, cloth->average_acceleration, powf(0.25f, dt));
 }
 
-static void cloth_solve_collisions(
-    Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt)
+static bool cloth_uses_collisions(const ClothModifierData *clmd)
+{
+  return (clmd->coll_parms->flags &
+          (CLOTH_COLLSETTINGS_FLAG_ENABLED | CLOTH_COLLSETTINGS_FLAG_SELF)) &&
+         clmd->clothObject->bvhtree;
+}
+
+/**
+ * Update the vertices to the positions at the end of the step, before the collision response.
+ */
+static void cloth_collisions_predict_positions(ClothModifierData *clmd, float dt)
 {
   Cloth *cloth = clmd->clothObject;
   Implicit_Data *id = cloth->implicit;
   ClothVertex *verts = cloth->verts;
   int mvert_num = cloth->mvert_num;
-  const float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
-  int i;
-
-  if (!(clmd->coll_parms->flags &
-        (CLOTH_COLLSETTINGS_FLAG_ENABLED | CLOTH_COLLSETTINGS_FLAG_SELF))) {
-    return;
-  }
-
-  if (!clmd->clothObject->bvhtree) {
-    return;
-  }
 
   SIM_mass_spring_solve_positions(id, dt);
 
-  /* Update verts to current positions. */
-  for (i = 0; i < mvert_num; i++) {
+  for (int i = 0; i < mvert_num; i++) {
     SIM_mass_spring_get_new_position(id, i, verts[i].tx);
 
     sub_v3_v3v3(verts[i].tv, verts[i].tx, verts[i].txold);
     zero_v3(verts[i].dcvel);
   }
+}
 
-  if (cloth_bvh_collision(
-          depsgraph, ob, clmd, step / clmd->sim_parms->timescale, dt / clmd->sim_parms->timescale))
+/**
+ * Returns the largest position correction applied to a vertex by the collision response.
+ */
+static float cloth_collisions_resolve(Depsgraph *depsgraph,
+                                      Object *ob,
+                                      ClothModifierData *clmd,
+                                      float step,
+                                      float dt,
+                                      const bool move_colliders)
+{
+  Cloth *cloth = clmd->clothObject;
+  Implicit_Data *id = cloth->implicit;
+  ClothVertex *verts = cloth->verts;
+  int mvert_num = cloth->mvert_num;
+  const float time_multiplier = 1.0f / dt;
+  float max_correction_sq = 0.0f;
+  int i;
+
+  if (cloth_bvh_collision(depsgraph,
+                          ob,
+                          clmd,
+                          step / clmd->sim_parms->timescale,
+                          dt / clmd->sim_parms->timescale,
+                          move_colliders))
   {
     for (i = 0; i < mvert_num; i++) {
       if ((clmd->sim_parms->vgroup_mass > 0) && (verts[i].flags & CLOTH_VERT_FLAG_PINNED)) {
@@ -1213,8 +1338,26 @@ static void cloth_solve_collisions(
       SIM_mass_spring_get_new_velocity(id, i, verts[i].tv);
       madd_v3_v3fl(verts[i].tv, verts[i].dcvel, time_multiplier);
       SIM_mass_spring_set_new_velocity(id, i, verts[i].tv);
+
+      max_correction_sq = max_ff(max_correction_sq, len_squared_v3(verts[i].dcvel));
     }
   }
+
+  return sqrtf(max_correction_sq);
+}
+
+/**
+ * Returns the largest position correction applied to a vertex by the collision response.
+ */
+static float cloth_solve_collisions(
+    Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt)
+{
+  if (!cloth_uses_collisions(clmd)) {
+    return 0.0f;
+  }
+
+  cloth_collisions_predict_positions(clmd, dt);
+  return cloth_collisions_resolve(depsgraph, ob, clmd, step, dt, true);
 }
 
 static void cloth_clear_result(ClothModifierData *clmd)
@@ -1225,6 +1368,7 @@ static void cloth_clear_result(ClothModifierData *clmd)
   sres->max_error = sres->min_error = sres->avg_error = 0.0f;
   sres->max_iterations = sres->min_iterations = 0;
   sres->avg_iterations = 0.0f;
+  sres->collision_pairs = sres->collision_pairs_culled = 0;
 }
 
 static void cloth_record_result(ClothModifierData *clmd, ImplicitSolverResult *result, float dt)
@@ -1257,37 +1401,143 @@ static void cloth_record_result(ClothModifierData *clmd, ImplicitSolverResult *r
   sres->status |= result->status;
 }
 
-int SIM_cloth_solve(
-    Depsgraph *depsgraph, Object *ob, float frame, ClothModifierData *clmd, ListBase *effectors)
+/* Solver iteration counts below which the adaptive step may grow, and above which it shrinks. */
+#define CLOTH_ADAPTIVE_ITERATIONS_GROW 10
+#define CLOTH_ADAPTIVE_ITERATIONS_SHRINK 50
+/* Factor by which the adaptive step grows at most from one step to the next. */
+#define CLOTH_ADAPTIVE_GROWTH 1.5f
+
+/* Largest speed of the vertices after solving for the new velocities. */
+static float cloth_max_new_speed(Implicit_Data *id, const uint mvert_num)
 {
-  /* Hair currently is a cloth sim in disguise ...
-   * Collision detection and volumetrics work differently then.
-   * Bad design, TODO
-   */
-  Scene *scene = DEG_get_evaluated_scene(depsgraph);
-  const bool is_hair = (clmd->hairdata != nullptr);
+  /* The maximum does not depend on the reduction order. */
+  const float max_speed_sq = blender::threading::parallel_reduce(
+      blender::IndexRange(mvert_num),
+      CLOTH_PRESSURE_BLOCK_SIZE,
+      0.0f,
+      [&](const blender::IndexRange range, float max_sq) {
+        float v[3];
+        for (const int64_t i : range) {
+          SIM_mass_spring_get_new_velocity(id, int(i), v);
+          max_sq = max_ff(max_sq, len_squared_v3(v));
+        }
+        return max_sq;
+      },
+      [](const float a, const float b) { return max_ff(a, b); });
+  return sqrtf(max_speed_sq);
+}
 
-  uint i = 0;
-  float step = 0.0f, tf = clmd->sim_parms->timescale;
-  Cloth *cloth = clmd->clothObject;
-  ClothVertex *verts = cloth->verts /*, *cv*/;
-  uint mvert_num = cloth->mvert_num;
-  float dt = clmd->sim_parms->dt * clmd->sim_parms->timescale;
-  Implicit_Data *id = cloth->implicit;
+/**
+ * Fit the step size `dt` into the `remaining` time of the frame. Steps are never smaller than
+ * `dt_min` and the last step ends exactly at the end of the frame, so no tiny step is left over.
+ * With `shrink`, a step that would leave too little time is made smaller instead of larger.
+ */
+static float cloth_adaptive_step_fit(float dt,
+                                     const float remaining,
+                                     const float dt_min,
+                                     const bool shrink)
+{
+  dt = max_ff(dt, dt_min);
+  if (dt >= remaining || remaining - dt >= dt_min) {
+    return min_ff(dt, remaining);
+  }
+  if (shrink && remaining - dt_min >= dt_min) {
+    return remaining - dt_min;
+  }
+  return remaining;
+}
+
+/**
+ * Solve for the new velocities with the given step size, halving it while the solver does not
+ * converge or vertices travel further than allowed. Returns the step size that was used.
+ */
+static float cloth_adaptive_solve_velocities(Implicit_Data *id,
+                                             const uint mvert_num,
+                                             float dt,
+                                             const float remaining,
+                                             const float dt_min,
+                                             const float max_travel,
+                                             ImplicitSolverResult *result,
+                                             float *r_max_speed)
+{
+  while (true) {
+    SIM_mass_spring_solve_velocities(id, dt, result);
+    *r_max_speed = cloth_max_new_speed(id, mvert_num);
 
+    const bool is_converged = result->status == SIM_SOLVER_SUCCESS;
+    if (is_converged && *r_max_speed * dt <= max_travel) {
+      return dt;
+    }
+
+    float dt_retry = dt * 0.5f;
+    if (is_converged && *r_max_speed > 0.0f) {
+      /* Aim slightly below the travel limit, as the velocities change with the step size. */
+      dt_retry = min_ff(dt_retry, 0.9f * max_travel / *r_max_speed);
+    }
+    dt_retry = cloth_adaptive_step_fit(dt_retry, remaining, dt_min, true);
+    if (dt_retry >= dt) {
+      /* Already at the smallest step. */
+      return dt;
+    }
+    dt = dt_retry;
+  }
+}
+
+/**
+ * Size of the step following an adaptive step of size `dt`, from the solver effort, the
+ * distance traveled by the vertices and the collision correction.
+ */
+static float cloth_adaptive_next_step(const ClothModifierData *clmd,
+                                      const ImplicitSolverResult *result,
+                                      const float dt,
+                                      const float max_speed,
+                                      const float max_travel,
+                                      const float max_correction)
+{
+  const float travel = max_speed * dt;
+  const float collision_epsilon = clmd->coll_parms->epsilon;
+  float dt_next = dt;
+
+  if (result->iterations > CLOTH_ADAPTIVE_ITERATIONS_SHRINK ||
+      (collision_epsilon > 0.0f && max_correction > collision_epsilon))
+  {
+    /* Struggling solver or deep penetration: go back to smaller steps. */
+    dt_next = dt * 0.5f;
+  }
+  else if (result->iterations < CLOTH_ADAPTIVE_ITERATIONS_GROW && travel < 0.5f * max_travel &&
+           max_correction <= 0.5f * collision_epsilon)
+  {
+    dt_next = dt * CLOTH_ADAPTIVE_GROWTH;
+  }
+
+  if (max_speed > 0.0f) {
+    dt_next = min_ff(dt_next, max_travel / max_speed);
+  }
+  return dt_next;
+}
+
+static bool cloth_uses_acceleration(const ClothModifierData *clmd)
+{
   /* Hydrostatic pressure gradient of the fluid inside the object is affected by acceleration. */
-  bool use_acceleration = (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_PRESSURE) &&
-                          (clmd->sim_parms->fluid_density > 0);
+  return (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_PRESSURE) &&
+         (clmd->sim_parms->fluid_density > 0);
+}
 
-  BKE_sim_debug_data_clear_category("collision");
+static void cloth_solve_begin(ClothModifierData *clmd)
+{
+  Cloth *cloth = clmd->clothObject;
+  ClothVertex *verts = cloth->verts;
+  uint mvert_num = cloth->mvert_num;
+  Implicit_Data *id = cloth->implicit;
 
   if (!clmd->solver_result) {
     clmd->solver_result = MEM_cnew<ClothSolverResult>("cloth solver result");
   }
   cloth_clear_result(clmd);
+  cloth_spring_arrays_update(cloth);
 
   if (clmd->sim_parms->vgroup_mass > 0) { /* Do goal stuff. */
-    for (i = 0; i < mvert_num; i++) {
+    for (uint i = 0; i < mvert_num; i++) {
       /* update velocities with constrained velocities from pinned verts */
       if (verts[i].flags & CLOTH_VERT_FLAG_PINNED) {
         float v[3];
@@ -1300,64 +1550,244 @@ int SIM_cloth_solve(
     }
   }
 
-  if (!use_acceleration) {
+  if (!cloth_uses_acceleration(clmd)) {
     zero_v3(cloth->average_acceleration);
   }
+}
+
+/** Setup the constraints and forces of the step starting at \a step. */
+static void cloth_solve_step_forces(
+    Scene *scene, ClothModifierData *clmd, float frame, ListBase *effectors, float step)
+{
+  /* setup vertex constraints for pinned vertices */
+  cloth_setup_constraints(clmd);
+
+  /* initialize forces to zero */
+  SIM_mass_spring_clear_forces(clmd->clothObject->implicit);
+
+  /* calculate forces */
+  cloth_calc_force(scene, clmd, frame, effectors, step);
+}
+
+/** Advance to the end of the step of size \a dt starting at \a step, after the collisions. */
+static void cloth_solve_step_finish(ClothModifierData *clmd, float step, float dt)
+{
+  Cloth *cloth = clmd->clothObject;
+  ClothVertex *verts = cloth->verts;
+  uint mvert_num = cloth->mvert_num;
+  Implicit_Data *id = cloth->implicit;
+
+  /* Hair currently is a cloth sim in disguise ...
+   * Collision detection and volumetrics work differently then.
+   * Bad design, TODO
+   */
+  if (clmd->hairdata != nullptr) {
+    cloth_continuum_step(clmd, dt);
+  }
+
+  if (cloth_uses_acceleration(clmd)) {
+    cloth_calc_average_acceleration(clmd, dt);
+  }
+
+  SIM_mass_spring_solve_positions(id, dt);
+  SIM_mass_spring_apply_result(id);
+
+  /* move pinned verts to correct position */
+  for (uint i = 0; i < mvert_num; i++) {
+    if (clmd->sim_parms->vgroup_mass > 0) {
+      if (verts[i].flags & CLOTH_VERT_FLAG_PINNED) {
+        float x[3];
+        /* divide by time_scale to prevent pinned vertices'
+         * delta locations from being multiplied */
+        interp_v3_v3v3(
+            x, verts[i].xold, verts[i].xconst, (step + dt) / clmd->sim_parms->time_scale);
+        SIM_mass_spring_set_position(id, i, x);
+      }
+    }
+
+    SIM_mass_spring_get_motion_state(id, i, verts[i].txold, nullptr);
+  }
+}
+
+static void cloth_solve_end(ClothModifierData *clmd)
+{
+  Cloth *cloth = clmd->clothObject;
+  ClothVertex *verts = cloth->verts;
+
+  /* copy results back to cloth data */
+  for (uint i = 0; i < cloth->mvert_num; i++) {
+    SIM_mass_spring_get_motion_state(cloth->implicit, i, verts[i].x, verts[i].v);
+    copy_v3_v3(verts[i].txold, verts[i].x);
+  }
+}
+
+int SIM_cloth_solve(
+    Depsgraph *depsgraph, Object *ob, float frame, ClothModifierData *clmd, ListBase *effectors)
+{
+  Scene *scene = DEG_get_evaluated_scene(depsgraph);
+
+  float step = 0.0f, tf = clmd->sim_parms->timescale;
+  Cloth *cloth = clmd->clothObject;
+  uint mvert_num = cloth->mvert_num;
+  float dt = clmd->sim_parms->dt * clmd->sim_parms->timescale;
+  Implicit_Data *id = cloth->implicit;
+
+  BKE_sim_debug_data_clear_category("collision");
+
+  cloth_solve_begin(clmd);
+
+  /* Adaptive steps are bounded relative to the simulated time, like the fixed step size. */
+  const bool use_adaptive = clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_ADAPTIVE_STEPS;
+  const float dt_max = tf / max_ii(clmd->sim_parms->adaptive_steps_min, 1);
+  const float dt_min = min_ff(tf / max_ii(clmd->sim_parms->adaptive_steps_max, 1), dt_max);
+  float max_travel = FLT_MAX;
+  float dt_next = dt;
+
+  if (use_adaptive) {
+    if (clmd->sim_parms->adaptive_cfl > 0.0f && clmd->sim_parms->avg_spring_len > 0.0f) {
+      max_travel = clmd->sim_parms->adaptive_cfl * clmd->sim_parms->avg_spring_len;
+    }
+    /* Continue with the step size the previous frame ended with. */
+    if (cloth->adaptive_dt > 0.0f) {
+      dt_next = cloth->adaptive_dt * tf;
+    }
+    dt_next = clamp_f(dt_next, dt_min, dt_max);
+    /* The step sizes depend on the solver effort, so the solve of a frame only depends on what
+     * the point cache stores for the previous frame: a simulation resumed from the cache takes
+     * the same steps as an uninterrupted run. */
+    SIM_mass_spring_clear_warm_start(id);
+    cloth->adaptive_steps.clear();
+  }
 
   while (step < tf) {
     ImplicitSolverResult result;
+    float max_speed = 0.0f;
 
-    /* setup vertex constraints for pinned vertices */
-    cloth_setup_constraints(clmd);
-
-    /* initialize forces to zero */
-    SIM_mass_spring_clear_forces(id);
+    if (use_adaptive) {
+      dt = cloth_adaptive_step_fit(dt_next, tf - step, dt_min, false);
+    }
 
-    /* calculate forces */
-    cloth_calc_force(scene, clmd, frame, effectors, step);
+    cloth_solve_step_forces(scene, clmd, frame, effectors, step);
 
     /* calculate new velocity and position */
-    SIM_mass_spring_solve_velocities(id, dt, &result);
+    if (use_adaptive) {
+      dt = cloth_adaptive_solve_velocities(
+          id, mvert_num, dt, tf - step, dt_min, max_travel, &result, &max_speed);
+    }
+    else {
+      SIM_mass_spring_solve_velocities(id, dt, &result);
+    }
     cloth_record_result(clmd, &result, dt);
+    if (use_adaptive) {
+      cloth->adaptive_steps.append(dt / tf);
+    }
 
     /* Calculate collision impulses. */
-    cloth_solve_collisions(depsgraph, ob, clmd, step, dt);
+    const float max_correction = cloth_solve_collisions(depsgraph, ob, clmd, step, dt);
 
-    if (is_hair) {
-      cloth_continuum_step(clmd, dt);
+    if (use_adaptive) {
+      dt_next = clamp_f(
+          cloth_adaptive_next_step(clmd, &result, dt, max_speed, max_travel, max_correction),
+          dt_min,
+          dt_max);
     }
 
-    if (use_acceleration) {
-      cloth_calc_average_acceleration(clmd, dt);
+    cloth_solve_step_finish(clmd, step, dt);
+
+    /* Adaptive steps end exactly at the end of the frame, avoid rounding errors adding a step. */
+    step = (use_adaptive && dt == tf - step) ? tf : step + dt;
+  }
+
+  if (use_adaptive) {
+    cloth->adaptive_dt = dt_next / tf;
+  }
+
+  cloth_solve_end(clmd);
+
+  return 1;
+}
+
+void SIM_cloth_solve_group(Depsgraph *depsgraph,
+                           float frame,
+                           ClothGroupItem *items,
+                           int items_num)
+{
+  using namespace blender;
+  Scene *scene = DEG_get_evaluated_scene(depsgraph);
+  const IndexRange items_range(items_num);
+
+  /* All objects take the same steps, use the finest fixed step size of the group. Adaptive
+   * stepping is per object, so it is not used here. The objects of a group simulate the same
+   * time span, see #cloth_group_step. */
+  const float timescale = items[0].clmd->sim_parms->timescale;
+  int steps_num = 1;
+  Vector<Object *> objects;
+  for (const int64_t i : items_range) {
+    BLI_assert(items[i].clmd->sim_parms->timescale == timescale);
+    steps_num = max_ii(steps_num, items[i].clmd->sim_parms->stepsPerFrame);
+    objects.append(items[i].ob);
+  }
+  const float dt = timescale / steps_num;
+
+  BKE_sim_debug_data_clear_category("collision");
+
+  threading::parallel_for(items_range, 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      cloth_solve_begin(items[i].clmd);
+      /* Fixed steps, the point cache doesn't store step sizes for this frame. */
+      items[i].clmd->clothObject->adaptive_dt = 0.0f;
+      items[i].clmd->clothObject->adaptive_steps.clear();
     }
+  });
 
-    SIM_mass_spring_solve_positions(id, dt);
-    SIM_mass_spring_apply_result(id);
+  for (int step_index = 0; step_index < steps_num; step_index++) {
+    const float step = dt * step_index;
 
-    /* move pinned verts to correct position */
-    for (i = 0; i < mvert_num; i++) {
-      if (clmd->sim_parms->vgroup_mass > 0) {
-        if (verts[i].flags & CLOTH_VERT_FLAG_PINNED) {
-          float x[3];
-          /* divide by time_scale to prevent pinned vertices'
-           * delta locations from being multiplied */
-          interp_v3_v3v3(
-              x, verts[i].xold, verts[i].xconst, (step + dt) / clmd->sim_parms->time_scale);
-          SIM_mass_spring_set_position(id, i, x);
+    /* Every object solves its own step, then all collisions are resolved against the predicted
+     * positions of the other objects at the end of the same step. */
+    threading::parallel_for(items_range, 1, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        ClothModifierData *clmd = items[i].clmd;
+        ImplicitSolverResult result;
+
+        cloth_solve_step_forces(scene, clmd, frame, items[i].effectors, step);
+        SIM_mass_spring_solve_velocities(clmd->clothObject->implicit, dt, &result);
+        cloth_record_result(clmd, &result, dt);
+
+        if (cloth_uses_collisions(clmd)) {
+          cloth_collisions_predict_positions(clmd, dt);
         }
       }
+    });
 
-      SIM_mass_spring_get_motion_state(id, i, verts[i].txold, nullptr);
+    for (const int64_t i : items_range) {
+      if (cloth_uses_collisions(items[i].clmd)) {
+        cloth_group_collider_update(items[i].ob, items[i].clmd);
+      }
     }
+    /* The other colliders are shared by the objects, move them before resolving collisions. */
+    cloth_group_colliders_move(depsgraph, objects, step / timescale, dt / timescale);
+
+    threading::parallel_for(items_range, 1, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        ClothModifierData *clmd = items[i].clmd;
 
-    step += dt;
+        if (cloth_uses_collisions(clmd)) {
+          cloth_collisions_resolve(depsgraph, items[i].ob, clmd, step, dt, false);
+        }
+        cloth_solve_step_finish(clmd, step, dt);
+      }
+    });
   }
 
-  /* copy results back to cloth data */
-  for (i = 0; i < mvert_num; i++) {
-    SIM_mass_spring_get_motion_state(id, i, verts[i].x, verts[i].v);
-    copy_v3_v3(verts[i].txold, verts[i].x);
+  for (const int64_t i : items_range) {
+    cloth_group_collider_update_end(items[i].ob, items[i].clmd);
   }
 
-  return 1;
+  threading::parallel_for(items_range, 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      cloth_solve_end(items[i].clmd);
+      items[i].result = 1;
+    }
+  });
 }
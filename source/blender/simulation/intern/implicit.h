@@ -52,6 +52,9 @@ BLI_INLINE void implicit_print_matrix_elem(float v)
 void SIM_mass_spring_set_vertex_mass(struct Implicit_Data *data, int index, float mass);
 void SIM_mass_spring_set_rest_transform(struct Implicit_Data *data, int index, float tfm[3][3]);
 
+/* Forget the previous solution, the next solve starts from scratch instead of warm starting.
+ * Needed whenever the motion state is set from outside of the solver (cache reads, resets). */
+void SIM_mass_spring_clear_warm_start(struct Implicit_Data *data);
 void SIM_mass_spring_set_motion_state(struct Implicit_Data *data,
                                       int index,
                                       const float x[3],
@@ -21,6 +21,7 @@
 #  include "BLI_math_geom.h"
 #  include "BLI_math_matrix.h"
 #  include "BLI_math_vector.h"
+#  include "BLI_task.hh"
 #  include "BLI_utildefines.h"
 
 #  include "BKE_cloth.hh"
@@ -33,9 +34,12 @@
 #    pragma GCC diagnostic ignored "-Wtype-limits"
 #  endif
 
-#  ifdef _OPENMP
-#    define CLOTH_OPENMP_LIMIT 512
-#  endif
+/* Vertex count from which long vector and sparse matrix operations are split over threads,
+ * smaller meshes are cheaper to solve on a single thread. This is also the block size of the
+ * deterministic dot product, so meshes below the limit sum in exactly the same order as before. */
+#  define CLOTH_PARALLEL_LIMIT 1024
+/* Number of vertices handled by a single task. */
+#  define CLOTH_PARALLEL_GRAIN 256
 
 //#define DEBUG_TIME
 
@@ -140,13 +144,25 @@ DO_INLINE void cp_lfvector(float (*to)[3], float (*from)[3], uint verts)
 {
   memcpy(to, from, verts * sizeof(lfVector));
 }
+/* Run `fn` over the vertex range, split into parallel tasks for large meshes.
+ * Every vertex is written by exactly one task, so the result does not depend on threading. */
+template<typename Function> BLI_INLINE void lfvector_range(uint verts, const Function &fn)
+{
+  const blender::IndexRange range(verts);
+  if (verts < CLOTH_PARALLEL_LIMIT) {
+    fn(range);
+    return;
+  }
+  blender::threading::parallel_for(range, CLOTH_PARALLEL_GRAIN, fn);
+}
 /* init long vector with float[3] */
 DO_INLINE void init_lfvector(float (*fLongVector)[3], const float vector[3], uint verts)
 {
-  uint i = 0;
-  for (i = 0; i < verts; i++) {
-    copy_v3_v3(fLongVector[i], vector);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      copy_v3_v3(fLongVector[i], vector);
+    }
+  });
 }
 /* zero long vector with float[3] */
 DO_INLINE void zero_lfvector(float (*to)[3], uint verts)
@@ -156,34 +172,57 @@ DO_INLINE void zero_lfvector(float (*to)[3], uint verts)
 /* Multiply long vector with scalar. */
 DO_INLINE void mul_lfvectorS(float (*to)[3], float (*fLongVector)[3], float scalar, uint verts)
 {
-  uint i = 0;
-
-  for (i = 0; i < verts; i++) {
-    mul_fvector_S(to[i], fLongVector[i], scalar);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      mul_fvector_S(to[i], fLongVector[i], scalar);
+    }
+  });
 }
 /* Multiply long vector with scalar.
  * `A -= B * float` */
 DO_INLINE void submul_lfvectorS(float (*to)[3], float (*fLongVector)[3], float scalar, uint verts)
 {
-  uint i = 0;
-  for (i = 0; i < verts; i++) {
-    VECSUBMUL(to[i], fLongVector[i], scalar);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      VECSUBMUL(to[i], fLongVector[i], scalar);
+    }
+  });
 }
 /* dot product for big vector */
 DO_INLINE float dot_lfvector(float (*fLongVectorA)[3], float (*fLongVectorB)[3], uint verts)
 {
-  long i = 0;
-  float temp = 0.0;
-  /* XXX brecht, disabled this for now (first schedule line was already disabled),
-   * due to non-commutative nature of floating point ops this makes the sim give
-   * different results each time you run it!
-   * schedule(guided, 2) */
-  //#pragma omp parallel for reduction(+: temp) if (verts > CLOTH_OPENMP_LIMIT)
-  for (i = 0; i < long(verts); i++) {
-    temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
+  /* Floating point addition is not associative, so a plain parallel reduction would make the
+   * sim give different results each time you run it. Instead the vector is summed in blocks of
+   * a fixed size and the partial sums are added in block order, which gives the same result for
+   * the serial and the threaded path, independent of the number of threads. */
+  const uint blocks_num = (verts + CLOTH_PARALLEL_LIMIT - 1) / CLOTH_PARALLEL_LIMIT;
+  auto block_sum = [&](const uint block) {
+    const uint start = block * CLOTH_PARALLEL_LIMIT;
+    const uint end = std::min(start + CLOTH_PARALLEL_LIMIT, verts);
+    float temp = 0.0f;
+    for (uint i = start; i < end; i++) {
+      temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
+    }
+    return temp;
+  };
+
+  if (blocks_num <= 1) {
+    return blocks_num == 0 ? 0.0f : block_sum(0);
+  }
+
+  float *partial = (float *)MEM_mallocN(sizeof(float) * blocks_num, "cloth_implicit_dot_partial");
+  blender::threading::parallel_for(
+      blender::IndexRange(blocks_num), 1, [&](const blender::IndexRange range) {
+        for (const int64_t block : range) {
+          partial[block] = block_sum(uint(block));
+        }
+      });
+
+  float temp = 0.0f;
+  for (uint block = 0; block < blocks_num; block++) {
+    temp += partial[block];
   }
+  MEM_freeN(partial);
   return temp;
 }
 /* `A = B + C` -> for big vector. */
@@ -192,21 +231,21 @@ DO_INLINE void add_lfvector_lfvector(float (*to)[3],
                                      float (*fLongVectorB)[3],
                                      uint verts)
 {
-  uint i = 0;
-
-  for (i = 0; i < verts; i++) {
-    add_v3_v3v3(to[i], fLongVectorA[i], fLongVectorB[i]);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      add_v3_v3v3(to[i], fLongVectorA[i], fLongVectorB[i]);
+    }
+  });
 }
 /* `A = B + C * float` -> for big vector. */
 DO_INLINE void add_lfvector_lfvectorS(
     float (*to)[3], float (*fLongVectorA)[3], float (*fLongVectorB)[3], float bS, uint verts)
 {
-  uint i = 0;
-
-  for (i = 0; i < verts; i++) {
-    VECADDS(to[i], fLongVectorA[i], fLongVectorB[i], bS);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      VECADDS(to[i], fLongVectorA[i], fLongVectorB[i], bS);
+    }
+  });
 }
 /* `A = B * float + C * float` -> for big vector */
 DO_INLINE void add_lfvectorS_lfvectorS(float (*to)[3],
@@ -216,20 +255,21 @@ DO_INLINE void add_lfvectorS_lfvectorS(float (*to)[3],
                                        float bS,
                                        uint verts)
 {
-  uint i = 0;
-
-  for (i = 0; i < verts; i++) {
-    VECADDSS(to[i], fLongVectorA[i], aS, fLongVectorB[i], bS);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      VECADDSS(to[i], fLongVectorA[i], aS, fLongVectorB[i], bS);
+    }
+  });
 }
 /* `A = B - C * float` -> for big vector. */
 DO_INLINE void sub_lfvector_lfvectorS(
     float (*to)[3], float (*fLongVectorA)[3], float (*fLongVectorB)[3], float bS, uint verts)
 {
-  uint i = 0;
-  for (i = 0; i < verts; i++) {
-    VECSUBS(to[i], fLongVectorA[i], fLongVectorB[i], bS);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      VECSUBS(to[i], fLongVectorA[i], fLongVectorB[i], bS);
+    }
+  });
 }
 /* `A = B - C` -> for big vector. */
 DO_INLINE void sub_lfvector_lfvector(float (*to)[3],
@@ -237,11 +277,11 @@ DO_INLINE void sub_lfvector_lfvector(float (*to)[3],
                                      float (*fLongVectorB)[3],
                                      uint verts)
 {
-  uint i = 0;
-
-  for (i = 0; i < verts; i++) {
-    sub_v3_v3v3(to[i], fLongVectorA[i], fLongVectorB[i]);
-  }
+  lfvector_range(verts, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      sub_v3_v3v3(to[i], fLongVectorA[i], fLongVectorB[i]);
+    }
+  });
 }
 ///////////////////////////
 // 3x3 matrix
@@ -583,35 +623,128 @@ DO_INLINE void initdiag_bfmatrix(fmatrix3x3 *matrix, float m3[3][3])
   }
 }
 
+/* Per vertex lists of the blocks of a sparse matrix.
+ * Lets the matrix-vector product gather the contributions of each vertex instead of scattering
+ * them, so vertices can be processed in parallel without write conflicts. */
+struct fmatrixAdjacency {
+  uint vcount, scount;
+  /* Blocks in row i, in matrix order (the diagonal block comes first):
+   * `row_blocks[row_offsets[i]]` to `row_blocks[row_offsets[i + 1] - 1]`. */
+  uint *row_offsets, *row_blocks;
+  /* Off-diagonal blocks in column i, in matrix order. */
+  uint *col_offsets, *col_blocks;
+  uint *cursor;
+};
+
+static fmatrixAdjacency *create_bfmatrix_adjacency(uint verts, uint springs)
+{
+  fmatrixAdjacency *adj = (fmatrixAdjacency *)MEM_callocN(sizeof(fmatrixAdjacency),
+                                                          "cloth_implicit_adjacency");
+  adj->vcount = verts;
+  adj->scount = springs;
+  adj->row_offsets = (uint *)MEM_mallocN(sizeof(uint) * (verts + 1), "adjacency row_offsets");
+  adj->row_blocks = (uint *)MEM_mallocN(sizeof(uint) * (verts + springs), "adjacency row_blocks");
+  adj->col_offsets = (uint *)MEM_mallocN(sizeof(uint) * (verts + 1), "adjacency col_offsets");
+  adj->col_blocks = (uint *)MEM_mallocN(sizeof(uint) * max_ii(springs, 1),
+                                        "adjacency col_blocks");
+  adj->cursor = (uint *)MEM_mallocN(sizeof(uint) * (verts + 1), "adjacency cursor");
+  return adj;
+}
+
+static void del_bfmatrix_adjacency(fmatrixAdjacency *adj)
+{
+  if (adj != nullptr) {
+    MEM_freeN(adj->row_offsets);
+    MEM_freeN(adj->row_blocks);
+    MEM_freeN(adj->col_offsets);
+    MEM_freeN(adj->col_blocks);
+    MEM_freeN(adj->cursor);
+    MEM_freeN(adj);
+  }
+}
+
+/* Stable counting sort of the matrix blocks by row and column.
+ * Keeping the matrix order per vertex makes the gathered product add up its terms in exactly
+ * the same order as the serial scatter loop. */
+static void update_bfmatrix_adjacency(fmatrixAdjacency *adj, const fmatrix3x3 *m)
+{
+  const uint vcount = m[0].vcount;
+  const uint total = m[0].vcount + m[0].scount;
+  BLI_assert(vcount == adj->vcount && m[0].scount == adj->scount);
+
+  memset(adj->row_offsets, 0, sizeof(uint) * (vcount + 1));
+  memset(adj->col_offsets, 0, sizeof(uint) * (vcount + 1));
+  for (uint i = 0; i < total; i++) {
+    adj->row_offsets[m[i].r + 1]++;
+  }
+  for (uint i = vcount; i < total; i++) {
+    adj->col_offsets[m[i].c + 1]++;
+  }
+  for (uint v = 0; v < vcount; v++) {
+    adj->row_offsets[v + 1] += adj->row_offsets[v];
+    adj->col_offsets[v + 1] += adj->col_offsets[v];
+  }
+
+  memcpy(adj->cursor, adj->row_offsets, sizeof(uint) * vcount);
+  for (uint i = 0; i < total; i++) {
+    adj->row_blocks[adj->cursor[m[i].r]++] = i;
+  }
+  memcpy(adj->cursor, adj->col_offsets, sizeof(uint) * vcount);
+  for (uint i = vcount; i < total; i++) {
+    adj->col_blocks[adj->cursor[m[i].c]++] = i;
+  }
+}
+
 /* SPARSE SYMMETRIC multiply big matrix with long vector. */
 /* STATUS: verified */
-DO_INLINE void mul_bfmatrix_lfvector(float (*to)[3], fmatrix3x3 *from, lfVector *fLongVector)
+DO_INLINE void mul_bfmatrix_lfvector(float (*to)[3],
+                                     fmatrix3x3 *from,
+                                     lfVector *fLongVector,
+                                     const fmatrixAdjacency *adj = nullptr,
+                                     lfVector *temp_buffer = nullptr)
 {
   uint vcount = from[0].vcount;
-  lfVector *temp = create_lfvector(vcount);
 
+  if (adj != nullptr && vcount >= CLOTH_PARALLEL_LIMIT) {
+    /* Same sums as the loops below, but gathered per vertex. */
+    lfvector_range(vcount, [&](const blender::IndexRange range) {
+      for (const int64_t v : range) {
+        float temp[3] = {0.0f, 0.0f, 0.0f};
+        float tmp_to[3] = {0.0f, 0.0f, 0.0f};
+        for (uint k = adj->row_offsets[v]; k < adj->row_offsets[v + 1]; k++) {
+          const fmatrix3x3 &block = from[adj->row_blocks[k]];
+          muladd_fmatrix_fvector(temp, block.m, fLongVector[block.c]);
+        }
+        for (uint k = adj->col_offsets[v]; k < adj->col_offsets[v + 1]; k++) {
+          const fmatrix3x3 &block = from[adj->col_blocks[k]];
+          muladd_fmatrixT_fvector(tmp_to, block.m, fLongVector[block.r]);
+        }
+        add_v3_v3v3(to[v], tmp_to, temp);
+      }
+    });
+    return;
+  }
+
+  lfVector *temp = temp_buffer ? temp_buffer : create_lfvector(vcount);
+
+  if (temp_buffer) {
+    zero_lfvector(temp, vcount);
+  }
   zero_lfvector(to, vcount);
 
-#  pragma omp parallel sections if (vcount > CLOTH_OPENMP_LIMIT)
-  {
-#  pragma omp section
-    {
-      for (uint i = from[0].vcount; i < from[0].vcount + from[0].scount; i++) {
-        /* This is the lower triangle of the sparse matrix,
-         * therefore multiplication occurs with transposed sub-matrices. */
-        muladd_fmatrixT_fvector(to[from[i].c], from[i].m, fLongVector[from[i].r]);
-      }
-    }
-#  pragma omp section
-    {
-      for (uint i = 0; i < from[0].vcount + from[0].scount; i++) {
-        muladd_fmatrix_fvector(temp[from[i].r], from[i].m, fLongVector[from[i].c]);
-      }
-    }
+  for (uint i = from[0].vcount; i < from[0].vcount + from[0].scount; i++) {
+    /* This is the lower triangle of the sparse matrix,
+     * therefore multiplication occurs with transposed sub-matrices. */
+    muladd_fmatrixT_fvector(to[from[i].c], from[i].m, fLongVector[from[i].r]);
+  }
+  for (uint i = 0; i < from[0].vcount + from[0].scount; i++) {
+    muladd_fmatrix_fvector(temp[from[i].r], from[i].m, fLongVector[from[i].c]);
   }
   add_lfvector_lfvector(to, to, temp, from[0].vcount);
 
-  del_lfvector(temp);
+  if (temp != temp_buffer) {
+    del_lfvector(temp);
+  }
 }
 
 /* SPARSE SYMMETRIC sub big matrix with big matrix. */
@@ -620,11 +753,19 @@ DO_INLINE void mul_bfmatrix_lfvector(float (*to)[3], fmatrix3x3 *from, lfVector
 DO_INLINE void subadd_bfmatrixS_bfmatrixS(
     fmatrix3x3 *to, fmatrix3x3 *from, float aS, fmatrix3x3 *matrix, float bS)
 {
-  uint i = 0;
+  const blender::IndexRange blocks(matrix[0].vcount + matrix[0].scount);
+  auto subadd_blocks = [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      subadd_fmatrixS_fmatrixS(to[i].m, from[i].m, aS, matrix[i].m, bS);
+    }
+  };
 
   /* process diagonal elements */
-  for (i = 0; i < matrix[0].vcount + matrix[0].scount; i++) {
-    subadd_fmatrixS_fmatrixS(to[i].m, from[i].m, aS, matrix[i].m, bS);
+  if (matrix[0].vcount < CLOTH_PARALLEL_LIMIT) {
+    subadd_blocks(blocks);
+  }
+  else {
+    blender::threading::parallel_for(blocks, CLOTH_PARALLEL_GRAIN, subadd_blocks);
   }
 }
 
@@ -653,6 +794,17 @@ struct Implicit_Data {
   lfVector *z;          /* target velocity in constrained directions */
   fmatrix3x3 *S;        /* filtering matrix for constraints */
   fmatrix3x3 *P, *Pinv; /* pre-conditioning matrix */
+
+  /* Solution of the previous solve, used as the initial guess of the next one. */
+  lfVector *dV_prev;
+  float dt_prev; /* zero when there is no usable previous solution */
+
+  fmatrixAdjacency *adjacency; /* per vertex block lists of A and dFdX, for threading */
+
+  /* Scratch vectors of the solver. Owned by the solver data so that stepping many small cloth
+   * objects does not reallocate them for every substep and CG iteration. */
+  lfVector *cg_fB, *cg_AdV, *cg_r, *cg_c, *cg_q, *cg_s;
+  lfVector *dFdXmV, *mul_temp;
 };
 
 Implicit_Data *SIM_mass_spring_solver_create(int numverts, int numsprings)
@@ -677,6 +829,16 @@ Implicit_Data *SIM_mass_spring_solver_create(int numverts, int numsprings)
   id->B = create_lfvector(numverts);
   id->dV = create_lfvector(numverts);
   id->z = create_lfvector(numverts);
+  id->dV_prev = create_lfvector(numverts);
+  id->adjacency = create_bfmatrix_adjacency(numverts, numsprings);
+  id->cg_fB = create_lfvector(numverts);
+  id->cg_AdV = create_lfvector(numverts);
+  id->cg_r = create_lfvector(numverts);
+  id->cg_c = create_lfvector(numverts);
+  id->cg_q = create_lfvector(numverts);
+  id->cg_s = create_lfvector(numverts);
+  id->dFdXmV = create_lfvector(numverts);
+  id->mul_temp = create_lfvector(numverts);
 
   initdiag_bfmatrix(id->bigI, I);
 
@@ -703,6 +865,17 @@ void SIM_mass_spring_solver_free(Implicit_Data *id)
   del_lfvector(id->B);
   del_lfvector(id->dV);
   del_lfvector(id->z);
+  del_lfvector(id->dV_prev);
+
+  del_bfmatrix_adjacency(id->adjacency);
+  del_lfvector(id->cg_fB);
+  del_lfvector(id->cg_AdV);
+  del_lfvector(id->cg_r);
+  del_lfvector(id->cg_c);
+  del_lfvector(id->cg_q);
+  del_lfvector(id->cg_s);
+  del_lfvector(id->dFdXmV);
+  del_lfvector(id->mul_temp);
 
   MEM_freeN(id);
 }
@@ -743,11 +916,11 @@ BLI_INLINE void root_to_world_m3(Implicit_Data *data,
 
 DO_INLINE void filter(lfVector *V, fmatrix3x3 *S)
 {
-  uint i = 0;
-
-  for (i = 0; i < S[0].vcount; i++) {
-    mul_m3_v3(S[i].m, V[S[i].r]);
-  }
+  lfvector_range(S[0].vcount, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      mul_m3_v3(S[i].m, V[S[i].r]);
+    }
+  });
 }
 
 /* this version of the CG algorithm does not work very well with partial constraints
@@ -820,41 +993,86 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 }
 #  endif
 
-static int cg_filtered(lfVector *ldV,
-                       fmatrix3x3 *lA,
-                       lfVector *lB,
-                       lfVector *z,
-                       fmatrix3x3 *S,
-                       ImplicitSolverResult *result)
+/* Block Jacobi pre-conditioner: the inverse of the 3x3 diagonal blocks of A.
+ * Only the diagonal blocks of Pinv are used, the off-diagonal ones keep the spring layout. */
+static void update_block_jacobi(fmatrix3x3 *Pinv, const fmatrix3x3 *lA)
+{
+  lfvector_range(lA[0].vcount, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      /* Blocks of a positive definite A are positive definite too, anything else (pinned or
+       * degenerate vertices) falls back to the identity so the solver stays well defined. */
+      if (!(determinant_m3_array(lA[i].m) > 0.0f) || !invert_m3_m3(Pinv[i].m, lA[i].m)) {
+        unit_m3(Pinv[i].m);
+      }
+    }
+  });
+}
+
+/* to = Pinv * from, using the diagonal blocks only. */
+static void mul_block_jacobi_lfvector(lfVector *to, const fmatrix3x3 *Pinv, const lfVector *from)
+{
+  lfvector_range(Pinv[0].vcount, [&](const blender::IndexRange range) {
+    for (const int64_t i : range) {
+      mul_v3_m3v3(to[i], Pinv[i].m, from[i]);
+    }
+  });
+}
+
+static int cg_filtered(Implicit_Data *data, ImplicitSolverResult *result)
 {
   /* Solves for unknown X in equation AX=B */
   uint conjgrad_loopcount = 0, conjgrad_looplimit = 100;
   float conjgrad_epsilon = 0.01f;
 
-  uint numverts = lA[0].vcount;
-  lfVector *fB = create_lfvector(numverts);
-  lfVector *AdV = create_lfvector(numverts);
-  lfVector *r = create_lfvector(numverts);
-  lfVector *c = create_lfvector(numverts);
-  lfVector *q = create_lfvector(numverts);
-  lfVector *s = create_lfvector(numverts);
-  float bnorm2, delta_new, delta_old, delta_target, alpha;
-
-  cp_lfvector(ldV, z, numverts);
+  lfVector *ldV = data->dV;
+  fmatrix3x3 *lA = data->A;
+  lfVector *lB = data->B;
+  lfVector *z = data->z;
+  fmatrix3x3 *S = data->S;
+  const fmatrixAdjacency *adj = data->adjacency;
 
-  /* d0 = filter(B)^T * P * filter(B) */
+  uint numverts = lA[0].vcount;
+  lfVector *fB = data->cg_fB;
+  lfVector *AdV = data->cg_AdV;
+  lfVector *r = data->cg_r;
+  lfVector *c = data->cg_c;
+  lfVector *q = data->cg_q;
+  lfVector *s = data->cg_s;
+  const fmatrix3x3 *Pinv = data->Pinv;
+  float bnorm2, rnorm2, delta_new, delta_old, delta_target, alpha;
+
+  update_block_jacobi(data->Pinv, lA);
+
+  /* The tolerance applies to the residual itself, not the pre-conditioned one, so it means the
+   * same with and without pre-conditioner. */
   cp_lfvector(fB, lB, numverts);
   filter(fB, S);
   bnorm2 = dot_lfvector(fB, fB, numverts);
   delta_target = conjgrad_epsilon * conjgrad_epsilon * bnorm2;
 
+  /* Warm start: the caller leaves an initial guess in dV, which only applies to the free
+   * directions, the constrained ones are given by z. */
+  filter(ldV, S);
+  add_lfvector_lfvector(ldV, ldV, z, numverts);
+
   /* r = filter(B - A * dV) */
-  mul_bfmatrix_lfvector(AdV, lA, ldV);
+  mul_bfmatrix_lfvector(AdV, lA, ldV, adj, data->mul_temp);
   sub_lfvector_lfvector(r, lB, AdV, numverts);
   filter(r, S);
 
+  /* A guess with a larger residual than a zero guess (the velocity change flipped direction,
+   * e.g. after a collision) would only cost iterations, start from z instead. */
+  rnorm2 = dot_lfvector(r, r, numverts);
+  if (rnorm2 > bnorm2) {
+    cp_lfvector(ldV, z, numverts);
+    mul_bfmatrix_lfvector(AdV, lA, ldV, adj, data->mul_temp);
+    sub_lfvector_lfvector(r, lB, AdV, numverts);
+    filter(r, S);
+    rnorm2 = dot_lfvector(r, r, numverts);
+  }
+
   /* c = filter(P^-1 * r) */
-  cp_lfvector(c, r, numverts);
+  mul_block_jacobi_lfvector(c, Pinv, r);
   filter(c, S);
 
   /* delta = r^T * c */
@@ -871,8 +1089,8 @@ static int cg_filtered(lfVector *ldV,
   print_bfmatrix(S);
 #  endif
 
-  while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-    mul_bfmatrix_lfvector(q, lA, c);
+  while (rnorm2 > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
+    mul_bfmatrix_lfvector(q, lA, c, adj, data->mul_temp);
     filter(q, S);
 
     alpha = delta_new / dot_lfvector(c, q, numverts);
@@ -880,9 +1098,11 @@ static int cg_filtered(lfVector *ldV,
     add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
 
     add_lfvector_lfvectorS(r, r, q, -alpha, numverts);
+    rnorm2 = dot_lfvector(r, r, numverts);
 
     /* s = P^-1 * r */
-    cp_lfvector(s, r, numverts);
+    mul_block_jacobi_lfvector(s, Pinv, r);
+    filter(s, S);
     delta_old = delta_new;
     delta_new = dot_lfvector(r, s, numverts);
 
@@ -898,18 +1118,12 @@ static int cg_filtered(lfVector *ldV,
   printf("========\n");
 #  endif
 
-  del_lfvector(fB);
-  del_lfvector(AdV);
-  del_lfvector(r);
-  del_lfvector(c);
-  del_lfvector(q);
-  del_lfvector(s);
   // printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
   result->status = conjgrad_loopcount < conjgrad_looplimit ? SIM_SOLVER_SUCCESS :
                                                              SIM_SOLVER_NO_CONVERGENCE;
   result->iterations = conjgrad_loopcount;
-  result->error = bnorm2 > 0.0f ? sqrtf(delta_new / bnorm2) : 0.0f;
+  result->error = bnorm2 > 0.0f ? sqrtf(rnorm2 / bnorm2) : 0.0f;
 
   /* True means we reached desired accuracy in given time - ie stable. */
   return conjgrad_loopcount < conjgrad_looplimit;
@@ -1125,14 +1339,25 @@ bool SIM_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 {
   uint numverts = data->dFdV[0].vcount;
 
-  lfVector *dFdXmV = create_lfvector(numverts);
-  zero_lfvector(data->dV, numverts);
+  lfVector *dFdXmV = data->dFdXmV;
+
+  /* Initial guess, the previous velocity change scaled to the new step size.
+   * The acceleration changes little between sub-steps, so this is usually close. */
+  if (data->dt_prev > 0.0f) {
+    mul_lfvectorS(data->dV, data->dV_prev, dt / data->dt_prev, numverts);
+  }
+  else {
+    zero_lfvector(data->dV, numverts);
+  }
 
   cp_bfmatrix(data->A, data->M);
 
   subadd_bfmatrixS_bfmatrixS(data->A, data->dFdV, dt, data->dFdX, (dt * dt));
 
-  mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->V);
+  /* A and dFdX share the block layout of the springs added this step. */
+  update_bfmatrix_adjacency(data->adjacency, data->A);
+
+  mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->V, data->adjacency, data->mul_temp);
 
   add_lfvectorS_lfvectorS(data->B, data->F, dt, dFdXmV, (dt * dt), numverts);
 
@@ -1141,7 +1366,7 @@ bool SIM_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 #  endif
 
   /* Conjugate gradient algorithm to solve Ax=b. */
-  cg_filtered(data->dV, data->A, data->B, data->z, data->S, result);
+  cg_filtered(data, result);
 
   // cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
@@ -1150,11 +1375,18 @@ bool SIM_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
   printf("cg_filtered calc time: %f\n", float(end - start));
 #  endif
 
+  /* A solution that did not converge is a poor guess, the step is retried or discarded anyway. */
+  if (result->status == SIM_SOLVER_SUCCESS) {
+    cp_lfvector(data->dV_prev, data->dV, numverts);
+    data->dt_prev = dt;
+  }
+  else {
+    data->dt_prev = 0.0f;
+  }
+
   /* advance velocities */
   add_lfvector_lfvector(data->Vnew, data->V, data->dV, numverts);
 
-  del_lfvector(dFdXmV);
-
   return result->status == SIM_SOLVER_SUCCESS;
 }
 
@@ -1191,6 +1423,11 @@ void SIM_mass_spring_set_rest_transform(Implicit_Data *data, int index, float tf
 #  endif
 }
 
+void SIM_mass_spring_clear_warm_start(Implicit_Data *data)
+{
+  data->dt_prev = 0.0f;
+}
+
 void SIM_mass_spring_set_motion_state(Implicit_Data *data,
                                       int index,
                                       const float x[3],
@@ -593,6 +593,11 @@ void SIM_mass_spring_set_rest_transform(Implicit_Data *data, int index, float tf
 #  endif
 }
 
+void SIM_mass_spring_clear_warm_start(Implicit_Data * /*data*/)
+{
+  /* The Eigen solver always starts from zero. */
+}
+
 void SIM_mass_spring_set_motion_state(Implicit_Data *data,
                                       int index,
                                       const float x[3],
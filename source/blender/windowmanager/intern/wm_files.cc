@@ -859,6 +859,8 @@ static void wm_read_callback_post_wrapper(bContext *C, const char *filepath, con
 static void file_read_reports_finalize(BlendFileReadReport *bf_reports)
 {
   double duration_whole_minutes, duration_whole_seconds;
+  double duration_read_blocks_minutes, duration_read_blocks_seconds;
+  double duration_direct_link_minutes, duration_direct_link_seconds;
   double duration_libraries_minutes, duration_libraries_seconds;
   double duration_lib_override_minutes, duration_lib_override_seconds;
   double duration_lib_override_resync_minutes, duration_lib_override_resync_seconds;
@@ -871,6 +873,18 @@ static void file_read_reports_finalize(BlendFileReadReport *bf_reports)
                                   &duration_whole_minutes,
                                   &duration_whole_seconds,
                                   nullptr);
+  BLI_math_time_seconds_decompose(bf_reports->duration.read_blocks,
+                                  nullptr,
+                                  nullptr,
+                                  &duration_read_blocks_minutes,
+                                  &duration_read_blocks_seconds,
+                                  nullptr);
+  BLI_math_time_seconds_decompose(bf_reports->duration.direct_link,
+                                  nullptr,
+                                  nullptr,
+                                  &duration_direct_link_minutes,
+                                  &duration_direct_link_seconds,
+                                  nullptr);
   BLI_math_time_seconds_decompose(bf_reports->duration.libraries,
                                   nullptr,
                                   nullptr,
@@ -898,6 +912,18 @@ static void file_read_reports_finalize(BlendFileReadReport *bf_reports)
 
   CLOG_INFO(
       &LOG, 0, "Blender file read in %.0fm%.2fs", duration_whole_minutes, duration_whole_seconds);
+  CLOG_INFO(&LOG,
+            0,
+            " * Reading data-blocks: %.0fm%.2fs",
+            duration_read_blocks_minutes,
+            duration_read_blocks_seconds);
+  if (bf_reports->duration.direct_link > 0.0) {
+    CLOG_INFO(&LOG,
+              0,
+              " * Linking data-blocks in parallel: %.0fm%.2fs",
+              duration_direct_link_minutes,
+              duration_direct_link_seconds);
+  }
   CLOG_INFO(&LOG,
             0,
             " * Loading libraries: %.0fm%.2fs",
@@ -2002,6 +2028,7 @@ static bool wm_file_write(bContext *C,
   blend_write_params.remap_mode = remap_mode;
   blend_write_params.use_save_versions = true;
   blend_write_params.use_save_as_copy = use_save_as_copy;
+  blend_write_params.use_delta = USER_EXPERIMENTAL_TEST(&U, use_blend_delta_save);
   blend_write_params.thumb = thumb;
 
   const bool success = BLO_write_file(bmain, filepath, fileflags, &blend_write_params, reports);
@@ -54,8 +54,11 @@ class TestGraph:
                 chart_type = 'line' if entries[0].benchmark_type == 'time_series' else 'comparison'
 
                 for output in outputs:
+                    # Only some tests of a category may produce an output (e.g. point cache read time
+                    # in physics), leave the others out of its chart.
+                    output_entries = [entry for entry in entries if output in entry.output]
                     chart_name = f"{category} ({output})"
-                    data.append(self.chart(device_name, chart_name, entries, chart_type, output))
+                    data.append(self.chart(device_name, chart_name, output_entries, chart_type, output))
 
         self.json = json.dumps(data, indent=2)
 
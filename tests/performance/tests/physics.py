@@ -0,0 +1,185 @@
+# SPDX-FileCopyrightText: 2023 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+# Procedurally generated scenes, so no benchmark files are needed:
+# (type, objects, vertices per object, effectors).
+PHYSICS_TESTS = (
+    ('cloth', 1, 2500, 0),
+    ('cloth', 1, 10000, 0),
+    ('cloth', 8, 2500, 0),
+    ('cloth_collision', 1, 2500, 0),
+    ('cloth_collision', 4, 2500, 0),
+    ('cloth_effectors', 1, 2500, 4),
+    ('softbody', 1, 1000, 0),
+    ('softbody', 4, 1000, 0),
+    ('effectors', 1, 10000, 1),
+    ('effectors', 1, 10000, 16),
+    ('point_cache', 4, 2500, 0),
+)
+
+
+def _add_grid(bpy, name, vertices, location):
+    import math
+    subdivisions = max(2, int(math.sqrt(vertices)))
+    bpy.ops.mesh.primitive_grid_add(
+        x_subdivisions=subdivisions, y_subdivisions=subdivisions, size=2.0, location=location)
+    ob = bpy.context.object
+    ob.name = name
+    return ob
+
+
+def _add_effectors(bpy, effectors):
+    field_types = ('FORCE', 'WIND', 'VORTEX', 'TURBULENCE')
+    for i in range(effectors):
+        bpy.ops.object.effector_add(
+            type=field_types[i % len(field_types)], location=((i % 4) - 1.5, (i // 4) - 1.5, 2.0))
+        bpy.context.object.field.strength = 2.0
+
+
+def _build_scene(bpy, args):
+    bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = args['frames']
+
+    test_type = args['type']
+    objects = args['objects']
+    vertices = args['vertices']
+
+    simulated = []
+
+    if test_type == 'effectors':
+        # Particles are affected by every effector, each step is dominated by applying them.
+        bpy.ops.mesh.primitive_plane_add(size=2.0)
+        ob = bpy.context.object
+        bpy.ops.object.particle_system_add()
+        settings = ob.particle_systems[0].settings
+        settings.count = vertices
+        settings.frame_start = 1
+        settings.frame_end = 1
+        settings.lifetime = args['frames'] + 1
+        simulated.append((ob, ob.particle_systems[0].point_cache))
+    else:
+        for i in range(objects):
+            ob = _add_grid(bpy, f"Sim{i}", vertices, ((i % 4) * 2.5, (i // 4) * 2.5, 1.0 + i * 0.1))
+            if test_type == 'softbody':
+                modifier = ob.modifiers.new("Softbody", 'SOFT_BODY')
+                modifier.settings.use_goal = False
+            else:
+                modifier = ob.modifiers.new("Cloth", 'CLOTH')
+                modifier.collision_settings.use_self_collision = (test_type == 'cloth_collision')
+            simulated.append((ob, modifier.point_cache))
+
+        if test_type == 'cloth_collision':
+            for i in range(objects):
+                bpy.ops.mesh.primitive_uv_sphere_add(radius=0.7, location=((i % 4) * 2.5, (i // 4) * 2.5, 0.0))
+                bpy.context.object.modifiers.new("Collision", 'COLLISION')
+
+    _add_effectors(bpy, args['effectors'])
+
+    for _, point_cache in simulated:
+        point_cache.frame_start = 1
+        point_cache.frame_end = args['frames']
+
+    return scene, simulated
+
+
+def _cache_reset(simulated):
+    # Changing the cache settings marks the cache outdated, so the next frames are simulated again.
+    for _, point_cache in simulated:
+        point_cache.frame_start = point_cache.frame_start
+
+
+def _step_frames(scene):
+    import time
+    start_time = time.time()
+    for frame in range(scene.frame_start, scene.frame_end + 1):
+        scene.frame_set(frame)
+    return (time.time() - start_time) / (scene.frame_end + 1 - scene.frame_start)
+
+
+def _run(args):
+    import bpy
+    import time
+
+    scene, simulated = _build_scene(bpy, args)
+
+    # Evaluate once first, to avoid measuring depsgraph building and lazy initialization.
+    bpy.context.view_layer.update()
+
+    if args['type'] == 'point_cache':
+        import os
+        import tempfile
+
+        # Disk cache needs a saved file, bake and read the frames back from there.
+        with tempfile.TemporaryDirectory() as tempdir:
+            bpy.ops.wm.save_as_mainfile(filepath=os.path.join(tempdir, "physics.blend"))
+            for _, point_cache in simulated:
+                point_cache.use_disk_cache = True
+
+            start_time = time.time()
+            bpy.ops.ptcache.bake_all(bake=True)
+            frames = scene.frame_end + 1 - scene.frame_start
+            bake_time = (time.time() - start_time) / frames
+
+            read_time = _step_frames(scene)
+            bpy.ops.ptcache.free_bake_all()
+
+        return {'time': bake_time, 'read_time': read_time}
+
+    test_time_start = time.time()
+    measured_times = []
+
+    min_measurements = 3
+    max_measurements = 20
+    timeout = 20
+
+    while True:
+        scene.frame_set(scene.frame_start)
+        _cache_reset(simulated)
+
+        measured_times.append(_step_frames(scene))
+
+        if len(measured_times) >= min_measurements and test_time_start + timeout < time.time():
+            break
+        if len(measured_times) >= max_measurements:
+            break
+
+    # Time per simulated frame.
+    average_time = sum(measured_times) / len(measured_times)
+    result = {'time': average_time}
+    return result
+
+
+class PhysicsTest(api.Test):
+    def __init__(self, test_type, objects, vertices, effectors):
+        self.test_type = test_type
+        self.objects = objects
+        self.vertices = vertices
+        self.effectors = effectors
+
+    def name(self):
+        return f"{self.test_type}_{self.objects}ob_{self.vertices}v_{self.effectors}eff"
+
+    def category(self):
+        return "physics"
+
+    def run(self, env, device_id):
+        args = {
+            'type': self.test_type,
+            'objects': self.objects,
+            'vertices': self.vertices,
+            'effectors': self.effectors,
+            'frames': 25,
+        }
+
+        result, _ = env.run_in_blender(_run, args)
+
+        return result
+
+
+def generate(env):
+    return [PhysicsTest(*test) for test in PHYSICS_TESTS]